@@ -0,0 +1,71 @@
+#pragma once
+#include <Arduino.h>
+
+// Adafruit_GFX subset: primitives route through the same virtuals as the real
+// library (fillRect -> drawFastVLine, text -> pixels), so subclasses that hook
+// them see the same calls. Glyphs are drawn as solid 5x7 cells, which keeps
+// geometry and dirty tracking right without shipping a font.
+class Adafruit_GFX : public Print {
+public:
+  Adafruit_GFX(int16_t w, int16_t h) : w_(w), h_(h), rawW_(w), rawH_(h) {}
+
+  virtual void drawPixel(int16_t x, int16_t y, uint16_t c) = 0;
+  virtual void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t c) { for (int16_t i = 0; i < h; i++) drawPixel(x, y + i, c); }
+  virtual void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t c) { for (int16_t i = 0; i < w; i++) drawPixel(x + i, y, c); }
+  virtual void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t c) { for (int16_t i = x; i < x + w; i++) drawFastVLine(i, y, h, c); }
+  virtual void fillScreen(uint16_t c) { fillRect(0, 0, w_, h_, c); }
+  void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t c) {
+    drawFastHLine(x, y, w, c); drawFastHLine(x, y + h - 1, w, c);
+    drawFastVLine(x, y, h, c); drawFastVLine(x + w - 1, y, h, c);
+  }
+  void drawRGBBitmap(int16_t x, int16_t y, const uint16_t* bmp, int16_t w, int16_t h) {
+    for (int16_t j = 0; j < h; j++) for (int16_t i = 0; i < w; i++) drawPixel(x + i, y + j, bmp[j * w + i]);
+  }
+
+  void setRotation(uint8_t r) { rot_ = r & 3; w_ = (rot_ & 1) ? rawH_ : rawW_; h_ = (rot_ & 1) ? rawW_ : rawH_; }
+  void setCursor(int16_t x, int16_t y) { cx_ = x; cy_ = y; }
+  void setTextColor(uint16_t c) { fg_ = bg_ = c; }
+  void setTextColor(uint16_t c, uint16_t bg) { fg_ = c; bg_ = bg; }
+  void setTextSize(uint8_t s) { ts_ = s ? s : 1; }
+  void setTextWrap(bool w) { wrap_ = w; }
+  int16_t width() const { return w_; }
+  int16_t height() const { return h_; }
+  int16_t getCursorX() const { return cx_; }
+  int16_t getCursorY() const { return cy_; }
+  void getTextBounds(const char* s, int16_t x, int16_t y, int16_t* x1, int16_t* y1, uint16_t* w, uint16_t* h) {
+    *x1 = x; *y1 = y; *w = (uint16_t)(strlen(s) * 6 * ts_); *h = (uint16_t)(8 * ts_);
+  }
+
+  size_t write(uint8_t c) override {
+    if (c == '\n') { cx_ = 0; cy_ += 8 * ts_; return 1; }
+    if (c == '\r') return 1;
+    if (wrap_ && cx_ + 6 * ts_ > w_) { cx_ = 0; cy_ += 8 * ts_; }
+    if (bg_ != fg_) fillRect(cx_, cy_, 6 * ts_, 8 * ts_, bg_);
+    if (c != ' ') fillRect(cx_, cy_, 5 * ts_, 7 * ts_, fg_);
+    cx_ += 6 * ts_;
+    return 1;
+  }
+  using Print::write;
+
+protected:
+  int16_t  w_, h_, rawW_, rawH_;
+  uint8_t  rot_ = 0, ts_ = 1;
+  int16_t  cx_ = 0, cy_ = 0;
+  uint16_t fg_ = 0xFFFF, bg_ = 0xFFFF;
+  bool     wrap_ = true;
+};
+
+class GFXcanvas16 : public Adafruit_GFX {
+public:
+  GFXcanvas16(uint16_t w, uint16_t h) : Adafruit_GFX(w, h), buf_((uint16_t*)calloc((size_t)w * h, 2)) {}
+  ~GFXcanvas16() { free(buf_); }
+  uint16_t* getBuffer() const { return buf_; }
+
+  void drawPixel(int16_t x, int16_t y, uint16_t c) override { if (x >= 0 && y >= 0 && x < w_ && y < h_) buf_[y * w_ + x] = c; }
+  void fillScreen(uint16_t c) override { for (int32_t i = 0; i < (int32_t)w_ * h_; i++) buf_[i] = c; }
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t c) override { for (int16_t i = 0; i < h; i++) GFXcanvas16::drawPixel(x, y + i, c); }
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t c) override { for (int16_t i = 0; i < w; i++) GFXcanvas16::drawPixel(x + i, y, c); }
+
+private:
+  uint16_t* buf_;
+};
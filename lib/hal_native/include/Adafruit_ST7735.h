@@ -0,0 +1,28 @@
+#pragma once
+#include <Adafruit_GFX.h>
+#include <SPI.h>
+
+#define ST77XX_BLACK   0x0000
+#define ST77XX_WHITE   0xFFFF
+#define ST77XX_RED     0xF800
+#define ST77XX_GREEN   0x07E0
+#define ST77XX_BLUE    0x001F
+#define ST77XX_CYAN    0x07FF
+#define ST77XX_MAGENTA 0xF81F
+#define ST77XX_YELLOW  0xFFE0
+#define ST77XX_ORANGE  0xFC00
+#define INITR_BLACKTAB 0x02
+
+// Panel on the host: counts pushed pixels and charges SPI wire time
+// (16 bits per pixel at 40 MHz) so frame costs show up in virtual time.
+class Adafruit_ST7735 : public Adafruit_GFX {
+public:
+  Adafruit_ST7735(int8_t cs, int8_t dc, int8_t rst) : Adafruit_GFX(128, 160) { (void)cs; (void)dc; (void)rst; }
+  Adafruit_ST7735(SPIClass* spi, int8_t cs, int8_t dc, int8_t rst) : Adafruit_GFX(128, 160) { (void)spi; (void)cs; (void)dc; (void)rst; }
+  void initR(uint8_t) {}
+  void startWrite() {}
+  void endWrite() {}
+  void setAddrWindow(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+  void writePixels(uint16_t* colors, uint32_t len, bool block = true, bool bigEndian = false);
+  void drawPixel(int16_t x, int16_t y, uint16_t c) override;
+};
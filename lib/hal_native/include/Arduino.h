@@ -0,0 +1,198 @@
+#pragma once
+// ------- Arduino-ESP32 subset for the host build -------
+// GPIO, time and Serial are backed by the simulator (sim.h); the rest is the
+// smallest surface the firmware compiles against.
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+#include <esp_err.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <soc/gpio_reg.h>
+
+using std::min;
+using std::max;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT          0x01
+#define OUTPUT         0x03
+#define INPUT_PULLUP   0x05
+#define INPUT_PULLDOWN 0x09
+
+#define RISING  0x01
+#define FALLING 0x02
+#define CHANGE  0x03
+
+#define LED_BUILTIN 48
+
+#define DEC 10
+#define HEX 16
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define F(s) (s)
+
+typedef bool    boolean;
+typedef uint8_t byte;
+
+// ---- GPIO
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int  digitalRead(uint8_t pin);
+#define digitalPinToInterrupt(p) ((int)(p))
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode);
+void attachInterruptArg(uint8_t pin, void (*isr)(void*), void* arg, int mode);
+void detachInterrupt(uint8_t pin);
+
+// ---- LEDC (backlight, buzzer): accepted and ignored
+void     ledcAttachPin(uint8_t pin, uint8_t ch);
+double   ledcSetup(uint8_t ch, double freq, uint8_t bits);
+void     ledcWrite(uint8_t ch, uint32_t duty);
+double   ledcWriteTone(uint8_t ch, double freq);
+
+// ---- Time (32-bit like unsigned long on the ESP32, so wrap arithmetic matches)
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+// ---- Memory / CPU
+#define MALLOC_CAP_8BIT     (1 << 2)
+#define MALLOC_CAP_DMA      (1 << 3)
+#define MALLOC_CAP_SPIRAM   (1 << 10)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+void*    heap_caps_malloc(size_t n, uint32_t caps);
+void     heap_caps_free(void* p);
+void*    ps_malloc(size_t n);
+uint32_t getCpuFrequencyMhz();
+
+// ---- String (only what the firmware uses)
+class String {
+public:
+  String() {}
+  String(const char* c) : s_(c ? c : "") {}
+  String(const std::string& s) : s_(s) {}
+  String(char c) : s_(1, c) {}
+  String(int v, unsigned char base = 10) { fmt(base == 16 ? "%x" : "%d", v); }
+  String(unsigned v, unsigned char base = 10) { fmt(base == 16 ? "%x" : "%u", v); }
+  String(long v, unsigned char base = 10) { fmt(base == 16 ? "%lx" : "%ld", v); }
+  String(unsigned long v, unsigned char base = 10) { fmt(base == 16 ? "%lx" : "%lu", v); }
+  String(float v, unsigned char dec = 2) { fmt("%.*f", (int)dec, (double)v); }
+  String(double v, unsigned char dec = 2) { fmt("%.*f", (int)dec, v); }
+
+  const char* c_str() const { return s_.c_str(); }
+  unsigned length() const { return (unsigned)s_.size(); }
+  bool isEmpty() const { return s_.empty(); }
+  char operator[](unsigned i) const { return i < s_.size() ? s_[i] : 0; }
+  char charAt(unsigned i) const { return (*this)[i]; }
+
+  String& operator+=(const String& o) { s_ += o.s_; return *this; }
+  String& operator+=(const char* o) { s_ += o ? o : ""; return *this; }
+  String& operator+=(char c) { s_ += c; return *this; }
+  friend String operator+(const String& a, const String& b) { return String(a.s_ + b.s_); }
+  friend String operator+(const String& a, const char* b) { return String(a.s_ + (b ? b : "")); }
+  friend String operator+(const char* a, const String& b) { return String(std::string(a ? a : "") + b.s_); }
+  bool operator==(const String& o) const { return s_ == o.s_; }
+  bool operator==(const char* o) const { return s_ == (o ? o : ""); }
+  bool operator!=(const String& o) const { return s_ != o.s_; }
+
+  bool startsWith(const String& p) const { return s_.rfind(p.s_, 0) == 0; }
+  bool endsWith(const String& p) const { return s_.size() >= p.s_.size() && s_.compare(s_.size() - p.s_.size(), p.s_.size(), p.s_) == 0; }
+  int  indexOf(char c, unsigned from = 0) const { size_t p = s_.find(c, from); return p == std::string::npos ? -1 : (int)p; }
+  int  indexOf(const String& t, unsigned from = 0) const { size_t p = s_.find(t.s_, from); return p == std::string::npos ? -1 : (int)p; }
+  String substring(unsigned a, unsigned b = 0xffffffffu) const { return a >= s_.size() ? String() : String(s_.substr(a, b == 0xffffffffu ? std::string::npos : b - a)); }
+  void trim() {
+    size_t a = s_.find_first_not_of(" \t\r\n"), b = s_.find_last_not_of(" \t\r\n");
+    s_ = (a == std::string::npos) ? std::string() : s_.substr(a, b - a + 1);
+  }
+  long toInt() const { return atol(s_.c_str()); }
+  void toLowerCase() { for (auto& c : s_) c = (char)tolower((unsigned char)c); }
+
+private:
+  std::string s_;
+  void fmt(const char* f, ...) { char b[48]; va_list ap; va_start(ap, f); vsnprintf(b, sizeof(b), f, ap); va_end(ap); s_ = b; }
+};
+
+// glibc 2.38+ ships strlcpy itself
+#if !defined(__GLIBC__) || __GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38)
+size_t strlcpy(char* dst, const char* src, size_t n);
+#endif
+
+// ---- Print / Stream
+class IPAddress;
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* b, size_t n) { for (size_t i = 0; i < n; i++) write(b[i]); return n; }
+  size_t write(const char* s) { return s ? write((const uint8_t*)s, strlen(s)) : 0; }
+
+  size_t print(const char* s) { return write(s); }
+  size_t print(const String& s) { return write(s.c_str()); }
+  size_t print(char c) { return write((uint8_t)c); }
+  size_t print(int v, int base = DEC) { return print((long)v, base); }
+  size_t print(unsigned v, int base = DEC) { return print((unsigned long)v, base); }
+  size_t print(long v, int base = DEC) { return base == HEX ? printf("%lX", (unsigned long)v) : printf("%ld", v); }
+  size_t print(unsigned long v, int base = DEC) { return base == HEX ? printf("%lX", v) : printf("%lu", v); }
+  size_t print(double v, int dec = 2) { return printf("%.*f", dec, v); }
+  size_t print(const IPAddress& ip);
+
+  size_t println() { return write("\n"); }
+  template <typename T> size_t println(const T& v) { size_t n = print(v); return n + println(); }
+  template <typename T> size_t println(const T& v, int fmt) { size_t n = print(v, fmt); return n + println(); }
+
+  size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print {
+public:
+  virtual int  available() { return 0; }
+  virtual int  read() { return -1; }
+  virtual int  peek() { return -1; }
+  virtual void flush() {}
+  void   setTimeout(unsigned long) {}
+  size_t readBytes(uint8_t* b, size_t n) { size_t i = 0; for (; i < n; i++) { int c = read(); if (c < 0) break; b[i] = (uint8_t)c; } return i; }
+  String readStringUntil(char term) { String s; for (int c; (c = read()) >= 0 && c != term;) s += (char)c; return s; }
+};
+
+class IPAddress {
+public:
+  IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0) : o_{a, b, c, d} {}
+  String toString() const { char s[16]; snprintf(s, sizeof(s), "%u.%u.%u.%u", o_[0], o_[1], o_[2], o_[3]); return String(s); }
+private:
+  uint8_t o_[4];
+};
+inline size_t Print::print(const IPAddress& ip) { return print(ip.toString()); }
+
+class HardwareSerial : public Stream {
+public:
+  void begin(unsigned long) {}
+  size_t write(uint8_t c) override;
+  using Print::write;
+  operator bool() const { return true; }
+};
+extern HardwareSerial Serial;
+
+class EspClass {
+public:
+  uint32_t getCycleCount();
+  void     restart();
+  uint32_t getFreeHeap() { return 256 * 1024; }
+  uint32_t getCpuFreqMHz() { return getCpuFrequencyMhz(); }
+  uint32_t getSketchSize();   // length of sim::runningImage()
+  uint32_t getFreeSketchSpace() { return 0x700000; }
+  String   getSketchMD5() { return String(); }
+};
+extern EspClass ESP;
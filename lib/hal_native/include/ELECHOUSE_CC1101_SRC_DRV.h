@@ -0,0 +1,15 @@
+#pragma once
+#include <Arduino.h>
+
+// CC1101 register setup has no host equivalent; received RF reaches GDO0
+// through sim::rfSend().
+class ELECHOUSE_CC1101 {
+public:
+  void setSpiPin(uint8_t, uint8_t, uint8_t, uint8_t) {}
+  void Init() {}
+  void setMHZ(float) {}
+  void SetRx() {}
+  void setModulation(uint8_t) {}
+  bool getCC1101() { return true; }
+};
+extern ELECHOUSE_CC1101 ELECHOUSE_cc1101;
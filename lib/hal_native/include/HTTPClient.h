@@ -0,0 +1,43 @@
+#pragma once
+#include <WiFiClient.h>
+#include <string>
+#include <utility>
+#include <vector>
+
+#define HTTP_CODE_OK              200
+#define HTTP_CODE_PARTIAL_CONTENT 206
+#define HTTP_CODE_NOT_MODIFIED    304
+#define HTTP_CODE_NOT_FOUND       404
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_NOT_CONNECTED      (-4)
+
+typedef enum { HTTPC_DISABLE_FOLLOW_REDIRECTS, HTTPC_STRICT_FOLLOW_REDIRECTS, HTTPC_FORCE_FOLLOW_REDIRECTS } followRedirects_t;
+
+// Talks to the sim HTTP stand-in (sim::httpRoute). Redirects are resolved by
+// the stand-in, so the follow mode is accepted and ignored.
+class HTTPClient {
+public:
+  ~HTTPClient() { end(); }
+  bool   begin(WiFiClient& c, const String& url) { client_ = &c; url_ = url.c_str(); return true; }
+  bool   begin(const String& url) { client_ = &own_; url_ = url.c_str(); return true; }
+  void   end();
+  int    GET();
+  int    getSize() { return size_; }
+  String getString();
+  WiFiClient* getStreamPtr() { return client_; }
+  void   setFollowRedirects(followRedirects_t) {}
+  void   setTimeout(uint16_t) {}
+  void   setReuse(bool) {}
+  void   addHeader(const String& name, const String& value) { req_.emplace_back(name.c_str(), value.c_str()); }
+  void   collectHeaders(const char* [], size_t) {}   // every response header is kept
+  String header(const char* name);
+  bool   connected() { return client_ && client_->connected(); }
+  static String errorToString(int err) { return String(err == HTTPC_ERROR_NOT_CONNECTED ? "not connected" : "connection refused"); }
+
+private:
+  WiFiClient  own_;
+  WiFiClient* client_ = nullptr;
+  std::string url_;
+  int         size_ = -1;
+  std::vector<std::pair<std::string, std::string>> req_, resp_;
+};
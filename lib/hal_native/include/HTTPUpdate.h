@@ -0,0 +1,15 @@
+#pragma once
+#include <HTTPClient.h>
+
+enum HTTPUpdateResult { HTTP_UPDATE_FAILED, HTTP_UPDATE_NO_UPDATES, HTTP_UPDATE_OK };
+typedef HTTPUpdateResult t_httpUpdate_return;
+
+class HTTPUpdate {
+public:
+  void rebootOnUpdate(bool) {}
+  void setFollowRedirects(followRedirects_t) {}
+  void setLedPin(int, uint8_t = LOW) {}
+  t_httpUpdate_return update(WiFiClient&, const String&, const String& = "") { return HTTP_UPDATE_FAILED; }
+  int    getLastError() { return HTTPC_ERROR_CONNECTION_REFUSED; }
+  String getLastErrorString() { return String("no network on host"); }
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include <Arduino.h>
+
+// NVS stand-in: one in-memory store shared by every namespace handle for the
+// life of the process (sim::prefsClear() wipes it).
+class Preferences {
+public:
+  bool   begin(const char* ns, bool readOnly = false);
+  void   end() {}
+  bool   clear();
+  bool   remove(const char* key);
+  bool   isKey(const char* key);
+
+  uint32_t getULong(const char* key, uint32_t def = 0);
+  size_t   putULong(const char* key, uint32_t v);
+  uint8_t  getUChar(const char* key, uint8_t def = 0);
+  size_t   putUChar(const char* key, uint8_t v);
+  uint16_t getUShort(const char* key, uint16_t def = 0);
+  size_t   putUShort(const char* key, uint16_t v);
+  int32_t  getInt(const char* key, int32_t def = 0);
+  size_t   putInt(const char* key, int32_t v);
+  float    getFloat(const char* key, float def = 0);
+  size_t   putFloat(const char* key, float v);
+  bool     getBool(const char* key, bool def = false);
+  size_t   putBool(const char* key, bool v);
+  String   getString(const char* key, String def = String());
+  size_t   putString(const char* key, const String& v);
+  size_t   getBytesLength(const char* key);
+  size_t   getBytes(const char* key, void* buf, size_t n);
+  size_t   putBytes(const char* key, const void* buf, size_t n);
+
+private:
+  std::string ns_;
+  std::string k(const char* key) const { return ns_ + "/" + key; }
+  size_t      get(const char* key, void* buf, size_t n);
+  size_t      put(const char* key, const void* buf, size_t n);
+};
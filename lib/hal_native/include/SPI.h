@@ -0,0 +1,25 @@
+#pragma once
+#include <Arduino.h>
+
+#define FSPI 0
+#define HSPI 1
+#define MSBFIRST 1
+#define SPI_MODE0 0
+
+class SPISettings {
+public:
+  SPISettings() {}
+  SPISettings(uint32_t, uint8_t, uint8_t) {}
+};
+
+class SPIClass {
+public:
+  explicit SPIClass(uint8_t bus = FSPI) { (void)bus; }
+  void    begin(int8_t sck = -1, int8_t miso = -1, int8_t mosi = -1, int8_t ss = -1) { (void)sck; (void)miso; (void)mosi; (void)ss; }
+  void    end() {}
+  void    beginTransaction(SPISettings) {}
+  void    endTransaction() {}
+  uint8_t transfer(uint8_t) { return 0; }
+  void    writeBytes(const uint8_t*, uint32_t) {}
+};
+extern SPIClass SPI;
@@ -0,0 +1,42 @@
+#pragma once
+#include <Arduino.h>
+
+#define UPDATE_SIZE_UNKNOWN 0xFFFFFFFF
+#define U_FLASH 0
+
+#define UPDATE_ERROR_OK          0
+#define UPDATE_ERROR_WRITE       1
+#define UPDATE_ERROR_ERASE       2
+#define UPDATE_ERROR_SPACE       4
+#define UPDATE_ERROR_SIZE        5
+#define UPDATE_ERROR_MAGIC_BYTE  7
+#define UPDATE_ERROR_NO_PARTITION 10
+#define UPDATE_ERROR_BAD_ARGUMENT 11
+#define UPDATE_ERROR_ABORT       12
+
+// Arduino's Update over the sim app slot (sim::otaSlot): 4 KB write buffer,
+// 64 KB block erase ahead of the first write into each block, image magic
+// checked on the first sector and the boot switch on end().
+class UpdateClass {
+public:
+  bool        begin(size_t size = UPDATE_SIZE_UNKNOWN, int command = U_FLASH, int ledPin = -1, uint8_t ledOn = LOW,
+                    const char* label = nullptr);
+  size_t      write(uint8_t* data, size_t len);
+  bool        end(bool evenIfRemaining = false);
+  void        abort();
+  bool        hasError() { return err_ != UPDATE_ERROR_OK; }
+  uint8_t     getError() { return err_; }
+  const char* errorString();
+  bool        isRunning() { return size_ > 0; }
+  bool        isFinished() { return size_ > 0 && progress_ == size_; }
+  size_t      size() { return size_; }
+  size_t      progress() { return progress_; }
+  size_t      remaining() { return size_ - progress_; }
+
+private:
+  bool flushBuf();
+  uint8_t buf_[4096];
+  size_t  bufLen_ = 0, size_ = 0, progress_ = 0;
+  uint8_t err_ = UPDATE_ERROR_OK;
+};
+extern UpdateClass Update;
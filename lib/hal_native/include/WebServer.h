@@ -0,0 +1,11 @@
+#pragma once
+#include <Arduino.h>
+
+class WebServer {
+public:
+  explicit WebServer(int port = 80) { (void)port; }
+  void begin() {}
+  void handleClient() {}
+  void on(const char*, void (*)()) {}
+  void send(int, const char*, const String&) {}
+};
@@ -0,0 +1,21 @@
+#pragma once
+#include <Arduino.h>
+
+// Wi-Fi is associated exactly while the sim link is up (sim::wifiLink); scans come back empty.
+typedef enum { WL_IDLE_STATUS = 0, WL_NO_SSID_AVAIL = 1, WL_CONNECTED = 3, WL_CONNECT_FAILED = 4, WL_DISCONNECTED = 6 } wl_status_t;
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } wifi_mode_t;
+typedef enum { WIFI_AUTH_OPEN = 0, WIFI_AUTH_WEP, WIFI_AUTH_WPA_PSK, WIFI_AUTH_WPA2_PSK } wifi_auth_mode_t;
+
+class WiFiClass {
+public:
+  bool        mode(wifi_mode_t) { return true; }
+  wl_status_t begin(const char*, const char* = nullptr) { return status(); }
+  wl_status_t status();
+  bool        disconnect(bool = false, bool = false) { return true; }
+  int16_t     scanNetworks(bool = false, bool = false) { return 0; }
+  String      SSID(uint8_t = 0) { return String(); }
+  int32_t     RSSI(uint8_t = 0) { return 0; }
+  wifi_auth_mode_t encryptionType(uint8_t) { return WIFI_AUTH_OPEN; }
+  IPAddress   localIP() { return IPAddress(); }
+};
+extern WiFiClass WiFi;
@@ -0,0 +1,22 @@
+#pragma once
+#include <Arduino.h>
+
+struct SimConn;   // one HTTP response in flight on the sim link (sim_net.cpp)
+
+class WiFiClient : public Stream {
+public:
+  WiFiClient() {}
+  WiFiClient(const WiFiClient&) = delete;
+  WiFiClient& operator=(const WiFiClient&) = delete;
+  ~WiFiClient();
+  int     connect(const char*, uint16_t) { return 0; }
+  uint8_t connected();
+  void    stop();
+  int     available() override;
+  int     read() override;
+  int     read(uint8_t* b, size_t n);
+  size_t  write(uint8_t) override { return 0; }
+  using Print::write;
+
+  SimConn* conn_ = nullptr;
+};
@@ -0,0 +1,28 @@
+#pragma once
+#include <Arduino.h>
+
+// I2C master on the simulated bus: transactions reach sim::I2cDevice models
+// and cost their 400 kHz wire time in virtual microseconds.
+class TwoWire : public Stream {
+public:
+  bool    begin(int sda = -1, int scl = -1, uint32_t freq = 100000);
+  void    setClock(uint32_t freq) { freq_ = freq; }
+  void    beginTransmission(uint8_t addr);
+  void    beginTransmission(int addr) { beginTransmission((uint8_t)addr); }
+  uint8_t endTransmission(bool sendStop = true);
+  uint8_t requestFrom(int addr, int n, bool sendStop = true);
+  size_t  write(uint8_t c) override;
+  using Print::write;
+  int     available() override { return (int)(rxLen_ - rxPos_); }
+  int     read() override { return rxPos_ < rxLen_ ? rx_[rxPos_++] : -1; }
+  int     peek() override { return rxPos_ < rxLen_ ? rx_[rxPos_] : -1; }
+
+private:
+  uint32_t freq_ = 100000;
+  uint8_t  addr_ = 0;
+  uint8_t  tx_[32], txLen_ = 0;
+  uint8_t  rx_[32], rxLen_ = 0, rxPos_ = 0;
+  bool     open_ = false;
+  uint32_t byteUs(size_t n) const { return (uint32_t)((n * 9u * 1000000u + freq_ - 1) / freq_); }
+};
+extern TwoWire Wire;
@@ -0,0 +1,9 @@
+#pragma once
+#include <esp_partition.h>
+
+#define ESP_ERR_OTA_BASE            0x1500
+#define ESP_ERR_OTA_VALIDATE_FAILED (ESP_ERR_OTA_BASE + 0x03)
+
+const esp_partition_t* esp_ota_get_running_partition(void);
+const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t* start_from);
+esp_err_t              esp_ota_set_boot_partition(const esp_partition_t* partition);   // checks the image magic
@@ -0,0 +1,18 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+
+// App slots only: the running one reads back sim::runningImage(), the next
+// one is the inactive slot behind sim::otaSlot(). Erase keeps the flash busy
+// (the caller sleeps, other tasks run, as with yield-during-erase); writes
+// are charged to the caller as CPU time.
+typedef struct {
+  uint32_t    address;
+  uint32_t    size;
+  const char* label;
+} esp_partition_t;
+
+esp_err_t esp_partition_read(const esp_partition_t* partition, size_t src_offset, void* dst, size_t size);
+esp_err_t esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size);
+esp_err_t esp_partition_write(const esp_partition_t* partition, size_t dst_offset, const void* src, size_t size);
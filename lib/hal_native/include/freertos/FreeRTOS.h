@@ -0,0 +1,31 @@
+#pragma once
+#include <stdint.h>
+
+// ------- FreeRTOS subset for the host build (scheduler lives in sim_rtos.cpp) -------
+typedef int          BaseType_t;
+typedef unsigned     UBaseType_t;
+typedef uint32_t     TickType_t;
+
+#define pdTRUE            1
+#define pdFALSE           0
+#define pdPASS            1
+#define pdFAIL            0
+#define portMAX_DELAY     0xffffffffu
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define configMAX_PRIORITIES 25
+#define tskNO_AFFINITY    0x7fffffff
+
+void halYieldFromIsr(BaseType_t woke);
+#define portYIELD_FROM_ISR(...) halYieldFromIsr(__VA_ARGS__ + 0)
+
+// One task holds the CPU at a time, so a critical section only has to keep
+// the simulator from switching tasks inside it.
+typedef struct { int depth; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+void halEnterCritical();
+void halExitCritical();
+#define portENTER_CRITICAL(m)     ((void)(m), halEnterCritical())
+#define portEXIT_CRITICAL(m)      ((void)(m), halExitCritical())
+#define portENTER_CRITICAL_ISR(m) ((void)(m), halEnterCritical())
+#define portEXIT_CRITICAL_ISR(m)  ((void)(m), halExitCritical())
@@ -0,0 +1,10 @@
+#pragma once
+#include "queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateBinary();
+SemaphoreHandle_t xSemaphoreCreateMutex();
+#define xSemaphoreTake(s, ticks)       xQueueReceive((s), nullptr, (ticks))
+#define xSemaphoreGive(s)              xQueueSend((s), nullptr, 0)
+#define xSemaphoreGiveFromISR(s, woke) xQueueSendFromISR((s), nullptr, (woke))
@@ -0,0 +1,25 @@
+#pragma once
+#include "FreeRTOS.h"
+
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+typedef enum { eNoAction = 0, eSetBits, eIncrement, eSetValueWithOverwrite, eSetValueWithoutOverwrite } eNotifyAction;
+
+BaseType_t   xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack, void* arg,
+                                     UBaseType_t prio, TaskHandle_t* out, BaseType_t core);
+void         vTaskDelete(TaskHandle_t t);
+void         vTaskDelay(TickType_t ticks);
+void         vTaskDelayUntil(TickType_t* prevWake, TickType_t increment);
+TickType_t   xTaskGetTickCount();
+TaskHandle_t xTaskGetCurrentTaskHandle();
+BaseType_t   xPortGetCoreID();
+UBaseType_t  uxTaskGetStackHighWaterMark(TaskHandle_t t);
+void         taskYIELD();
+
+BaseType_t xTaskNotify(TaskHandle_t t, uint32_t value, eNotifyAction action);
+BaseType_t xTaskNotifyFromISR(TaskHandle_t t, uint32_t value, eNotifyAction action, BaseType_t* woke);
+BaseType_t xTaskNotifyGive(TaskHandle_t t);
+void       vTaskNotifyGiveFromISR(TaskHandle_t t, BaseType_t* woke);
+uint32_t   ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks);
+BaseType_t xTaskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t* value, TickType_t ticks);
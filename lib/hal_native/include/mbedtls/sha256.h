@@ -0,0 +1,17 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// mbedTLS SHA-256 as the ESP32-S3 build has it: on the SHA accelerator. The
+// sim computes the digest on the host and charges the engine's time per block.
+typedef struct {
+  uint32_t state[8];
+  uint8_t  buffer[64];
+  uint64_t total;
+} mbedtls_sha256_context;
+
+void mbedtls_sha256_init(mbedtls_sha256_context* ctx);
+void mbedtls_sha256_free(mbedtls_sha256_context* ctx);
+int  mbedtls_sha256_starts(mbedtls_sha256_context* ctx, int is224);
+int  mbedtls_sha256_update(mbedtls_sha256_context* ctx, const unsigned char* input, size_t ilen);
+int  mbedtls_sha256_finish(mbedtls_sha256_context* ctx, unsigned char output[32]);
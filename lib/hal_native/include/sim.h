@@ -0,0 +1,103 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ------- Host simulator behind the native HAL -------
+// Virtual time only moves when every task is blocked (it jumps to the next
+// wake-up or device event) or when a HAL call charges for itself (an I2C
+// transaction, a micros() read). FreeRTOS tasks are real threads, but exactly
+// one holds the CPU at a time and the switch points are deterministic, so a
+// test run replays identically on any machine.
+//
+// Devices hang off the same HAL the firmware uses: relay loads behind the
+// GPIO outputs, INA226 register models on Wire with their ALERT pins wired,
+// and a CC1101 that plays pulse trains onto GDO0. Wi-Fi is one link with a
+// fixed rate and round trip to an HTTP stand-in server, and Update writes
+// into a modelled inactive app slot.
+namespace sim {
+
+// ---- Time and events
+uint64_t nowUs();
+void     spend(uint32_t us);                               // charge the running task
+void     at(uint64_t tUs, std::function<void()> fn);       // device event ("interrupt context")
+void     after(uint32_t us, std::function<void()> fn);
+
+// ---- GPIO as seen from outside the MCU
+void     setPin(int pin, int level);    // drive an input; fires the attached ISR on a matching edge
+int      pinOut(int pin);               // level the MCU drives
+uint64_t pinOutChangedUs(int pin);
+
+// ---- Preemption guard for multi-call HAL sequences (an open I2C transaction)
+void holdPreempt();
+void releasePreempt();
+
+// ---- I2C bus
+struct I2cDevice {
+  virtual ~I2cDevice() {}
+  virtual void write(const uint8_t* b, size_t n) = 0;
+  virtual void read(uint8_t* b, size_t n) = 0;
+};
+void attachI2c(uint8_t addr, I2cDevice* dev);
+I2cDevice* i2cDevice(uint8_t addr);
+
+// ---- Loads behind relay outputs and the battery feeding them
+enum LoadKind : uint8_t { LOAD_OPEN, LOAD_LAMP, LOAD_SHORT };
+struct Load {
+  LoadKind kind;
+  float    steadyA;   // lamp: settled draw; short: fault current
+  float    peakA;     // lamp: cold-filament inrush
+  uint32_t tauUs;     // lamp: inrush decay time constant
+};
+void  setLoad(int relayPin, const Load& l);
+void  clearLoads();
+void  setSupply(float volts, float ohms = 0.02f);
+float loadCurrentA();   // now, from the relay outputs
+float supplyV();        // now, sagged by the load
+
+// ---- INA226 register model on the bus
+enum InaRole : uint8_t { INA_LOAD, INA_SOURCE };
+void addIna226(uint8_t addr, float shuntOhms, int alertPin, InaRole role);
+
+// ---- CC1101 GDO0: pulse widths starting at firstLevel, idle low afterwards
+void rfSend(int pin, const uint16_t* us, size_t n, uint8_t firstLevel, uint32_t delayUs = 0);
+// rc-switch protocol 1 (PT2262/EV1527): [bits][sync] x repeats
+void rfSendPt2262(int pin, uint32_t code, uint8_t bits, uint16_t unitUs, uint8_t repeats, uint32_t delayUs = 0);
+
+// ---- Wi-Fi link and the HTTP stand-in server behind it
+// Response bodies trickle in at the link rate after one round trip; the
+// firmware sees them through HTTPClient/WiFiClient as it would over TLS.
+struct HttpRequest {
+  std::string url;
+  std::vector<std::pair<std::string, std::string>> headers;   // as added by the firmware
+  std::string header(const char* name) const;                 // case-insensitive, "" if absent
+};
+struct HttpResponse {
+  int         status = 200;
+  std::string body;
+  std::vector<std::pair<std::string, std::string>> headers;
+};
+using HttpHandler = std::function<HttpResponse(const HttpRequest&)>;
+void     wifiLink(bool up, uint32_t bytesPerSec = 100000, uint32_t rttUs = 40000);
+void     httpRoute(const std::string& url, HttpHandler h);
+void     httpServe(const std::string& url, const std::string& body, int status = 200);
+void     httpClearRoutes();
+uint32_t httpRequests();     // GETs that reached a route (or 404'd)
+uint64_t httpBodyBytes();    // body bytes the firmware actually read
+
+// ---- Inactive app slot behind Update (erased and programmed in flash time)
+const std::vector<uint8_t>& otaSlot();   // bytes programmed since the last begin() / erase at 0
+bool otaBootSwitched();                  // Update.end() accepted the image
+void otaReset();
+// Running slot: what ESP.getSketchSize() and esp_partition_read() see (empty by default)
+void runningImage(const std::vector<uint8_t>& img);
+
+// ---- Misc
+void prefsClear();
+void setQuiet(bool quiet);   // drop Serial output
+uint32_t tftPixelsPushed();
+
+}  // namespace sim
@@ -0,0 +1,17 @@
+#pragma once
+#include <stdint.h>
+
+// ESP32-S3 GPIO register addresses; REG_* go through the simulated pin bank.
+#define GPIO_OUT_REG       0x60004004u
+#define GPIO_OUT_W1TS_REG  0x60004008u
+#define GPIO_OUT_W1TC_REG  0x6000400Cu
+#define GPIO_OUT1_REG      0x60004010u
+#define GPIO_OUT1_W1TS_REG 0x60004014u
+#define GPIO_OUT1_W1TC_REG 0x60004018u
+#define GPIO_IN_REG        0x6000403Cu
+#define GPIO_IN1_REG       0x60004040u
+
+uint32_t halRegRead(uint32_t reg);
+void     halRegWrite(uint32_t reg, uint32_t v);
+#define REG_READ(r)     halRegRead((uint32_t)(r))
+#define REG_WRITE(r, v) halRegWrite((uint32_t)(r), (uint32_t)(v))
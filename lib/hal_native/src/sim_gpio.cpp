@@ -0,0 +1,218 @@
+// Pin bank, GPIO registers, Arduino time/Serial and the small CPU services.
+#include <Arduino.h>
+#include <sim.h>
+#include "sim_internal.h"
+
+namespace {
+
+constexpr int PIN_COUNT = 49;
+
+struct Pin {
+  uint8_t  mode   = 0;
+  uint8_t  out    = 0;
+  uint8_t  in     = 0;
+  bool     driven = false;   // something outside the MCU sets 'in'
+  uint64_t outChangedUs = 0;
+  int      edge   = 0;
+  void   (*isr)() = nullptr;
+  void   (*isrArg)(void*) = nullptr;
+  void*    arg    = nullptr;
+};
+
+Pin  pins[PIN_COUNT];
+bool quiet = false;
+
+bool valid(int p) { return p >= 0 && p < PIN_COUNT; }
+
+int level(const Pin& p) { return p.mode == OUTPUT ? p.out : p.in; }
+
+void setOut(int pin, int v) {
+  Pin& p = pins[pin];
+  v = v ? 1 : 0;
+  if (p.out == v) return;
+  p.out = (uint8_t)v;
+  p.outChangedUs = sim::nowUs();
+}
+
+uint32_t bankBits(int base, bool outputs) {
+  uint32_t v = 0;
+  for (int i = 0; i < 32 && base + i < PIN_COUNT; i++)
+    if (outputs ? pins[base + i].out : level(pins[base + i])) v |= 1u << i;
+  return v;
+}
+
+void writeBank(int base, uint32_t mask, int v) {
+  for (int i = 0; i < 32 && base + i < PIN_COUNT; i++)
+    if (mask & (1u << i)) setOut(base + i, v);
+}
+
+}  // namespace
+
+// ------------------- sim:: pins -------------------
+namespace sim {
+
+void setPin(int pin, int lvl) {
+  if (!valid(pin)) return;
+  Pin& p = pins[pin];
+  p.driven = true;
+  int old = p.in;
+  p.in = lvl ? 1 : 0;
+  if (old == p.in || !(p.isr || p.isrArg)) return;
+  bool rising = p.in;
+  if (!((p.edge & RISING) && rising) && !((p.edge & FALLING) && !rising)) return;
+  halIrqEnter();
+  if (p.isr) p.isr();
+  else p.isrArg(p.arg);
+  halIrqExit();
+}
+
+int      pinOut(int pin) { return valid(pin) ? pins[pin].out : 0; }
+uint64_t pinOutChangedUs(int pin) { return valid(pin) ? pins[pin].outChangedUs : 0; }
+void     setQuiet(bool q) { quiet = q; }
+
+}  // namespace sim
+
+// ------------------- GPIO -------------------
+void pinMode(uint8_t pin, uint8_t mode) {
+  if (!valid(pin)) return;
+  Pin& p = pins[pin];
+  p.mode = mode;
+  if (!p.driven) p.in = (mode == INPUT_PULLUP) ? 1 : 0;
+}
+
+void digitalWrite(uint8_t pin, uint8_t val) {
+  sim::spend(1);
+  if (valid(pin)) setOut(pin, val);
+}
+
+int digitalRead(uint8_t pin) {
+  sim::spend(1);
+  return valid(pin) ? level(pins[pin]) : 0;
+}
+
+void attachInterrupt(uint8_t pin, void (*isr)(void), int mode) {
+  if (!valid(pin)) return;
+  pins[pin].isr = isr; pins[pin].isrArg = nullptr; pins[pin].edge = mode;
+}
+
+void attachInterruptArg(uint8_t pin, void (*isr)(void*), void* arg, int mode) {
+  if (!valid(pin)) return;
+  pins[pin].isr = nullptr; pins[pin].isrArg = isr; pins[pin].arg = arg; pins[pin].edge = mode;
+}
+
+void detachInterrupt(uint8_t pin) {
+  if (!valid(pin)) return;
+  pins[pin].isr = nullptr; pins[pin].isrArg = nullptr; pins[pin].edge = 0;
+}
+
+uint32_t halRegRead(uint32_t reg) {
+  switch (reg) {
+    case GPIO_OUT_REG:  return bankBits(0, true);
+    case GPIO_OUT1_REG: return bankBits(32, true);
+    case GPIO_IN_REG:   return bankBits(0, false);
+    case GPIO_IN1_REG:  return bankBits(32, false);
+  }
+  return 0;
+}
+
+void halRegWrite(uint32_t reg, uint32_t v) {
+  switch (reg) {
+    case GPIO_OUT_W1TS_REG:  writeBank(0, v, 1); break;
+    case GPIO_OUT_W1TC_REG:  writeBank(0, v, 0); break;
+    case GPIO_OUT1_W1TS_REG: writeBank(32, v, 1); break;
+    case GPIO_OUT1_W1TC_REG: writeBank(32, v, 0); break;
+    case GPIO_OUT_REG:  writeBank(0, v, 1); writeBank(0, ~v, 0); break;
+    case GPIO_OUT1_REG: writeBank(32, v, 1); writeBank(32, ~v, 0); break;
+  }
+}
+
+void   ledcAttachPin(uint8_t, uint8_t) {}
+double ledcSetup(uint8_t, double freq, uint8_t) { return freq; }
+void   ledcWrite(uint8_t, uint32_t) {}
+double ledcWriteTone(uint8_t, double freq) { return freq; }
+
+// ------------------- Time -------------------
+uint32_t millis() {
+  sim::spend(1);
+  return (uint32_t)(sim::nowUs() / 1000u);
+}
+
+uint32_t micros() {
+  sim::spend(1);
+  return (uint32_t)sim::nowUs();
+}
+
+void delay(uint32_t ms) { vTaskDelay(pdMS_TO_TICKS(ms)); }
+void delayMicroseconds(uint32_t us) { sim::spend(us); }
+void yield() { taskYIELD(); }
+
+// ------------------- Memory / CPU -------------------
+void*    heap_caps_malloc(size_t n, uint32_t) { return malloc(n); }
+void     heap_caps_free(void* p) { free(p); }
+void*    ps_malloc(size_t n) { return malloc(n); }
+uint32_t getCpuFrequencyMhz() { return 240; }
+
+uint32_t EspClass::getCycleCount() { return (uint32_t)(sim::nowUs() * 240u); }
+void EspClass::restart() {
+  fprintf(stderr, "sim: ESP.restart() at %llu us\n", (unsigned long long)sim::nowUs());
+  exit(2);
+}
+
+const char* esp_err_to_name(esp_err_t err) {
+  switch (err) {
+    case ESP_OK:                return "ESP_OK";
+    case ESP_FAIL:              return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:   return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:  return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:     return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED: return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:       return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_INVALID_RESPONSE: return "ESP_ERR_INVALID_RESPONSE";
+    case ESP_ERR_INVALID_CRC:   return "ESP_ERR_INVALID_CRC";
+    case ESP_ERR_INVALID_VERSION: return "ESP_ERR_INVALID_VERSION";
+  }
+  return "UNKNOWN ERROR";
+}
+
+// ------------------- Serial / Print -------------------
+HardwareSerial Serial;
+EspClass       ESP;
+
+size_t HardwareSerial::write(uint8_t c) {
+  if (!quiet) fputc(c, stdout);
+  return 1;
+}
+
+size_t Print::printf(const char* fmt, ...) {
+  char buf[256];
+  va_list ap, ap2;
+  va_start(ap, fmt);
+  va_copy(ap2, ap);
+  int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  if (n < 0) { va_end(ap2); return 0; }
+  size_t r;
+  if ((size_t)n < sizeof(buf)) {
+    r = write((const uint8_t*)buf, (size_t)n);
+  } else {   // long line: format again into the heap, like the ESP32 core
+    std::string big((size_t)n + 1, '\0');
+    vsnprintf(&big[0], big.size(), fmt, ap2);
+    r = write((const uint8_t*)big.data(), (size_t)n);
+  }
+  va_end(ap2);
+  return r;
+}
+
+#if !defined(__GLIBC__) || __GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38)
+size_t strlcpy(char* dst, const char* src, size_t n) {
+  size_t len = strlen(src);
+  if (n) {
+    size_t c = len < n - 1 ? len : n - 1;
+    memcpy(dst, src, c);
+    dst[c] = 0;
+  }
+  return len;
+}
+#endif
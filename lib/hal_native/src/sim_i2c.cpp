@@ -0,0 +1,268 @@
+// I2C master, INA226 register models, relay loads / battery, CC1101 GDO0 playback.
+#include <Arduino.h>
+#include <Wire.h>
+#include <sim.h>
+#include "sim_internal.h"
+#include <vector>
+
+TwoWire Wire;
+
+namespace {
+
+constexpr uint32_t I2C_SETUP_US = 10;   // start/stop and driver overhead per transaction
+
+sim::I2cDevice* bus[128];
+
+struct Channel {
+  int       pin;
+  sim::Load load;
+};
+std::vector<Channel> loads;
+float supplyVolts = 18.0f, supplyOhms = 0.02f;
+
+float channelA(const Channel& c, uint64_t t) {
+  if (!sim::pinOut(c.pin)) return 0;
+  uint64_t on = sim::pinOutChangedUs(c.pin);
+  if (t < on) return 0;
+  switch (c.load.kind) {
+    case sim::LOAD_LAMP: {
+      float dt = (float)(t - on);
+      return c.load.steadyA + (c.load.peakA - c.load.steadyA) * expf(-dt / (float)(c.load.tauUs ? c.load.tauUs : 1));
+    }
+    case sim::LOAD_SHORT: return c.load.steadyA;
+    case sim::LOAD_OPEN:  return 0;
+  }
+  return 0;
+}
+
+// ---- INA226: register file + continuous conversions on the virtual clock
+class Ina226 : public sim::I2cDevice {
+public:
+  // Both roles see the same plant: the source sensor sits in series ahead of
+  // the load sensor, so only which registers the firmware reads differs.
+  Ina226(float shuntOhms, int alertPin) : shunt_(shuntOhms), alertPin_(alertPin) {
+    reset();
+  }
+
+  void write(const uint8_t* b, size_t n) override {
+    if (!n) return;
+    ptr_ = b[0];
+    if (n >= 3) writeReg(ptr_, (uint16_t)((b[1] << 8) | b[2]));
+  }
+
+  void read(uint8_t* b, size_t n) override {
+    uint16_t v = readReg(ptr_);
+    if (n > 0) b[0] = (uint8_t)(v >> 8);
+    if (n > 1) b[1] = (uint8_t)v;
+    for (size_t i = 2; i < n; i++) b[i] = 0xFF;
+  }
+
+private:
+  float        shunt_;
+  int          alertPin_;
+  uint8_t  ptr_ = 0;
+  uint16_t cfg_, cal_, me_, lim_, bus_, pwr_;
+  int16_t  vsh_, cur_;
+  bool     cvrf_, cnvrPending_, latched_;
+  uint64_t gen_ = 0;
+
+  void reset() {
+    cfg_ = 0x4127; cal_ = 0; me_ = 0; lim_ = 0; bus_ = 0; pwr_ = 0; vsh_ = 0; cur_ = 0;
+    cvrf_ = cnvrPending_ = latched_ = false;
+    restart();
+    updateAlert();
+  }
+
+  void writeReg(uint8_t r, uint16_t v) {
+    switch (r) {
+      case 0x00:
+        if (v & 0x8000) { reset(); return; }
+        cfg_ = v;
+        restart();
+        break;
+      case 0x05: cal_ = v & 0x7FFF; break;
+      case 0x06: me_ = v & 0xFC03; latched_ = false; updateAlert(); break;
+      case 0x07: lim_ = v; updateAlert(); break;
+    }
+  }
+
+  uint16_t readReg(uint8_t r) {
+    switch (r) {
+      case 0x00: return cfg_;
+      case 0x01: return (uint16_t)vsh_;
+      case 0x02: return bus_;
+      case 0x03: return pwr_;
+      case 0x04: return (uint16_t)cur_;
+      case 0x05: return cal_;
+      case 0x06: {
+        uint16_t v = me_ | (alertActive() ? 0x10 : 0) | (cvrf_ ? 0x08 : 0);
+        cvrf_ = false;          // reading Mask/Enable clears CVRF, a CNVR alert and the latch
+        cnvrPending_ = false;
+        latched_ = false;
+        updateAlert();
+        return v;
+      }
+      case 0x07: return lim_;
+      case 0xFE: return 0x5449;
+      case 0xFF: return 0x2260;
+    }
+    return 0xFFFF;
+  }
+
+  uint32_t periodUs() const {
+    static const uint16_t CT_US[8] = {140, 204, 332, 588, 1100, 2116, 4156, 8244};
+    static const uint16_t AVG_N[8] = {1, 4, 16, 64, 128, 256, 512, 1024};
+    uint8_t mode = cfg_ & 7;
+    uint32_t one = ((mode & 2) ? CT_US[(cfg_ >> 6) & 7] : 0) + ((mode & 1) ? CT_US[(cfg_ >> 3) & 7] : 0);
+    return one * AVG_N[(cfg_ >> 9) & 7];
+  }
+
+  // A config write aborts the conversion in flight; continuous modes restart
+  void restart() {
+    gen_++;
+    if ((cfg_ & 7) >= 5) schedule();
+  }
+
+  void schedule() {
+    uint64_t g = gen_, start = sim::nowUs();
+    sim::after(periodUs(), [this, g, start] {
+      if (g != gen_) return;
+      complete(start);
+      schedule();
+    });
+  }
+
+  void complete(uint64_t start) {
+    uint8_t mode = cfg_ & 7;
+    uint64_t end = sim::nowUs();
+    if (mode & 1) {
+      float a = 0;
+      for (int i = 1; i <= 8; i++) a += halLoadCurrentAt(start + (end - start) * i / 8);
+      a /= 8;
+      long raw = lroundf(a * shunt_ / 0.0000025f);
+      vsh_ = (int16_t)std::max(-32768L, std::min(32767L, raw));
+      cur_ = (int16_t)std::max(-32768L, std::min(32767L, (long)vsh_ * cal_ / 2048));
+    }
+    if (mode & 2) {
+      long raw = lroundf(sim::supplyV() / 0.00125f);
+      bus_ = (uint16_t)std::max(0L, std::min(0x7FFFL, raw));
+    }
+    pwr_ = (uint16_t)std::min(0xFFFFL, (long)abs(cur_) * bus_ / 20000);
+    cvrf_ = true;
+    if (me_ & 0x0400) cnvrPending_ = true;
+    updateAlert();
+  }
+
+  bool alertActive() const {
+    // The limit register is two's complement like the shunt register it is compared with
+    bool sol = (me_ & 0x8000) && vsh_ > (int16_t)lim_;
+    bool sul = (me_ & 0x4000) && vsh_ < (int16_t)lim_;
+    return sol || sul || cnvrPending_;
+  }
+
+  void updateAlert() {
+    bool active = alertActive();
+    if ((me_ & 0x0001) && active) latched_ = true;   // LEN
+    active = active || latched_;
+    bool activeHigh = me_ & 0x0002;                   // APOL
+    sim::setPin(alertPin_, active == activeHigh ? 1 : 0);
+  }
+};
+
+}  // namespace
+
+float halLoadCurrentAt(uint64_t t) {
+  float a = 0;
+  for (const Channel& c : loads) a += channelA(c, t);
+  return a;
+}
+
+// ------------------- TwoWire -------------------
+bool TwoWire::begin(int, int, uint32_t freq) {
+  if (freq) freq_ = freq;
+  return true;
+}
+
+void TwoWire::beginTransmission(uint8_t addr) {
+  if (!open_) { sim::holdPreempt(); open_ = true; }
+  addr_ = addr;
+  txLen_ = 0;
+}
+
+size_t TwoWire::write(uint8_t c) {
+  if (txLen_ >= sizeof(tx_)) return 0;
+  tx_[txLen_++] = c;
+  return 1;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop) {
+  sim::I2cDevice* d = bus[addr_ & 0x7F];
+  sim::spend(byteUs(1 + txLen_) + I2C_SETUP_US);
+  if (d) d->write(tx_, txLen_);
+  if (sendStop && open_) { open_ = false; sim::releasePreempt(); }
+  return d ? 0 : 2;   // 2 = NACK on address
+}
+
+uint8_t TwoWire::requestFrom(int addr, int n, bool) {
+  sim::I2cDevice* d = bus[addr & 0x7F];
+  n = std::min(n, (int)sizeof(rx_));
+  sim::spend(byteUs(1 + n) + I2C_SETUP_US);
+  rxPos_ = 0;
+  rxLen_ = 0;
+  if (d) { d->read(rx_, n); rxLen_ = (uint8_t)n; }
+  if (open_) { open_ = false; sim::releasePreempt(); }
+  return rxLen_;
+}
+
+// ------------------- sim:: devices -------------------
+namespace sim {
+
+void attachI2c(uint8_t addr, I2cDevice* dev) { bus[addr & 0x7F] = dev; }
+I2cDevice* i2cDevice(uint8_t addr) { return bus[addr & 0x7F]; }
+
+void addIna226(uint8_t addr, float shuntOhms, int alertPin, InaRole) {
+  attachI2c(addr, new Ina226(shuntOhms, alertPin));
+}
+
+void setLoad(int relayPin, const Load& l) {
+  for (Channel& c : loads)
+    if (c.pin == relayPin) { c.load = l; return; }
+  loads.push_back(Channel{relayPin, l});
+}
+
+void clearLoads() { loads.clear(); }
+
+void setSupply(float volts, float ohms) {
+  supplyVolts = volts;
+  supplyOhms = ohms;
+}
+
+float loadCurrentA() { return halLoadCurrentAt(nowUs()); }
+float supplyV() { return supplyVolts - loadCurrentA() * supplyOhms; }
+
+void rfSend(int pin, const uint16_t* us, size_t n, uint8_t firstLevel, uint32_t delayUs) {
+  uint64_t t = nowUs() + delayUs;
+  int lvl = firstLevel ? 1 : 0;
+  for (size_t i = 0; i < n; i++) {
+    at(t, [pin, lvl] { setPin(pin, lvl); });
+    t += us[i];
+    lvl ^= 1;
+  }
+  at(t, [pin] { setPin(pin, 0); });
+}
+
+void rfSendPt2262(int pin, uint32_t code, uint8_t bits, uint16_t unitUs, uint8_t repeats, uint32_t delayUs) {
+  std::vector<uint16_t> p;
+  for (uint8_t r = 0; r < repeats; r++) {
+    for (int b = bits - 1; b >= 0; b--) {
+      bool one = (code >> b) & 1;
+      p.push_back((uint16_t)(unitUs * (one ? 3 : 1)));
+      p.push_back((uint16_t)(unitUs * (one ? 1 : 3)));
+    }
+    p.push_back(unitUs);            // sync: 1 high, 31 low
+    p.push_back((uint16_t)(unitUs * 31));
+  }
+  rfSend(pin, p.data(), p.size(), 1, delayUs);
+}
+
+}  // namespace sim
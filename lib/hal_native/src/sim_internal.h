@@ -0,0 +1,8 @@
+#pragma once
+#include <stdint.h>
+
+// Shared between the simulator translation units only.
+void  halIrqEnter();
+void  halIrqExit();
+float halLoadCurrentAt(uint64_t tUs);
+void  halSleepUs(uint32_t us);   // block the calling task (a busy device), others run
@@ -0,0 +1,318 @@
+// Wi-Fi link, HTTP stand-in server, the inactive app slot behind Update and
+// the running slot it is read back from.
+#include <Arduino.h>
+#include <HTTPClient.h>
+#include <Update.h>
+#include <WiFi.h>
+#include <esp_ota_ops.h>
+#include <sim.h>
+#include "sim_internal.h"
+#include <algorithm>
+#include <map>
+#include <strings.h>
+
+namespace {
+
+struct Link {
+  bool     up = false;
+  uint32_t bytesPerSec = 100000;
+  uint32_t rttUs = 40000;
+} link;
+
+std::map<std::string, sim::HttpHandler>& routes() {
+  static std::map<std::string, sim::HttpHandler> r;
+  return r;
+}
+uint32_t requests = 0;
+uint64_t bodyBytes = 0;
+
+// Flash timing for the app slot: 64 KB block erase, page programming by the byte
+constexpr size_t   SLOT_BYTES     = 0x700000;
+constexpr size_t   ERASE_BLOCK    = 65536;
+constexpr uint32_t ERASE_BLOCK_US = 150000;
+constexpr uint32_t PROGRAM_NS_PER_BYTE = 1500;
+constexpr uint8_t  IMAGE_MAGIC    = 0xE9;
+constexpr size_t   SECTOR         = 4096;
+constexpr uint32_t ERASE_SECTOR_US = 45000;
+
+std::vector<uint8_t> slot;
+bool bootSwitched = false;
+std::vector<bool> sectorErased(SLOT_BYTES / SECTOR);   // raw partition writes: programming only clears bits
+const esp_partition_t NEXT_PART = {0x710000, SLOT_BYTES, "app1"};
+
+// Receive window: the sender stops once this much is unread (lwIP's TCP_WND)
+constexpr size_t TCP_WND = 5744;
+
+// Running slot reads: QIO at 80 MHz, plus the per-call cache/MMU setup
+constexpr uint32_t READ_CALL_US     = 2;
+constexpr uint32_t READ_NS_PER_BYTE = 25;
+std::vector<uint8_t> running;
+const esp_partition_t RUNNING_PART = {0x10000, SLOT_BYTES, "app0"};
+
+// TLS record decrypt on the receiving side, charged as CPU per byte read
+constexpr uint32_t TLS_NS_PER_BYTE = 60;
+
+std::string lower(std::string s) {
+  for (auto& c : s) c = (char)tolower((unsigned char)c);
+  return s;
+}
+
+}  // namespace
+
+// A response body in flight: bytes arrive at the link rate from t0 while the
+// receive window has room; a reader that falls TCP_WND behind stalls the sender.
+struct SimConn {
+  std::string body;
+  size_t      pos = 0;
+  uint64_t    t0 = 0;           // sender clock: when byte 'recvd' is on its way
+  uint32_t    bytesPerSec = 0;
+  size_t      recvd = 0;
+
+  size_t arrived() {
+    if (!link.up) return pos;   // link gone: nothing more turns up
+    uint64_t now = sim::nowUs();
+    if (now <= t0) return recvd;
+    uint64_t can = (now - t0) * bytesPerSec / 1000000u;
+    size_t room = std::min(pos + TCP_WND, body.size()) - recvd;
+    if (can < room) {
+      recvd += (size_t)can;
+      t0 += can * 1000000u / bytesPerSec;
+    } else {
+      recvd += room;
+      t0 = now;                 // window full (or all sent): the sender idles
+    }
+    return recvd;
+  }
+};
+
+// ------------------- sim:: network -------------------
+namespace sim {
+
+std::string HttpRequest::header(const char* name) const {
+  for (auto& h : headers)
+    if (!strcasecmp(h.first.c_str(), name)) return h.second;
+  return std::string();
+}
+
+void wifiLink(bool up, uint32_t bytesPerSec, uint32_t rttUs) {
+  link.up = up;
+  link.bytesPerSec = bytesPerSec ? bytesPerSec : 1;
+  link.rttUs = rttUs;
+}
+
+void httpRoute(const std::string& url, HttpHandler h) { routes()[url] = std::move(h); }
+
+void httpServe(const std::string& url, const std::string& body, int status) {
+  httpRoute(url, [body, status](const HttpRequest&) {
+    HttpResponse r;
+    r.status = status;
+    r.body = body;
+    return r;
+  });
+}
+
+void     httpClearRoutes() { routes().clear(); requests = 0; bodyBytes = 0; }
+uint32_t httpRequests() { return requests; }
+uint64_t httpBodyBytes() { return bodyBytes; }
+
+const std::vector<uint8_t>& otaSlot() { return slot; }
+bool otaBootSwitched() { return bootSwitched; }
+void otaReset() { slot.clear(); bootSwitched = false; }
+void runningImage(const std::vector<uint8_t>& img) { running = img; }
+
+}  // namespace sim
+
+// ------------------- WiFi -------------------
+wl_status_t WiFiClass::status() { return link.up ? WL_CONNECTED : WL_DISCONNECTED; }
+
+WiFiClient::~WiFiClient() { stop(); }
+
+void WiFiClient::stop() {
+  delete conn_;
+  conn_ = nullptr;
+}
+
+uint8_t WiFiClient::connected() {
+  return conn_ && link.up && (conn_->pos < conn_->body.size());
+}
+
+int WiFiClient::available() {
+  sim::spend(1);
+  return conn_ ? (int)(conn_->arrived() - conn_->pos) : 0;
+}
+
+int WiFiClient::read(uint8_t* b, size_t n) {
+  int avail = available();
+  if (avail <= 0) return conn_ && connected() ? 0 : -1;
+  size_t k = n < (size_t)avail ? n : (size_t)avail;
+  memcpy(b, conn_->body.data() + conn_->pos, k);
+  conn_->pos += k;
+  bodyBytes += k;
+  sim::spend((uint32_t)((k * TLS_NS_PER_BYTE + 999) / 1000));
+  return (int)k;
+}
+
+int WiFiClient::read() {
+  uint8_t c;
+  return read(&c, 1) == 1 ? c : -1;
+}
+
+// ------------------- HTTPClient -------------------
+void HTTPClient::end() {
+  if (client_) client_->stop();
+  req_.clear();
+}
+
+int HTTPClient::GET() {
+  if (!link.up || !client_) return HTTPC_ERROR_CONNECTION_REFUSED;
+  sim::HttpRequest rq{url_, req_};
+  delay((link.rttUs + 999) / 1000);   // request out, status line back
+  if (!link.up) return HTTPC_ERROR_NOT_CONNECTED;
+  requests++;
+  sim::HttpResponse rs;
+  auto it = routes().find(url_);
+  if (it != routes().end()) rs = it->second(rq);
+  else rs.status = HTTP_CODE_NOT_FOUND;
+  resp_ = rs.headers;
+  client_->stop();
+  client_->conn_ = new SimConn{std::move(rs.body), 0, sim::nowUs(), link.bytesPerSec, 0};
+  size_ = (int)client_->conn_->body.size();
+  return rs.status;
+}
+
+String HTTPClient::header(const char* name) {
+  for (auto& h : resp_)
+    if (lower(h.first) == lower(name)) return String(h.second);
+  return String();
+}
+
+String HTTPClient::getString() {
+  std::string out;
+  uint8_t buf[512];
+  while (client_ && client_->connected()) {
+    int n = client_->read(buf, sizeof(buf));
+    if (n > 0) out.append((const char*)buf, (size_t)n);
+    else delay(1);
+  }
+  return String(out);
+}
+
+// ------------------- Running app slot -------------------
+uint32_t EspClass::getSketchSize() { return (uint32_t)running.size(); }
+
+const esp_partition_t* esp_ota_get_running_partition(void) { return &RUNNING_PART; }
+
+esp_err_t esp_partition_read(const esp_partition_t* part, size_t off, void* dst, size_t n) {
+  if (part != &RUNNING_PART || !dst) return ESP_ERR_INVALID_ARG;
+  if (off + n > part->size) return ESP_ERR_INVALID_SIZE;
+  sim::spend(READ_CALL_US + (uint32_t)((n * READ_NS_PER_BYTE + 999) / 1000));
+  for (size_t i = 0; i < n; i++)   // past the image the slot reads erased
+    ((uint8_t*)dst)[i] = off + i < running.size() ? running[off + i] : 0xFF;
+  return ESP_OK;
+}
+
+// ------------------- Inactive app slot, raw -------------------
+const esp_partition_t* esp_ota_get_next_update_partition(const esp_partition_t*) { return &NEXT_PART; }
+
+// Erasing from offset 0 starts a new image as far as sim::otaSlot() goes
+esp_err_t esp_partition_erase_range(const esp_partition_t* part, size_t off, size_t n) {
+  if (part != &NEXT_PART) return ESP_ERR_INVALID_ARG;
+  if (off % SECTOR || n % SECTOR || off + n > part->size) return ESP_ERR_INVALID_SIZE;
+  if (off == 0) {
+    sim::otaReset();
+    sectorErased.assign(sectorErased.size(), false);
+  }
+  for (size_t at = off; at < off + n;) {
+    bool block = at % ERASE_BLOCK == 0 && off + n - at >= ERASE_BLOCK;
+    size_t k = block ? ERASE_BLOCK : SECTOR;
+    halSleepUs(block ? ERASE_BLOCK_US : ERASE_SECTOR_US);
+    for (size_t q = at; q < at + k; q += SECTOR) sectorErased[q / SECTOR] = true;
+    if (at < slot.size()) std::fill(slot.begin() + at, slot.begin() + std::min(at + k, slot.size()), 0xFF);
+    at += k;
+  }
+  return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t* part, size_t off, const void* src, size_t n) {
+  if (part != &NEXT_PART || !src) return ESP_ERR_INVALID_ARG;
+  if (off + n > part->size) return ESP_ERR_INVALID_SIZE;
+  if (slot.size() < off + n) slot.resize(off + n, 0xFF);
+  for (size_t i = 0; i < n; i++)   // never-erased sectors hold the last image's bytes: model as 0
+    slot[off + i] &= sectorErased[(off + i) / SECTOR] ? ((const uint8_t*)src)[i] : 0;
+  sim::spend((uint32_t)((n * PROGRAM_NS_PER_BYTE + 999) / 1000));
+  return ESP_OK;
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t* part) {
+  if (part != &NEXT_PART) return ESP_ERR_INVALID_ARG;
+  if (slot.empty() || slot[0] != IMAGE_MAGIC) return ESP_ERR_OTA_VALIDATE_FAILED;
+  bootSwitched = true;
+  return ESP_OK;
+}
+
+// ------------------- Update (inactive app slot) -------------------
+UpdateClass Update;
+
+bool UpdateClass::begin(size_t size, int command, int, uint8_t, const char*) {
+  abort();
+  err_ = UPDATE_ERROR_OK;
+  if (command != U_FLASH || size == 0 || size == UPDATE_SIZE_UNKNOWN) { err_ = UPDATE_ERROR_SIZE; return false; }
+  if (size > SLOT_BYTES) { err_ = UPDATE_ERROR_SPACE; return false; }
+  sim::otaReset();
+  size_ = size;
+  return true;
+}
+
+bool UpdateClass::flushBuf() {
+  if (!bufLen_) return true;
+  if (slot.empty() && buf_[0] != IMAGE_MAGIC) { err_ = UPDATE_ERROR_MAGIC_BYTE; return false; }
+  size_t at = slot.size();
+  if (at % ERASE_BLOCK == 0) sim::spend(ERASE_BLOCK_US);
+  slot.insert(slot.end(), buf_, buf_ + bufLen_);
+  sim::spend((uint32_t)((bufLen_ * PROGRAM_NS_PER_BYTE + 999) / 1000));
+  bufLen_ = 0;
+  return true;
+}
+
+size_t UpdateClass::write(uint8_t* data, size_t len) {
+  if (hasError() || !isRunning()) return 0;
+  if (len > remaining()) { err_ = UPDATE_ERROR_SPACE; return 0; }
+  size_t done = 0;
+  while (done < len) {
+    size_t k = sizeof(buf_) - bufLen_;
+    if (k > len - done) k = len - done;
+    memcpy(buf_ + bufLen_, data + done, k);
+    bufLen_ += k;
+    done += k;
+    if (bufLen_ == sizeof(buf_) && !flushBuf()) return 0;
+  }
+  progress_ += len;
+  return len;
+}
+
+bool UpdateClass::end(bool evenIfRemaining) {
+  if (hasError() || !isRunning()) return false;
+  if (!isFinished() && !evenIfRemaining) { err_ = UPDATE_ERROR_ABORT; return false; }
+  if (!flushBuf()) return false;
+  bootSwitched = true;
+  size_ = progress_ = 0;
+  return true;
+}
+
+void UpdateClass::abort() {
+  if (isRunning() && !hasError()) err_ = UPDATE_ERROR_ABORT;
+  size_ = progress_ = bufLen_ = 0;
+}
+
+const char* UpdateClass::errorString() {
+  switch (err_) {
+    case UPDATE_ERROR_OK:         return "No Error";
+    case UPDATE_ERROR_WRITE:      return "Flash Write Failed";
+    case UPDATE_ERROR_ERASE:      return "Flash Erase Failed";
+    case UPDATE_ERROR_SPACE:      return "Not Enough Space";
+    case UPDATE_ERROR_SIZE:       return "Bad Size Given";
+    case UPDATE_ERROR_MAGIC_BYTE: return "Wrong Magic Byte";
+    case UPDATE_ERROR_ABORT:      return "Update Aborted";
+  }
+  return "UNKNOWN";
+}
@@ -0,0 +1,405 @@
+// Virtual clock, device events and a one-CPU FreeRTOS scheduler.
+//
+// Every FreeRTOS task is a host thread, but only the task in 'cur' runs; the
+// others are parked on their condition variable. A task gives up the CPU when
+// it blocks (delay, notify wait, queue receive) or when something it did made
+// a higher-priority task ready. When nothing is ready the clock jumps to the
+// next timeout or device event. Device events (INA226 conversions, RF edges,
+// esp_timer deadlines) run in "interrupt context": in zero virtual time, on
+// whichever thread is driving the clock, with preemption deferred until they
+// return.
+#include <Arduino.h>
+#include <sim.h>
+#include "sim_internal.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Task {
+  const char*             name;
+  UBaseType_t             prio;
+  TaskFunction_t          fn;
+  void*                   arg;
+  std::condition_variable cv;
+  enum State { READY, BLOCKED, DEAD } st = READY;
+  enum Wait { W_SLEEP, W_TAKE, W_WAIT, W_QUEUE } wait = W_SLEEP;
+  uint64_t wakeUs    = UINT64_MAX;
+  uint64_t readySeq  = 0;
+  uint32_t notifyVal = 0;
+  bool     notified  = false;
+  void*    waitQ     = nullptr;
+};
+
+struct Event {
+  uint64_t t, seq;
+  std::function<void()> fn;
+};
+struct Later {
+  bool operator()(const Event& a, const Event& b) const { return a.t != b.t ? a.t > b.t : a.seq > b.seq; }
+};
+
+// Never destroyed: detached task threads are still parked on them at exit.
+std::mutex&         bigLock() { static auto* m = new std::mutex; return *m; }
+std::vector<Task*>& tasks()   { static auto* v = new std::vector<Task*>; return *v; }
+std::priority_queue<Event, std::vector<Event>, Later>& events() {
+  static auto* q = new std::priority_queue<Event, std::vector<Event>, Later>;
+  return *q;
+}
+
+Task*    cur       = nullptr;
+uint64_t now       = 0;
+uint64_t seq       = 0;
+int      irqDepth  = 0;   // > 0 while device events run
+int      noPreempt = 0;   // critical sections, open I2C transactions
+
+// The thread that first touches the scheduler (the test runner) becomes a
+// task at Arduino loopTask priority.
+Task* self() {
+  if (!cur) {
+    Task* t = new Task;
+    t->name = "main"; t->prio = 1; t->fn = nullptr; t->arg = nullptr;
+    t->readySeq = ++seq;
+    tasks().push_back(t);
+    cur = t;
+  }
+  return cur;
+}
+
+void makeReady(Task* t) {
+  t->st = Task::READY;
+  t->readySeq = ++seq;
+}
+
+void runDue(uint64_t until) {
+  auto& q = events();
+  irqDepth++;
+  while (!q.empty() && q.top().t <= until) {
+    Event e = q.top();
+    q.pop();
+    if (e.t > now) now = e.t;
+    e.fn();
+  }
+  irqDepth--;
+  if (until > now) now = until;
+}
+
+void wakeTimedOut() {
+  for (Task* t : tasks())
+    if (t->st == Task::BLOCKED && t->wakeUs <= now) makeReady(t);
+}
+
+Task* bestReady() {
+  Task* best = nullptr;
+  for (Task* t : tasks()) {
+    if (t->st != Task::READY) continue;
+    if (!best || t->prio > best->prio || (t->prio == best->prio && t->readySeq < best->readySeq)) best = t;
+  }
+  return best;
+}
+
+Task* pickNext() {
+  for (;;) {
+    wakeTimedOut();
+    if (Task* t = bestReady()) return t;
+    uint64_t next = UINT64_MAX;
+    for (Task* t : tasks())
+      if (t->st == Task::BLOCKED && t->wakeUs < next) next = t->wakeUs;
+    if (!events().empty() && events().top().t < next) next = events().top().t;
+    if (next == UINT64_MAX) {
+      fprintf(stderr, "sim: deadlock at %llu us, every task is blocked forever\n", (unsigned long long)now);
+      abort();
+    }
+    runDue(next);
+  }
+}
+
+// Hand the CPU to 'next' and park the caller until it is scheduled again.
+// A DEAD caller never is.
+void switchTo(Task* next) {
+  Task* me = cur;
+  if (next == me) return;
+  std::unique_lock<std::mutex> lk(bigLock());
+  cur = next;
+  next->cv.notify_one();
+  me->cv.wait(lk, [me] { return cur == me; });
+}
+
+void maybePreempt() {
+  if (irqDepth || noPreempt || !cur) return;
+  wakeTimedOut();
+  Task* best = bestReady();
+  if (best && best != cur && best->prio > cur->prio) switchTo(pickNext());
+}
+
+uint64_t deadline(TickType_t ticks) {
+  return ticks == portMAX_DELAY ? UINT64_MAX : now + (uint64_t)ticks * 1000u;
+}
+
+void block(Task::Wait w, uint64_t wakeUs) {
+  Task* me = self();
+  me->st = Task::BLOCKED;
+  me->wait = w;
+  me->wakeUs = wakeUs;
+  switchTo(pickNext());
+}
+
+void startThread(Task* t) {
+  std::thread([t] {
+    {
+      std::unique_lock<std::mutex> lk(bigLock());
+      t->cv.wait(lk, [t] { return cur == t; });
+    }
+    t->fn(t->arg);
+    vTaskDelete(nullptr);
+  }).detach();
+}
+
+BaseType_t notify(Task* t, uint32_t v, eNotifyAction a) {
+  switch (a) {
+    case eSetBits:               t->notifyVal |= v; break;
+    case eIncrement:             t->notifyVal++; break;
+    case eSetValueWithOverwrite: t->notifyVal = v; break;
+    case eSetValueWithoutOverwrite:
+      if (t->notified) return pdFAIL;
+      t->notifyVal = v;
+      break;
+    case eNoAction: break;
+  }
+  t->notified = true;
+  if (t->st == Task::BLOCKED && (t->wait == Task::W_WAIT || (t->wait == Task::W_TAKE && t->notifyVal))) makeReady(t);
+  return pdPASS;
+}
+
+struct Queue {
+  size_t item, cap;
+  std::deque<std::vector<uint8_t>> q;
+};
+
+BaseType_t queuePut(Queue* q, const void* item) {
+  if (q->q.size() >= q->cap) return pdFALSE;
+  const uint8_t* b = (const uint8_t*)item;
+  q->q.emplace_back(b ? b : (const uint8_t*)"", b ? b + q->item : (const uint8_t*)"");
+  Task* waiter = nullptr;
+  for (Task* t : tasks())
+    if (t->st == Task::BLOCKED && t->wait == Task::W_QUEUE && t->waitQ == q && (!waiter || t->prio > waiter->prio)) waiter = t;
+  if (waiter) makeReady(waiter);
+  return pdTRUE;
+}
+
+}  // namespace
+
+// ------------------- sim:: time and events -------------------
+namespace sim {
+
+uint64_t nowUs() { return now; }
+
+void spend(uint32_t us) {
+  if (irqDepth) return;   // handlers run in zero time
+  self();
+  runDue(now + us);
+  maybePreempt();
+}
+
+void at(uint64_t tUs, std::function<void()> fn) {
+  events().push(Event{tUs < now ? now : tUs, ++seq, std::move(fn)});
+}
+void after(uint32_t us, std::function<void()> fn) { at(now + us, std::move(fn)); }
+
+void holdPreempt() { noPreempt++; }
+void releasePreempt() {
+  if (--noPreempt == 0) maybePreempt();
+}
+
+}  // namespace sim
+
+// Interrupt entry for pin changes driven from task context (sim::setPin in a test)
+void halIrqEnter() { irqDepth++; }
+void halIrqExit() {
+  if (--irqDepth == 0) maybePreempt();
+}
+
+void halEnterCritical() { noPreempt++; }
+void halExitCritical() {
+  if (--noPreempt == 0) maybePreempt();
+}
+void halYieldFromIsr(BaseType_t) {}   // preemption is checked once the handler returns
+
+void halSleepUs(uint32_t us) {
+  if (irqDepth || !us) return;
+  block(Task::W_SLEEP, now + us);
+}
+
+// ------------------- Tasks -------------------
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t, void* arg,
+                                   UBaseType_t prio, TaskHandle_t* out, BaseType_t) {
+  self();
+  Task* t = new Task;
+  t->name = name; t->prio = prio; t->fn = fn; t->arg = arg;
+  makeReady(t);
+  tasks().push_back(t);
+  if (out) *out = t;
+  startThread(t);
+  maybePreempt();
+  return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t h) {
+  Task* t = h ? (Task*)h : self();
+  t->st = Task::DEAD;
+  if (t == cur) switchTo(pickNext());   // does not return
+}
+
+void vTaskDelay(TickType_t ticks) {
+  if (!ticks) { taskYIELD(); return; }
+  block(Task::W_SLEEP, deadline(ticks));
+}
+
+void vTaskDelayUntil(TickType_t* prevWake, TickType_t increment) {
+  uint64_t target = (uint64_t)(*prevWake + increment) * 1000u;
+  *prevWake += increment;
+  if (target > now) block(Task::W_SLEEP, target);
+}
+
+TickType_t   xTaskGetTickCount() { return (TickType_t)(now / 1000u); }
+TaskHandle_t xTaskGetCurrentTaskHandle() { return self(); }
+BaseType_t   xPortGetCoreID() { return 0; }
+UBaseType_t  uxTaskGetStackHighWaterMark(TaskHandle_t) { return 1024; }
+
+void taskYIELD() {
+  Task* me = self();
+  makeReady(me);
+  switchTo(pickNext());
+}
+
+// ------------------- Notifications -------------------
+BaseType_t xTaskNotify(TaskHandle_t h, uint32_t v, eNotifyAction a) {
+  BaseType_t r = notify((Task*)h, v, a);
+  maybePreempt();
+  return r;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t h, uint32_t v, eNotifyAction a, BaseType_t* woke) {
+  BaseType_t r = notify((Task*)h, v, a);
+  if (woke && ((Task*)h)->prio > self()->prio) *woke = pdTRUE;
+  return r;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t h) { return xTaskNotify(h, 0, eIncrement); }
+void vTaskNotifyGiveFromISR(TaskHandle_t h, BaseType_t* woke) { xTaskNotifyFromISR(h, 0, eIncrement, woke); }
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticks) {
+  Task* me = self();
+  if (!me->notifyVal && ticks) block(Task::W_TAKE, deadline(ticks));
+  uint32_t v = me->notifyVal;
+  if (v) me->notifyVal = clearOnExit ? 0 : v - 1;
+  me->notified = false;
+  return v;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t* value, TickType_t ticks) {
+  Task* me = self();
+  if (!me->notified) {
+    me->notifyVal &= ~clearOnEntry;
+    if (ticks) block(Task::W_WAIT, deadline(ticks));
+  }
+  if (value) *value = me->notifyVal;
+  if (!me->notified) return pdFALSE;
+  me->notifyVal &= ~clearOnExit;
+  me->notified = false;
+  return pdTRUE;
+}
+
+// ------------------- Queues / semaphores -------------------
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  return new Queue{itemSize, length, {}};
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t) {
+  BaseType_t r = queuePut((Queue*)q, item);
+  maybePreempt();
+  return r;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void* item, BaseType_t* woke) {
+  BaseType_t r = queuePut((Queue*)q, item);
+  if (woke && r) *woke = pdTRUE;
+  return r;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t h, void* out, TickType_t ticks) {
+  Queue* q = (Queue*)h;
+  if (q->q.empty() && ticks) {
+    self()->waitQ = q;
+    block(Task::W_QUEUE, deadline(ticks));
+    self()->waitQ = nullptr;
+  }
+  if (q->q.empty()) return pdFALSE;
+  if (out && q->item) memcpy(out, q->q.front().data(), q->item);
+  q->q.pop_front();
+  return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) { return (UBaseType_t)((Queue*)q)->q.size(); }
+BaseType_t  xQueueReset(QueueHandle_t q) { ((Queue*)q)->q.clear(); return pdPASS; }
+
+SemaphoreHandle_t xSemaphoreCreateBinary() { return xQueueCreate(1, 0); }
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+  SemaphoreHandle_t s = xQueueCreate(1, 0);
+  queuePut((Queue*)s, nullptr);
+  return s;
+}
+
+// ------------------- esp_timer -------------------
+struct esp_timer {
+  esp_timer_create_args_t args;
+  uint64_t gen = 0;
+  uint64_t periodUs = 0;
+  bool     armed = false;
+};
+
+static void timerFire(esp_timer* t, uint64_t gen) {
+  if (t->gen != gen || !t->armed) return;
+  if (t->periodUs) sim::after((uint32_t)t->periodUs, [t, gen] { timerFire(t, gen); });
+  else t->armed = false;
+  t->args.callback(t->args.arg);
+}
+
+int64_t esp_timer_get_time() {
+  sim::spend(1);
+  return (int64_t)now;
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out) {
+  esp_timer* t = new esp_timer;
+  t->args = *args;
+  *out = t;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t t, uint64_t us) {
+  if (t->armed) return ESP_ERR_INVALID_STATE;
+  t->armed = true; t->periodUs = 0;
+  uint64_t gen = ++t->gen;
+  sim::after((uint32_t)us, [t, gen] { timerFire(t, gen); });
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t t, uint64_t us) {
+  if (t->armed) return ESP_ERR_INVALID_STATE;
+  t->armed = true; t->periodUs = us;
+  uint64_t gen = ++t->gen;
+  sim::after((uint32_t)us, [t, gen] { timerFire(t, gen); });
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t t) {
+  if (!t->armed) return ESP_ERR_INVALID_STATE;
+  t->armed = false;
+  t->gen++;
+  return ESP_OK;
+}
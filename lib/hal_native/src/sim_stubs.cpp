@@ -0,0 +1,162 @@
+// Preferences store, TFT pixel accounting, the spi_master DMA model and the
+// peripheral globals.
+#include <Arduino.h>
+#include <Adafruit_ST7735.h>
+#include <ELECHOUSE_CC1101_SRC_DRV.h>
+#include <Preferences.h>
+#include <SPI.h>
+#include <WiFi.h>
+#include <driver/spi_master.h>
+#include <sim.h>
+#include "sim_internal.h"
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <vector>
+
+SPIClass         SPI;
+WiFiClass        WiFi;
+ELECHOUSE_CC1101 ELECHOUSE_cc1101;
+
+namespace {
+std::map<std::string, std::vector<uint8_t>>& store() {
+  static std::map<std::string, std::vector<uint8_t>> s;
+  return s;
+}
+uint32_t pixels = 0;
+}  // namespace
+
+namespace sim {
+void     prefsClear() { store().clear(); }
+uint32_t tftPixelsPushed() { return pixels; }
+}  // namespace sim
+
+// ------------------- Preferences -------------------
+bool Preferences::begin(const char* ns, bool) {
+  ns_ = ns ? ns : "";
+  return true;
+}
+
+bool Preferences::clear() {
+  std::string pre = ns_ + "/";
+  auto& s = store();
+  for (auto it = s.lower_bound(pre); it != s.end() && it->first.compare(0, pre.size(), pre) == 0;) it = s.erase(it);
+  return true;
+}
+
+bool Preferences::remove(const char* key) { return store().erase(k(key)) > 0; }
+bool Preferences::isKey(const char* key) { return store().count(k(key)) > 0; }
+
+size_t Preferences::get(const char* key, void* buf, size_t n) {
+  auto it = store().find(k(key));
+  if (it == store().end() || it->second.size() != n) return 0;
+  memcpy(buf, it->second.data(), n);
+  return n;
+}
+
+size_t Preferences::put(const char* key, const void* buf, size_t n) {
+  const uint8_t* b = (const uint8_t*)buf;
+  store()[k(key)] = std::vector<uint8_t>(b, b + n);
+  return n;
+}
+
+uint32_t Preferences::getULong(const char* key, uint32_t def) { uint32_t v; return get(key, &v, sizeof(v)) ? v : def; }
+size_t   Preferences::putULong(const char* key, uint32_t v) { return put(key, &v, sizeof(v)); }
+uint8_t  Preferences::getUChar(const char* key, uint8_t def) { uint8_t v; return get(key, &v, sizeof(v)) ? v : def; }
+size_t   Preferences::putUChar(const char* key, uint8_t v) { return put(key, &v, sizeof(v)); }
+uint16_t Preferences::getUShort(const char* key, uint16_t def) { uint16_t v; return get(key, &v, sizeof(v)) ? v : def; }
+size_t   Preferences::putUShort(const char* key, uint16_t v) { return put(key, &v, sizeof(v)); }
+int32_t  Preferences::getInt(const char* key, int32_t def) { int32_t v; return get(key, &v, sizeof(v)) ? v : def; }
+size_t   Preferences::putInt(const char* key, int32_t v) { return put(key, &v, sizeof(v)); }
+float    Preferences::getFloat(const char* key, float def) { float v; return get(key, &v, sizeof(v)) ? v : def; }
+size_t   Preferences::putFloat(const char* key, float v) { return put(key, &v, sizeof(v)); }
+bool     Preferences::getBool(const char* key, bool def) { uint8_t v; return get(key, &v, 1) ? v != 0 : def; }
+size_t   Preferences::putBool(const char* key, bool v) { uint8_t b = v; return put(key, &b, 1); }
+
+String Preferences::getString(const char* key, String def) {
+  auto it = store().find(k(key));
+  if (it == store().end()) return def;
+  return String(std::string(it->second.begin(), it->second.end()));
+}
+
+size_t Preferences::putString(const char* key, const String& v) { return put(key, v.c_str(), v.length()); }
+
+size_t Preferences::getBytesLength(const char* key) {
+  auto it = store().find(k(key));
+  return it == store().end() ? 0 : it->second.size();
+}
+
+size_t Preferences::getBytes(const char* key, void* buf, size_t n) {
+  auto it = store().find(k(key));
+  if (it == store().end() || it->second.size() > n) return 0;
+  memcpy(buf, it->second.data(), it->second.size());
+  return it->second.size();
+}
+
+size_t Preferences::putBytes(const char* key, const void* buf, size_t n) { return put(key, buf, n); }
+
+// ------------------- ST7735 -------------------
+static void pushPixels(uint32_t n) {
+  pixels += n;
+  sim::spend((n * 16u + 39u) / 40u);   // 16 bits per pixel at 40 MHz
+}
+
+void Adafruit_ST7735::setAddrWindow(uint16_t, uint16_t, uint16_t, uint16_t) { sim::spend(2); }
+void Adafruit_ST7735::writePixels(uint16_t*, uint32_t len, bool, bool) { pushPixels(len); }
+void Adafruit_ST7735::drawPixel(int16_t x, int16_t y, uint16_t) {
+  if (x < 0 || y < 0 || x >= width() || y >= height()) return;
+  pushPixels(1);
+}
+
+// ------------------- spi_master -------------------
+struct spi_device_t {
+  int              hz;
+  transaction_cb_t pre;
+  struct Pending { spi_transaction_t* t; uint64_t doneUs; };
+  std::deque<Pending> q;
+  uint64_t         busyUntilUs = 0;
+};
+
+static constexpr uint32_t SPI_TRANS_SETUP_NS = 1500;   // descriptor load + CS per transaction
+
+static uint64_t spiWireUs(const spi_device_t* d, const spi_transaction_t* t) {
+  return (SPI_TRANS_SETUP_NS + (uint64_t)t->length * 1000000000ull / (uint32_t)d->hz + 999) / 1000;
+}
+
+esp_err_t spi_bus_initialize(spi_host_device_t, const spi_bus_config_t*, spi_dma_chan_t) { return ESP_OK; }
+
+esp_err_t spi_bus_add_device(spi_host_device_t, const spi_device_interface_config_t* cfg, spi_device_handle_t* out) {
+  spi_device_t* d = new spi_device_t;
+  d->hz  = cfg->clock_speed_hz > 0 ? cfg->clock_speed_hz : 1000000;
+  d->pre = cfg->pre_cb;
+  *out = d;
+  return ESP_OK;
+}
+
+esp_err_t spi_device_queue_trans(spi_device_handle_t d, spi_transaction_t* t, TickType_t) {
+  sim::spend(1);
+  if (d->pre) d->pre(t);
+  uint64_t start = std::max(sim::nowUs(), d->busyUntilUs);
+  d->busyUntilUs = start + spiWireUs(d, t);
+  d->q.push_back(spi_device_t::Pending{t, d->busyUntilUs});
+  return ESP_OK;
+}
+
+esp_err_t spi_device_get_trans_result(spi_device_handle_t d, spi_transaction_t** t, TickType_t ticks) {
+  if (d->q.empty()) return ESP_ERR_TIMEOUT;
+  uint64_t done = d->q.front().doneUs, now = sim::nowUs();
+  if (done > now) {
+    if (!ticks) return ESP_ERR_TIMEOUT;
+    halSleepUs((uint32_t)(done - now));
+  }
+  *t = d->q.front().t;
+  d->q.pop_front();
+  return ESP_OK;
+}
+
+esp_err_t spi_device_polling_transmit(spi_device_handle_t d, spi_transaction_t* t) {
+  if (!d->q.empty()) return ESP_ERR_INVALID_STATE;
+  if (d->pre) d->pre(t);
+  sim::spend((uint32_t)spiWireUs(d, t));   // the caller spins on the done bit
+  return ESP_OK;
+}
@@ -0,0 +1,87 @@
+#include "delta_patch.h"
+#include <string.h>
+
+static uint32_t le32(const uint8_t* p) { return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24; }
+
+void DeltaApplier::begin(const uint8_t oldSha[Sha256::DIGEST], uint32_t oldSize, ReadOldFn rd, WriteFn wr, void* ctx) {
+  memcpy(oldSha_, oldSha, sizeof(oldSha_));
+  oldSize_ = oldSize;
+  rd_ = rd; wr_ = wr; ctx_ = ctx;
+  newSize_ = 0;
+  have_ = 0;
+  addLeft_ = extraLeft_ = 0;
+  seek_ = 0;
+  oldPos_ = 0;
+  produced_ = 0;
+  state_ = S_HEADER;
+  st_ = DP_OK;
+}
+
+// Record fully applied: move the old cursor, and stop once the image is complete
+bool DeltaApplier::endRecord() {
+  oldPos_ += seek_;
+  if (oldPos_ < 0 || oldPos_ > oldSize_) return fail(DP_ERR_RANGE);
+  state_ = produced_ == newSize_ ? S_DONE : S_RECORD;
+  have_ = 0;
+  return true;
+}
+
+bool DeltaApplier::feed(const uint8_t* p, size_t n) {
+  if (st_ != DP_OK) return false;
+  while (n) {
+    switch (state_) {
+      case S_HEADER:
+      case S_RECORD: {
+        size_t need = (state_ == S_HEADER ? HEADER : 12) - have_;
+        size_t k = n < need ? n : need;
+        memcpy(hdr_ + have_, p, k);
+        have_ += (uint8_t)k; p += k; n -= k;
+        if (k < need) return true;
+        if (state_ == S_HEADER) {
+          if (memcmp(hdr_, "TLD1", 4) != 0) return fail(DP_ERR_MAGIC);
+          if (le32(hdr_ + 4) != oldSize_ || memcmp(hdr_ + 12, oldSha_, Sha256::DIGEST) != 0) return fail(DP_ERR_BASE);
+          newSize_ = le32(hdr_ + 8);
+          memcpy(newSha_, hdr_ + 12 + Sha256::DIGEST, Sha256::DIGEST);
+          if (!newSize_) return fail(DP_ERR_RANGE);
+          state_ = S_RECORD;
+          have_ = 0;
+          continue;
+        }
+        addLeft_ = le32(hdr_);
+        extraLeft_ = le32(hdr_ + 4);
+        seek_ = (int32_t)le32(hdr_ + 8);
+        if ((uint64_t)produced_ + addLeft_ + extraLeft_ > newSize_) return fail(DP_ERR_RANGE);
+        if (oldPos_ + addLeft_ > oldSize_) return fail(DP_ERR_RANGE);
+        state_ = addLeft_ ? S_ADD : extraLeft_ ? S_EXTRA : S_RECORD;
+        if (state_ == S_RECORD && !endRecord()) return false;
+        break;
+      }
+      case S_ADD: {
+        uint8_t buf[256];
+        size_t k = n < addLeft_ ? n : addLeft_;
+        if (k > sizeof(buf)) k = sizeof(buf);
+        if (!rd_(ctx_, (uint32_t)oldPos_, buf, k)) return fail(DP_ERR_READ);
+        for (size_t i = 0; i < k; i++) buf[i] += p[i];
+        if (!wr_(ctx_, buf, k)) return fail(DP_ERR_OUTPUT);
+        oldPos_ += k; produced_ += k; addLeft_ -= k;
+        p += k; n -= k;
+        if (!addLeft_) {
+          if (extraLeft_) state_ = S_EXTRA;
+          else if (!endRecord()) return false;
+        }
+        break;
+      }
+      case S_EXTRA: {
+        size_t k = n < extraLeft_ ? n : extraLeft_;
+        if (!wr_(ctx_, p, k)) return fail(DP_ERR_OUTPUT);
+        produced_ += k; extraLeft_ -= k;
+        p += k; n -= k;
+        if (!extraLeft_ && !endRecord()) return false;
+        break;
+      }
+      case S_DONE:
+        return fail(DP_ERR_TRAILING);
+    }
+  }
+  return true;
+}
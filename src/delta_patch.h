@@ -0,0 +1,60 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "sha256.h"
+
+// ------- Streaming delta patch against the running image (pure logic) -------
+// bsdiff-style records, interleaved so a patch applies in one forward pass as
+// it arrives (tools/ota_delta.py builds them; on the wire the stream is
+// gzipped like any other asset):
+//
+//   header  "TLD1" | oldSize u32 | newSize u32 | oldSha256[32] | newSha256[32]
+//   record  addLen u32 | extraLen u32 | seek i32 | addLen diff bytes | extraLen bytes
+//
+// An add copies old[oldPos..] plus the diff byte (mod 256), an extra copies
+// new bytes verbatim, then oldPos moves by seek. All integers little-endian.
+// The old image is read back through a callback, a few hundred bytes at a time.
+
+class DeltaApplier {
+public:
+  static constexpr size_t HEADER = 76;
+
+  typedef bool (*ReadOldFn)(void* ctx, uint32_t off, uint8_t* buf, size_t n);
+  typedef bool (*WriteFn)(void* ctx, const uint8_t* p, size_t n);
+
+  enum Status : uint8_t { DP_OK, DP_ERR_MAGIC, DP_ERR_BASE, DP_ERR_RANGE, DP_ERR_READ, DP_ERR_OUTPUT, DP_ERR_TRAILING };
+
+  // oldSha/oldSize identify the running image; a patch built against anything else stops at its header
+  void begin(const uint8_t oldSha[Sha256::DIGEST], uint32_t oldSize, ReadOldFn rd, WriteFn wr, void* ctx);
+
+  // Patch bytes in order, any split; false once anything is wrong (see status())
+  bool feed(const uint8_t* p, size_t n);
+
+  bool     haveHeader() const { return state_ > S_HEADER; }
+  bool     finished() const { return state_ == S_DONE; }
+  uint32_t newSize() const { return newSize_; }
+  const uint8_t* newSha() const { return newSha_; }
+  uint32_t produced() const { return produced_; }
+  Status   status() const { return st_; }
+
+private:
+  enum State : uint8_t { S_HEADER, S_RECORD, S_ADD, S_EXTRA, S_DONE };
+
+  bool fail(Status s) { st_ = s; return false; }
+  bool endRecord();
+
+  ReadOldFn rd_ = nullptr;
+  WriteFn   wr_ = nullptr;
+  void*     ctx_ = nullptr;
+  uint8_t   oldSha_[Sha256::DIGEST];
+  uint8_t   newSha_[Sha256::DIGEST];
+  uint32_t  oldSize_ = 0, newSize_ = 0;
+  uint8_t   hdr_[HEADER];
+  uint8_t   have_ = 0;                    // bytes of the header/record header collected
+  uint32_t  addLeft_ = 0, extraLeft_ = 0;
+  int32_t   seek_ = 0;
+  int64_t   oldPos_ = 0;
+  uint32_t  produced_ = 0;
+  State     state_ = S_HEADER;
+  Status    st_ = DP_OK;
+};
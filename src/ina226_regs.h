@@ -54,3 +54,33 @@ inline void inaArmAlert_Latched(float limit_A,
   const uint16_t LEN = 1u << 8;
   inaWrite16(i2c_addr, INA_REG_MASK_ENABLE, SOL | LEN);
 }
+
+// ---- Mask/Enable bits
+static const uint16_t INA_MASK_SOL  = 1u << 15;  // shunt over-limit alert
+static const uint16_t INA_MASK_CNVR = 1u << 10;  // ALERT on conversion ready
+static const uint16_t INA_MASK_CVRF = 1u << 3;   // conversion ready flag (cleared by reading Mask/Enable)
+
+// ---- Averaging / conversion-time profile (CONFIG register fields)
+enum InaAvg : uint8_t { INA_AVG_1=0, INA_AVG_4, INA_AVG_16, INA_AVG_64, INA_AVG_128, INA_AVG_256, INA_AVG_512, INA_AVG_1024 };
+enum InaCt  : uint8_t { INA_CT_140US=0, INA_CT_204US, INA_CT_332US, INA_CT_588US, INA_CT_1100US, INA_CT_2116US, INA_CT_4156US, INA_CT_8244US };
+enum InaMode : uint8_t { INA_MODE_SHUNT_CONT = 0b101, INA_MODE_BUS_CONT = 0b110, INA_MODE_SHUNT_BUS_CONT = 0b111 };
+
+struct InaProfile {
+  InaAvg  avg;
+  InaCt   vbusCt;
+  InaCt   vshCt;
+  InaMode mode;
+};
+
+inline uint16_t inaConfigWord(const InaProfile& p) {
+  return ((uint16_t)p.avg << 9) | ((uint16_t)p.vbusCt << 6) | ((uint16_t)p.vshCt << 3) | p.mode;
+}
+
+// Time for one averaged result to land (microseconds)
+inline uint32_t inaConversionUs(const InaProfile& p) {
+  static const uint16_t CT_US[8]  = {140, 204, 332, 588, 1100, 2116, 4156, 8244};
+  static const uint16_t AVG_N[8]  = {1, 4, 16, 64, 128, 256, 512, 1024};
+  uint32_t one = (p.mode != INA_MODE_SHUNT_CONT ? CT_US[p.vbusCt] : 0)
+               + (p.mode != INA_MODE_BUS_CONT   ? CT_US[p.vshCt]  : 0);
+  return one * AVG_N[p.avg];
+}
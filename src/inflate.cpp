@@ -0,0 +1,256 @@
+#include "inflate.h"
+#include <string.h>
+
+// ------------------- CRC-32 (gzip trailer) -------------------
+uint32_t crc32Update(uint32_t crc, const uint8_t* p, size_t n) {
+  static uint32_t table[16];
+  if (!table[1])
+    for (uint32_t i = 0; i < 16; i++) {
+      uint32_t c = i;
+      for (uint8_t k = 0; k < 4; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+      table[i] = c;
+    }
+  crc = ~crc;
+  for (size_t i = 0; i < n; i++) {
+    crc = table[(crc ^ p[i]) & 15] ^ (crc >> 4);
+    crc = table[(crc ^ (p[i] >> 4)) & 15] ^ (crc >> 4);
+  }
+  return ~crc;
+}
+
+// ------------------- gzip header -------------------
+int gzipParseHeader(const uint8_t* p, size_t n, GzipHeader& out) {
+  if (n >= 1 && p[0] != 0x1F) return -1;
+  if (n >= 2 && p[1] != 0x8B) return -1;
+  if (n >= 3 && p[2] != 8) return -1;             // DEFLATE
+  if (n >= 4 && (p[3] & 0xE0)) return -1;         // reserved flags
+  if (n < 10) return 0;
+  uint8_t flg = p[3];
+  size_t at = 10;
+  bool haveTl = false;
+  if (flg & 0x04) {                               // FEXTRA: look for our TL subfield
+    if (n < at + 2) return 0;
+    size_t xlen = p[at] | (size_t)p[at + 1] << 8;
+    at += 2;
+    if (n < at + xlen) return 0;
+    for (size_t q = at; q + 4 <= at + xlen;) {
+      size_t sl = p[q + 2] | (size_t)p[q + 3] << 8;
+      if (q + 4 + sl > at + xlen) return -1;
+      if (p[q] == 'T' && p[q + 1] == 'L' && sl == 5) {
+        out.rawSize = p[q + 4] | (uint32_t)p[q + 5] << 8 | (uint32_t)p[q + 6] << 16 | (uint32_t)p[q + 7] << 24;
+        out.windowBits = p[q + 8];
+        haveTl = true;
+      }
+      q += 4 + sl;
+    }
+    at += xlen;
+  }
+  for (uint8_t f = 0x08; f <= 0x10; f <<= 1) {    // FNAME, FCOMMENT: zero-terminated
+    if (!(flg & f)) continue;
+    while (at < n && p[at]) at++;
+    if (at >= n) return 0;
+    at++;
+  }
+  if (flg & 0x02) at += 2;                        // FHCRC
+  if (n < at) return 0;
+  if (!haveTl || !out.rawSize || out.windowBits > Inflater::WINDOW_BITS) return -1;
+  out.len = (uint16_t)at;
+  return 1;
+}
+
+// ------------------- Bit input -------------------
+int Inflater::nextByte() {
+  if (preLen_) { preLen_--; return *pre_++; }
+  if (inPos_ == inLen_) {
+    inLen_ = rd_(ctx_, in_, sizeof(in_));
+    inPos_ = 0;
+    if (!inLen_) { if (st_ == INF_OK) st_ = INF_ERR_INPUT; return -1; }
+  }
+  return in_[inPos_++];
+}
+
+// DEFLATE packs LSB first; at most 7 spare bits are ever held past a call
+uint32_t Inflater::bits(uint8_t n) {
+  while (bitCnt_ < n) {
+    int b = nextByte();
+    if (b < 0) return 0;
+    bitBuf_ |= (uint32_t)b << bitCnt_;
+    bitCnt_ += 8;
+  }
+  uint32_t v = bitBuf_ & ((1u << n) - 1);
+  bitBuf_ >>= n;
+  bitCnt_ -= n;
+  return v;
+}
+
+// ------------------- Output ring -------------------
+// flushed_ only ever stops on a window boundary until the final flush, so
+// the pending bytes are one contiguous run of the ring.
+bool Inflater::flush() {
+  size_t from = flushed_ & (WINDOW - 1), n = out_ - flushed_;
+  if (!n) return true;
+  crc_ = crc32Update(crc_, win_ + from, n);
+  flushed_ = out_;
+  if (!wr_(ctx_, win_ + from, n)) { st_ = INF_ERR_OUTPUT; return false; }
+  return true;
+}
+
+bool Inflater::put(uint8_t b) {
+  win_[out_ & (WINDOW - 1)] = b;
+  out_++;
+  return (out_ & (WINDOW - 1)) || flush();
+}
+
+// ------------------- Blocks -------------------
+bool Inflater::stored() {
+  bitBuf_ = 0; bitCnt_ = 0;   // to the byte boundary
+  int a = nextByte(), b = nextByte(), c = nextByte(), d = nextByte();
+  if (d < 0) return false;
+  uint16_t len = (uint16_t)(a | b << 8), nlen = (uint16_t)(c | d << 8);
+  if (len != (uint16_t)~nlen) { st_ = INF_ERR_DATA; return false; }
+  while (len--) {
+    int v = nextByte();
+    if (v < 0 || !put((uint8_t)v)) return false;
+  }
+  return true;
+}
+
+// Canonical code: bit-at-a-time against the per-length counts (puff's method)
+int Inflater::decode(const Huff& h) {
+  int code = 0, first = 0, index = 0;
+  for (uint8_t len = 1; len < 16; len++) {
+    code |= (int)bits(1);
+    if (st_ != INF_OK) return -1;
+    int count = h.count[len];
+    if (code - count < first) return h.symbol[index + (code - first)];
+    index += count;
+    first = (first + count) << 1;
+    code <<= 1;
+  }
+  return -1;
+}
+
+bool Inflater::build(Huff& h, const uint8_t* lengths, uint16_t n) {
+  memset(h.count, 0, sizeof(h.count));
+  for (uint16_t s = 0; s < n; s++) h.count[lengths[s]]++;
+  int left = 1;
+  for (uint8_t len = 1; len < 16; len++) {
+    left = (left << 1) - h.count[len];
+    if (left < 0) return false;   // over-subscribed
+  }
+  uint16_t offs[16];
+  offs[1] = 0;
+  for (uint8_t len = 1; len < 15; len++) offs[len + 1] = offs[len] + h.count[len];
+  for (uint16_t s = 0; s < n; s++)
+    if (lengths[s]) h.symbol[offs[lengths[s]]++] = s;
+  return true;
+}
+
+bool Inflater::codes(const Huff& lit, const Huff& dist) {
+  static const uint16_t LBASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                     35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+  static const uint8_t  LEXT[29]  = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+  static const uint16_t DBASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                     257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                     8193, 12289, 16385, 24577};
+  static const uint8_t  DEXT[30]  = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                     7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+  for (;;) {
+    int sym = decode(lit);
+    if (sym < 0) { if (st_ == INF_OK) st_ = INF_ERR_DATA; return false; }
+    if (sym < 256) { if (!put((uint8_t)sym)) return false; continue; }
+    if (sym == 256) return true;
+    sym -= 257;
+    if (sym >= 29) { st_ = INF_ERR_DATA; return false; }
+    uint16_t len = LBASE[sym] + (uint16_t)bits(LEXT[sym]);
+    int ds = decode(dist);
+    if (ds < 0 || ds >= 30) { if (st_ == INF_OK) st_ = INF_ERR_DATA; return false; }
+    uint32_t d = DBASE[ds] + bits(DEXT[ds]);
+    if (st_ != INF_OK) return false;
+    if (d > WINDOW) { st_ = INF_ERR_WINDOW; return false; }   // packed with a larger window
+    if (d > out_)   { st_ = INF_ERR_DATA; return false; }
+    while (len--)
+      if (!put(win_[(out_ - d) & (WINDOW - 1)])) return false;
+  }
+}
+
+bool Inflater::fixed() {
+  static Huff lit, dist;
+  static bool built = false;
+  if (!built) {
+    uint8_t l[288];
+    memset(l, 8, 144); memset(l + 144, 9, 112); memset(l + 256, 7, 24); memset(l + 280, 8, 8);
+    build(lit, l, 288);
+    memset(l, 5, 30);
+    build(dist, l, 30);
+    built = true;
+  }
+  return codes(lit, dist);
+}
+
+bool Inflater::dynamic() {
+  static const uint8_t ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+  uint16_t nlen = bits(5) + 257, ndist = bits(5) + 1, ncode = bits(4) + 4;
+  if (st_ != INF_OK) return false;
+  if (nlen > 286 || ndist > 30) { st_ = INF_ERR_DATA; return false; }
+  uint8_t lengths[286 + 30];
+  memset(lengths, 0, 19);
+  for (uint16_t i = 0; i < ncode; i++) lengths[ORDER[i]] = (uint8_t)bits(3);
+  Huff lit, dist;
+  if (!build(lit, lengths, 19)) { st_ = INF_ERR_DATA; return false; }
+
+  for (uint16_t i = 0; i < nlen + ndist;) {
+    int sym = decode(lit);
+    if (sym < 0) { if (st_ == INF_OK) st_ = INF_ERR_DATA; return false; }
+    if (sym < 16) { lengths[i++] = (uint8_t)sym; continue; }
+    uint8_t v = 0;
+    uint16_t rep;
+    if (sym == 16) {
+      if (!i) { st_ = INF_ERR_DATA; return false; }
+      v = lengths[i - 1];
+      rep = 3 + bits(2);
+    } else rep = sym == 17 ? 3 + bits(3) : 11 + bits(7);
+    if (i + rep > nlen + ndist) { st_ = INF_ERR_DATA; return false; }
+    while (rep--) lengths[i++] = v;
+  }
+  if (st_ != INF_OK) return false;
+  if (!lengths[256] || !build(lit, lengths, nlen) || !build(dist, lengths + nlen, ndist)) {
+    st_ = INF_ERR_DATA;
+    return false;
+  }
+  return codes(lit, dist);
+}
+
+// ------------------- gzip member -------------------
+Inflater::Status Inflater::gunzip(const GzipHeader& hdr, const uint8_t* pre, size_t preLen, ReadFn rd, WriteFn wr,
+                                  void* ctx) {
+  rd_ = rd; wr_ = wr; ctx_ = ctx;
+  pre_ = pre; preLen_ = preLen;
+  inPos_ = inLen_ = 0;
+  bitBuf_ = 0; bitCnt_ = 0;
+  out_ = flushed_ = crc_ = 0;
+  st_ = INF_OK;
+
+  bool last;
+  do {
+    last = bits(1);
+    uint8_t type = (uint8_t)bits(2);
+    if (st_ != INF_OK) return st_;
+    bool ok = type == 0 ? stored() : type == 1 ? fixed() : type == 2 ? dynamic() : false;
+    if (!ok) return st_ != INF_OK ? st_ : (st_ = INF_ERR_DATA);
+  } while (!last);
+  if (!flush()) return st_;
+
+  // Trailer: CRC-32 and ISIZE, little-endian, from the next byte boundary
+  bitBuf_ = 0; bitCnt_ = 0;
+  uint8_t t[8];
+  for (uint8_t i = 0; i < 8; i++) {
+    int b = nextByte();
+    if (b < 0) return st_;
+    t[i] = (uint8_t)b;
+  }
+  uint32_t crc = t[0] | (uint32_t)t[1] << 8 | (uint32_t)t[2] << 16 | (uint32_t)t[3] << 24;
+  uint32_t isize = t[4] | (uint32_t)t[5] << 8 | (uint32_t)t[6] << 16 | (uint32_t)t[7] << 24;
+  if (crc != crc_ || isize != out_ || out_ != hdr.rawSize) st_ = INF_ERR_CHECK;
+  return st_;
+}
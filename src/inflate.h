@@ -0,0 +1,71 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// ------- Streaming gzip/DEFLATE decoder with a 4 KB window (pure logic) -------
+// The OTA image is compressed with the DEFLATE window capped at 4 KB
+// (tools/ota_pack.py), so the whole decoder state is one 4 KB ring plus a
+// small input buffer. Input is pulled through a callback as it arrives;
+// output is pushed a full window (one flash sector) at a time.
+//
+// The gzip header carries an extra "TL" subfield with the raw size and
+// window bits, so the OTA slot can be opened before the first byte inflates.
+// Stock gunzip ignores it.
+
+uint32_t crc32Update(uint32_t crc, const uint8_t* p, size_t n);   // zlib CRC-32, start from 0
+
+struct GzipHeader {
+  uint16_t len;          // bytes up to the first DEFLATE block
+  uint32_t rawSize;      // from the TL subfield
+  uint8_t  windowBits;   // from the TL subfield
+};
+
+// 0 = need more bytes, -1 = not a gzip stream we can decode, else header parsed
+int gzipParseHeader(const uint8_t* p, size_t n, GzipHeader& out);
+
+class Inflater {
+public:
+  static constexpr uint8_t  WINDOW_BITS = 12;
+  static constexpr uint16_t WINDOW      = 1u << WINDOW_BITS;
+
+  // Fill buf with up to cap compressed bytes; 0 ends the stream (done, cancelled or stalled)
+  typedef size_t (*ReadFn)(void* ctx, uint8_t* buf, size_t cap);
+  // Raw output in order; false aborts
+  typedef bool (*WriteFn)(void* ctx, const uint8_t* p, size_t n);
+
+  enum Status : uint8_t { INF_OK, INF_ERR_INPUT, INF_ERR_DATA, INF_ERR_WINDOW, INF_ERR_OUTPUT, INF_ERR_CHECK };
+
+  // Inflate a gzip member whose header (hdr.len bytes) was already read, then
+  // check its CRC-32/ISIZE trailer. 'pre' holds bytes already pulled past the header.
+  Status gunzip(const GzipHeader& hdr, const uint8_t* pre, size_t preLen, ReadFn rd, WriteFn wr, void* ctx);
+
+  uint32_t outBytes() const { return out_; }
+  uint32_t crc() const { return crc_; }
+
+private:
+  struct Huff { uint16_t count[16]; uint16_t symbol[288]; };
+
+  int      nextByte();
+  uint32_t bits(uint8_t n);
+  bool     put(uint8_t b);
+  bool     flush();
+  bool     stored();
+  bool     codes(const Huff& lit, const Huff& dist);
+  bool     fixed();
+  bool     dynamic();
+  int      decode(const Huff& h);
+  static bool build(Huff& h, const uint8_t* lengths, uint16_t n);
+
+  ReadFn   rd_ = nullptr;
+  WriteFn  wr_ = nullptr;
+  void*    ctx_ = nullptr;
+  const uint8_t* pre_ = nullptr;
+  size_t   preLen_ = 0;
+  uint8_t  in_[256];
+  size_t   inPos_ = 0, inLen_ = 0;
+  uint32_t bitBuf_ = 0;
+  uint8_t  bitCnt_ = 0;
+  uint8_t  win_[WINDOW];
+  uint32_t out_ = 0, flushed_ = 0, crc_ = 0;
+  Status   st_ = INF_OK;
+};
@@ -0,0 +1,93 @@
+#include "inrush.h"
+#include <math.h>
+
+void InrushClassifier::reset(uint32_t t0Us) {
+  t0_ = t0Us;
+  over_ = false;
+  overSinceUs_ = 0;
+  res_ = InrushResult{INRUSH_PENDING, 0.0f, 0, 0.0f, 0, 0, 0};
+}
+
+void InrushClassifier::sampleAt(uint16_t i, uint32_t& dtUs, float& amps) const {
+  uint16_t first = res_.samples < RING ? 0 : res_.samples % RING;
+  uint16_t k = (first + i) % RING;
+  dtUs = dt_[k];
+  amps = a_[k];
+}
+
+void InrushClassifier::window(float& mean, float& lo, float& hi) const {
+  uint8_t n = cfg_.settleN;
+  float sum = 0.0f;
+  lo = 1e9f; hi = -1e9f;
+  for (uint8_t i = 0; i < n; i++) {
+    float a = a_[(res_.samples - 1 - i) % RING];
+    sum += a;
+    if (a < lo) lo = a;
+    if (a > hi) hi = a;
+  }
+  mean = sum / n;
+}
+
+InrushClass InrushClassifier::decide(uint32_t elapsed, float mean) {
+  res_.steadyA = mean;
+  res_.elapsedUs = elapsed;
+  if (mean >= cfg_.shortA)              res_.cls = INRUSH_SHORT;
+  else if (mean >= cfg_.openA)          res_.cls = INRUSH_OK;
+  else if (res_.peakA >= 2 * cfg_.openA) res_.cls = INRUSH_OK;    // real inrush, low-draw load (LED)
+  else                                  res_.cls = INRUSH_OPEN;
+  return res_.cls;
+}
+
+InrushClass InrushClassifier::feed(uint32_t tUs, float amps) {
+  if (decided()) return res_.cls;
+  uint32_t elapsed = tUs - t0_;
+  uint16_t k = res_.samples % RING;
+  dt_[k] = elapsed;
+  a_[k]  = amps;
+  res_.samples++;
+
+  if (amps > res_.peakA) { res_.peakA = amps; res_.peakUs = elapsed; }
+
+  // Short: sustained over-current, not a lamp's cold-filament spike
+  if (amps >= cfg_.shortA) {
+    if (!over_) { over_ = true; overSinceUs_ = elapsed; }
+    if (elapsed - overSinceUs_ >= cfg_.shortHoldUs) {
+      res_.steadyA = amps;
+      res_.elapsedUs = elapsed;
+      return res_.cls = INRUSH_SHORT;
+    }
+  } else {
+    over_ = false;
+  }
+
+  if (res_.samples < cfg_.settleN) return elapsed >= cfg_.maxUs ? finish(tUs) : INRUSH_PENDING;
+
+  float mean, lo, hi;
+  window(mean, lo, hi);
+  float band = fmaxf(cfg_.settleBandA, 0.05f * fabsf(mean));
+  bool settled = (hi - lo) <= band;
+  if (settled && !res_.settleUs) res_.settleUs = elapsed;
+
+  // Whole window inside the OK band: nothing left that could change the answer
+  if (elapsed >= cfg_.minUs && lo >= cfg_.openA && hi < cfg_.shortA) return decide(elapsed, mean);
+  // Flat and low: OPEN once soft-start loads have had their chance
+  if (settled && elapsed >= cfg_.openMinUs) return decide(elapsed, mean);
+  if (elapsed >= cfg_.maxUs) return decide(elapsed, mean);
+  return INRUSH_PENDING;
+}
+
+InrushClass InrushClassifier::tripped(uint32_t tUs) {
+  if (decided()) return res_.cls;
+  res_.elapsedUs = tUs - t0_;
+  res_.steadyA = res_.peakA;
+  return res_.cls = INRUSH_SHORT;
+}
+
+InrushClass InrushClassifier::finish(uint32_t tUs) {
+  if (decided()) return res_.cls;
+  if (!res_.samples) { res_.elapsedUs = tUs - t0_; return res_.cls = INRUSH_OPEN; }
+  uint8_t n = res_.samples < cfg_.settleN ? (uint8_t)res_.samples : cfg_.settleN;
+  float sum = 0.0f;
+  for (uint8_t i = 0; i < n; i++) sum += a_[(res_.samples - 1 - i) % RING];
+  return decide(tUs - t0_, sum / n);
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <stdint.h>
+
+// ------- Inrush waveform classifier (pure logic, no hardware access) -------
+// Fed (time, current) samples from the moment a relay closes. Decides OK / OPEN /
+// SHORT from waveform features instead of one reading at a fixed delay, and says
+// so as soon as the answer can no longer change.
+
+enum InrushClass : uint8_t { INRUSH_PENDING = 0, INRUSH_OK, INRUSH_OPEN, INRUSH_SHORT };
+
+struct InrushConfig {
+  float    openA;         // settled below this (with no real inrush) = nothing connected
+  float    shortA;        // held at/above this for shortHoldUs = short
+  uint32_t shortHoldUs;   // lamp inrush peaks pass in well under this
+  uint32_t minUs;         // earliest OK call
+  uint32_t openMinUs;     // earliest OPEN call (soft-start loads need time to show up)
+  uint32_t maxUs;         // stop waiting for settle; decide from the tail
+  uint8_t  settleN;       // samples in the settle window (<= RING)
+  float    settleBandA;   // settled when window spread <= max(band, 5% of mean)
+};
+
+struct InrushResult {
+  InrushClass cls;
+  float       peakA;
+  uint32_t    peakUs;     // since reset()
+  float       steadyA;    // mean of the deciding window
+  uint32_t    settleUs;   // first time the window settled, 0 = never did
+  uint32_t    elapsedUs;  // reset() to decision
+  uint16_t    samples;
+};
+
+class InrushClassifier {
+public:
+  static constexpr uint16_t RING = 128;   // most recent samples kept for dumps
+
+  explicit InrushClassifier(const InrushConfig& cfg) : cfg_(cfg) { reset(0); }
+
+  void reset(uint32_t t0Us);
+  InrushClass feed(uint32_t tUs, float amps);   // INRUSH_PENDING until certain
+  InrushClass tripped(uint32_t tUs);            // hardware OCP fired: SHORT, done
+  InrushClass finish(uint32_t tUs);             // decide now from whatever we have
+
+  const InrushResult& result() const { return res_; }
+  bool decided() const { return res_.cls != INRUSH_PENDING; }
+
+  // Retained waveform, i = 0 is the oldest kept sample
+  uint16_t kept() const { return res_.samples < RING ? res_.samples : RING; }
+  void sampleAt(uint16_t i, uint32_t& dtUs, float& amps) const;
+
+private:
+  InrushConfig cfg_;
+  InrushResult res_;
+  uint32_t t0_ = 0;
+  uint32_t overSinceUs_ = 0;
+  bool     over_ = false;
+  uint32_t dt_[RING];
+  float    a_[RING];
+
+  void window(float& mean, float& lo, float& hi) const;
+  InrushClass decide(uint32_t elapsed, float mean);
+};
@@ -0,0 +1,40 @@
+#include "latency.h"
+
+const uint32_t LatencyHist::EDGE_US[BUCKETS - 1] = {
+  10, 20, 50, 100, 200, 500,
+  1000, 2000, 5000, 10000, 20000, 50000,
+  100000, 200000, 500000, 1000000, 2000000, 5000000, 10000000,
+};
+
+void LatencyHist::clear() {
+  for (uint8_t i = 0; i < BUCKETS; i++) b_[i] = 0;
+  n_ = max_ = last_ = 0;
+  sum_ = 0;
+}
+
+uint8_t LatencyHist::bucketOf(uint32_t us) {
+  uint8_t i = 0;
+  while (i < BUCKETS - 1 && us >= EDGE_US[i]) i++;
+  return i;
+}
+
+void LatencyHist::record(uint32_t us) {
+  b_[bucketOf(us)]++;
+  n_++;
+  sum_ += us;
+  last_ = us;
+  if (us > max_) max_ = us;
+}
+
+uint32_t LatencyHist::percentileUs(uint8_t pct) const {
+  if (!n_) return 0;
+  if (pct > 100) pct = 100;
+  uint32_t rank = (uint32_t)(((uint64_t)pct * n_ + 99) / 100);
+  if (!rank) rank = 1;
+  uint32_t seen = 0;
+  for (uint8_t i = 0; i < BUCKETS - 1; i++) {
+    seen += b_[i];
+    if (seen >= rank) return EDGE_US[i] < max_ ? EDGE_US[i] : max_;
+  }
+  return max_;
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include <stdint.h>
+
+// ------- Fixed-bucket latency histogram (pure logic, no hardware access) -------
+// 1-2-5 bucket edges from 10 us to 10 s, so one record() is a short compare
+// loop with no allocation and the whole thing is a fixed-size block of RAM.
+// Percentiles come back as the upper edge of the bucket that holds the rank.
+
+class LatencyHist {
+public:
+  static constexpr uint8_t BUCKETS = 20;            // last one is open-ended
+  static const uint32_t    EDGE_US[BUCKETS - 1];    // exclusive upper edges
+
+  LatencyHist() { clear(); }
+
+  void clear();
+  void record(uint32_t us);
+
+  uint32_t count() const { return n_; }
+  uint32_t maxUs() const { return max_; }
+  uint32_t lastUs() const { return last_; }
+  uint32_t meanUs() const { return n_ ? (uint32_t)(sum_ / n_) : 0; }
+  uint32_t bucket(uint8_t i) const { return i < BUCKETS ? b_[i] : 0; }
+
+  // pct in 1..100; never reports more than the worst sample seen
+  uint32_t percentileUs(uint8_t pct) const;
+
+  static uint8_t bucketOf(uint32_t us);
+
+private:
+  uint32_t b_[BUCKETS];
+  uint32_t n_, max_, last_;
+  uint64_t sum_;
+};
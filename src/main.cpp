@@ -1,8 +1,9 @@
 // ESP32-S3 Trailer Lighting Test Box (TLTB)
 // Run Status page, interactive OPEN/SHORT popups (Back=Cancel, OK=Enable),
-// "Back" wording, Wi-Fi scan/select/password UI, OTA (GitHub),
+// "Back" wording, Wi-Fi scan/select/password UI, background OTA (GitHub: delta, gzip or full image) with progress/cancel,
 // TFT + encoder + Back button, Relays with pulse-test + OCP/open/short,
 // INA226 (load current), INA226 (source voltage LVP), CC1101 RF (learn 6 buttons), buzzer, NVS prefs.
+// Runs as three pinned FreeRTOS tasks: protection (core 1), UI + network (core 0).
 
 #include <Arduino.h>
 #include <Wire.h>
@@ -10,15 +11,32 @@
 #include <WebServer.h>
 #include <Preferences.h>
 #include <WiFiClientSecure.h>
-#include <HTTPUpdate.h>
+#include <HTTPClient.h>
+#include <mbedtls/sha256.h>
 #include <Adafruit_GFX.h>
 #include <Adafruit_ST7735.h>
 #include <ELECHOUSE_CC1101_SRC_DRV.h>
+#include <soc/gpio_reg.h>
+#include <driver/spi_master.h>
+#include <esp_timer.h>
+#include <esp_ota_ops.h>
+#include <atomic>
+#include "ina226_regs.h"
+#include "spsc_queue.h"
+#include "inrush.h"
+#include "rf_decode.h"
+#include "rf_codes.h"
+#include "latency.h"
+#include "sha256.h"
+#include "ota_manifest.h"
+#include "inflate.h"
+#include "delta_patch.h"
 
 // ------------------- Pin Map -------------------
-static constexpr int PIN_FSPI_SCK  = 36;
-static constexpr int PIN_FSPI_MOSI = 35;
-static constexpr int PIN_FSPI_MISO = 37;
+// FSPI goes through the GPIO matrix; it must stay off the rotary's bank-1 run
+static constexpr int PIN_FSPI_SCK  = 6;
+static constexpr int PIN_FSPI_MOSI = 15;
+static constexpr int PIN_FSPI_MISO = 1;
 
 static constexpr int PIN_TFT_CS   = 5;
 static constexpr int PIN_TFT_DC   = 2;
@@ -60,14 +78,31 @@ static constexpr int PIN_BUZZER = 27;
 #ifndef OTA_LATEST_ASSET_URL
 #define OTA_LATEST_ASSET_URL "https://github.com/53Aries/TLTB_OTA/releases/latest/download/firmware.bin"
 #endif
+#ifndef OTA_GZ_ASSET_URL   // same image, gzip with a 4 KB window (tools/ota_pack.py); tried first
+#define OTA_GZ_ASSET_URL "https://github.com/53Aries/TLTB_OTA/releases/latest/download/firmware.bin.gz"
+#endif
+#ifndef OTA_DELTA_URL_PREFIX  // + 16 hex of the running image's SHA-256 + ".gz" (tools/ota_delta.py); tried before both
+#define OTA_DELTA_URL_PREFIX "https://github.com/53Aries/TLTB_OTA/releases/latest/download/delta-"
+#endif
+#ifndef OTA_MANIFEST_URL   // {"version","size","sha256"} of the asset above (tools/ota_manifest.py)
+#define OTA_MANIFEST_URL "https://github.com/53Aries/TLTB_OTA/releases/latest/download/firmware.json"
+#endif
+#ifndef FW_VERSION         // release builds set it; the manifest names the version it carries
+#define FW_VERSION "dev"
+#endif
 
 // ------------------- INA226 Config -------------------
 // Load-side INA226 (existing)
 static float OCP_LIMIT_A   = 20.0f;     // editable via menu
 static constexpr float SHUNT_OHMS    = 0.0025f; // 2.5 mΩ (30A/75mV)
 static constexpr float CURRENT_LSB_A = 0.001f;  // 1 mA/bit
-static constexpr float FAST_SHORT_A  = 40.0f;   // instant trip
+static constexpr float FAST_SHORT_A  = 30.0f;   // instant trip; must stay under the 81.92 mV shunt full scale (32.7 A),
+                                                // the SOL limit register is signed like the shunt register
 static constexpr float OPEN_THRESH_A = 0.15f;   // open load detect
+// Averaging / conversion time per sensor (see inaConversionUs() for the resulting period)
+static constexpr InaProfile INA_PROFILE_LOAD = {INA_AVG_16, INA_CT_1100US, INA_CT_1100US, INA_MODE_SHUNT_BUS_CONT}; // ~35 ms
+static constexpr InaProfile INA_PROFILE_SRC  = {INA_AVG_16, INA_CT_1100US, INA_CT_1100US, INA_MODE_BUS_CONT};       // ~18 ms, VBUS only
+static constexpr InaProfile INA_PROFILE_INRUSH = {INA_AVG_1, INA_CT_140US, INA_CT_140US, INA_MODE_SHUNT_CONT};    // 140 us, pulse capture
 
 // Source-side INA226 (new) for 18V battery LVP
 static float LV_CUTOFF_V = 15.5f;              // editable via menu (Milwaukee M18 under-load safe limit)
@@ -76,12 +111,16 @@ static bool   lvpActive = false;               // latched until release threshol
 
 // ------------------- Timings -------------------
 static constexpr uint32_t PULSE_MS        = 80;
-static constexpr uint32_t POST_PULSE_MS   = 40;
+static constexpr uint32_t SCAN_GAP_MS     = 10;   // relay release time between scan channels
 static constexpr uint32_t DOUBLE_PRESS_MS = 500;
+static uint32_t VERIFY_TTL_MS             = 30000; // cached OK skips the pulse this long (0 = always pulse)
+static constexpr uint32_t VERIFY_WATCH_MS = 250;   // background open-load check after a cached engage
 
 // ------------------- TFT -------------------
 SPIClass spiTFT(FSPI);
-Adafruit_ST7735 tft(PIN_TFT_CS, PIN_TFT_DC, PIN_TFT_RST);
+Adafruit_ST7735 tftPanel(PIN_TFT_CS, PIN_TFT_DC, PIN_TFT_RST);   // boot init only; then fbFlusherTask over spi_master
+static constexpr int16_t  TFT_W = 160, TFT_H = 128;                // after setRotation(1)
+static constexpr uint32_t FRAME_MIN_MS = 33;                       // present() cap, ~30 fps
 
 // ------------------- Preferences -------------------
 Preferences prefs;
@@ -95,29 +134,295 @@ static const char* KEY_WIFI_PASS = "wifi_pass";
 static const char* KEY_OCP       = "ocp";
 static const char* KEY_BRIGHT    = "bright";
 static const char* KEY_LV_CUTOFF = "lv_cut";
+static const char* KEY_VERIFY_TTL = "vfy_ttl";
+static const char* KEY_FLASH_STYLE  = "fl_style";
+static const char* KEY_FLASH_PERIOD = "fl_per";
+static const char* KEY_FLASH_DUTY   = "fl_duty";
+static const char* KEY_OTA_ETAG     = "ota_etag";   // "<FW_VERSION> <ETag>" of the manifest that named this build
 
 // ------------------- Relay Enum -------------------
 enum RelayId { R_NONE=-1, R_LEFT, R_RIGHT, R_BRAKE, R_TAIL, R_MARKER, R_AUX, R_COUNT };
 static const int RELAY_PIN[R_COUNT] = {PIN_RLY_LEFT, PIN_RLY_RIGHT, PIN_RLY_BRAKE, PIN_RLY_TAIL, PIN_RLY_MARKER, PIN_RLY_AUX};
 static bool relayState[R_COUNT] = {false,false,false,false,false,false};
 
-// Labels + Preference keys for RF learn
+// Labels + Preference keys for RF learn (extra fobs append 1..3: "rf_left1")
 static const char* RELAY_LABELS[R_COUNT] = {"LEFT","RIGHT","BRAKE","TAIL","MARKER","AUX"};
 static const char* RF_PREF_KEYS[R_COUNT] = {"rf_left","rf_right","rf_brake","rf_tail","rf_marker","rf_aux"};
+static_assert(R_COUNT <= RfCodeTable::MAX_RELAYS, "RF code table too narrow");
 
 // ------------------- Flash Mode -------------------
-static bool     flashMode   = false;
+static bool     flashMode   = false;   // flasher running; only flashStart()/flashStop() write it
 static RelayId  flashTarget = R_NONE;
+enum FlashStyle : uint8_t { FS_SINGLE, FS_HAZARD, FS_ALTERNATE, FS_COUNT };
+static FlashStyle FLASH_STYLE     = FS_SINGLE;   // HAZARD/ALTERNATE apply to LEFT/RIGHT targets
+static uint16_t   FLASH_PERIOD_MS = 800;         // full on+off cycle
+static uint8_t    FLASH_DUTY_PCT  = 50;
 static RelayId  lastRfRelay = R_NONE;
 
 // ------------------- Buzzer -------------------
-static void buzzerBeep(uint16_t ms=60){ digitalWrite(PIN_BUZZER, HIGH); delay(ms); digitalWrite(PIN_BUZZER, LOW); }
-static void buzzerAlarm(uint16_t ms=800){ digitalWrite(PIN_BUZZER, HIGH); delay(ms); digitalWrite(PIN_BUZZER, LOW); }
+// esp_timer-driven sequencer: callers queue a pattern and return immediately.
+// A higher-priority pattern cuts off the one playing and drops lower queued ones
+// (a fault alarm kills a UI chirp); equal/lower priority waits its turn.
+enum BuzzPrio : uint8_t { BZ_UI=0, BZ_NOTICE=1, BZ_FAULT=2 };
+struct BuzzPattern {
+  uint8_t  prio;
+  uint8_t  steps;      // number of entries used in ms[]
+  uint16_t ms[6];      // on, off, on, off, ... durations
+};
+static const BuzzPattern BUZZ_CHIRP  = {BZ_UI,     1, {30}};
+static const BuzzPattern BUZZ_DOUBLE = {BZ_NOTICE, 3, {50, 60, 50}};
+
+static esp_timer_handle_t buzzTimer = nullptr;
+static portMUX_TYPE       buzzMux   = portMUX_INITIALIZER_UNLOCKED;
+static BuzzPattern        buzzCur;
+static uint8_t            buzzStep  = 0;
+static bool               buzzBusy  = false;
+static BuzzPattern        buzzPend[4];
+static uint8_t            buzzPendN = 0;
+static int64_t            buzzDueUs = 0;   // when the armed edge is due; older callbacks are stale
+static bool               buzzInGap = false;
+static constexpr uint16_t BUZZ_GAP_MS = 40;   // silence before a queued pattern, so two beeps stay two
+
+// Caller holds buzzMux. Drives the pin for step buzzStep and arms the next edge.
+static void buzzApplyStepLocked(){
+  if (buzzStep >= buzzCur.steps){
+    digitalWrite(PIN_BUZZER, LOW);
+    if (!buzzPendN){ buzzBusy = false; return; }
+    if (!buzzInGap){
+      buzzInGap = true;
+      buzzDueUs = esp_timer_get_time() + (int64_t)BUZZ_GAP_MS * 1000;
+      esp_timer_start_once(buzzTimer, (uint64_t)BUZZ_GAP_MS * 1000ULL);
+      return;
+    }
+    buzzInGap = false;
+    buzzCur = buzzPend[0];
+    for (uint8_t i=1;i<buzzPendN;i++) buzzPend[i-1] = buzzPend[i];
+    buzzPendN--; buzzStep = 0;
+  }
+  digitalWrite(PIN_BUZZER, (buzzStep & 1) ? LOW : HIGH);
+  buzzDueUs = esp_timer_get_time() + (int64_t)buzzCur.ms[buzzStep] * 1000;
+  esp_timer_start_once(buzzTimer, (uint64_t)buzzCur.ms[buzzStep] * 1000ULL);
+}
+
+static void buzzTimerCb(void*){
+  portENTER_CRITICAL(&buzzMux);
+  // A preempting buzzerPlay() may have re-armed us while this callback was in flight
+  if (buzzBusy && esp_timer_get_time() + 500 >= buzzDueUs){
+    buzzStep++;
+    buzzApplyStepLocked();
+  }
+  portEXIT_CRITICAL(&buzzMux);
+}
+
+static void buzzerInit(){
+  const esp_timer_create_args_t args = { buzzTimerCb, nullptr, ESP_TIMER_TASK, "buzz", false };
+  esp_timer_create(&args, &buzzTimer);
+}
+
+static void buzzerPlay(const BuzzPattern& p){
+  if (!buzzTimer || !p.steps) return;
+  portENTER_CRITICAL(&buzzMux);
+  if (!buzzBusy || p.prio > buzzCur.prio){
+    esp_timer_stop(buzzTimer);
+    uint8_t n=0;   // keep only queued patterns at least as urgent as the newcomer
+    for (uint8_t i=0;i<buzzPendN;i++) if (buzzPend[i].prio >= p.prio) buzzPend[n++] = buzzPend[i];
+    buzzPendN = n;
+    buzzCur = p; buzzStep = 0; buzzBusy = true; buzzInGap = false;
+    buzzApplyStepLocked();
+  } else if (buzzPendN < sizeof(buzzPend)/sizeof(buzzPend[0])){
+    buzzPend[buzzPendN++] = p;
+  }
+  portEXIT_CRITICAL(&buzzMux);
+}
+
+static void buzzerBeep(uint16_t ms=60){ buzzerPlay(BuzzPattern{BZ_UI, 1, {ms}}); }
+static void buzzerAlarm(uint16_t ms=800){ buzzerPlay(BuzzPattern{BZ_FAULT, 1, {ms}}); }
 
 // ------------------- Relay Helpers -------------------
 static inline void relayOn(RelayId r){ if(r>=0&&r<R_COUNT){ digitalWrite(RELAY_PIN[r],HIGH); relayState[r]=true; } }
 static inline void relayOff(RelayId r){ if(r>=0&&r<R_COUNT){ digitalWrite(RELAY_PIN[r],LOW);  relayState[r]=false;} }
-static inline void relayOffAll(){ for(int i=0;i<R_COUNT;i++) relayOff((RelayId)i); }
+// Bumped whenever everything is dropped: a fault popup answered after that is stale
+static volatile uint32_t relayEpoch = 0;
+static inline void relayOffAll(){ for(int i=0;i<R_COUNT;i++) relayOff((RelayId)i); relayEpoch = relayEpoch + 1; }
+
+// ------------------- Hard OCP trip (INA226 ALERT ISR) -------------------
+// ALERT falling edge drops every relay from the ISR with a single W1TC store,
+// independent of whatever the UI is blocked in. The loop drains the record.
+struct OcpFault {
+  uint32_t tAlertUs;     // micros() at ISR entry
+  uint32_t latencyCyc;   // CPU cycles from ISR entry to relay outputs cleared
+  uint8_t  relayMask;    // bit i set = RELAY_PIN[i] was driven at trip
+};
+static QueueHandle_t     ocpFaultQ      = nullptr;
+static uint32_t          relayOutMask   = 0;     // GPIO 0..31 bits for RELAY_PIN[]
+static uint32_t          relayOut1Mask  = 0;     // GPIO 32..48 bits (none on current board)
+static uint32_t          relayOutBit[R_COUNT];   // DRAM copy of RELAY_PIN[] bits (ISR may run with flash cache off)
+static volatile bool     ocpTripLatched = false; // set by ISR, cleared by ocpService()
+static volatile uint32_t ocpTripCount   = 0;
+static OcpFault          ocpLastFault   = {};    // newest record ocpService() drained (Diagnostics)
+
+// Forced inline so the ISR copy stays in IRAM
+static inline __attribute__((always_inline)) void ocpDropAll(OcpFault& f){
+  uint32_t c0 = ESP.getCycleCount();
+  // Latch first: a flasher edge on the other core re-checks it after its W1TS,
+  // so either it sees the latch or this W1TC lands after its store
+  ocpTripLatched = true;
+  uint32_t out = REG_READ(GPIO_OUT_REG);
+  REG_WRITE(GPIO_OUT_W1TC_REG, relayOutMask);
+  if (relayOut1Mask) REG_WRITE(GPIO_OUT1_W1TC_REG, relayOut1Mask);
+  uint32_t c1 = ESP.getCycleCount();
+
+  f.tAlertUs   = micros();
+  f.latencyCyc = c1 - c0;
+  f.relayMask  = 0;
+  for (int i=0;i<R_COUNT;i++) if (out & relayOutBit[i]) f.relayMask |= (1u << i);
+
+  ocpTripCount = ocpTripCount + 1;
+}
+
+static void IRAM_ATTR ocpAlertIsr(){
+  OcpFault f;
+  ocpDropAll(f);
+  BaseType_t woke = pdFALSE;
+  xQueueSendFromISR(ocpFaultQ, &f, &woke);
+  if (woke) portYIELD_FROM_ISR();
+}
+
+static void ocpInit(){
+  relayOutMask = relayOut1Mask = 0;
+  for (int i=0;i<R_COUNT;i++){
+    relayOutBit[i] = (RELAY_PIN[i] < 32) ? (1u << RELAY_PIN[i]) : 0;
+    if (RELAY_PIN[i] < 32) relayOutMask  |= relayOutBit[i];
+    else                   relayOut1Mask |= (1u << (RELAY_PIN[i] - 32));
+  }
+  if (!ocpFaultQ) ocpFaultQ = xQueueCreate(4, sizeof(OcpFault));
+  attachInterrupt(digitalPinToInterrupt(PIN_INA_ALERT), ocpAlertIsr, FALLING);
+}
+
+static void flashStop();
+
+// Drain pending trip records and resync relayState[] with what the ISR cleared.
+// Returns number of records consumed; the newest is copied to *last.
+static int ocpConsume(OcpFault* last=nullptr){
+  OcpFault f; int n=0;
+  while (ocpFaultQ && xQueueReceive(ocpFaultQ, &f, 0)==pdTRUE){ if (last) *last=f; n++; }
+  if (n){
+    flashStop();   // before the latch drops, or the next edge would re-energize the fault
+    for(int i=0;i<R_COUNT;i++) relayState[i]=false;
+    relayEpoch = relayEpoch + 1;
+    ocpTripLatched=false;
+  }
+  return n;
+}
+
+// ------------------- Flasher (esp_timer) -------------------
+// Edges fire from an esp_timer at deadlines taken off one anchor, so the
+// cadence neither drifts nor depends on what any task is doing. Group A is on
+// for the first flashOnUs of each period and group B the same, half a period
+// later: hazards are A=LEFT|RIGHT, alternating is A=LEFT, B=RIGHT. Each edge
+// switches the whole set with one W1TC and one W1TS store.
+struct FlashPattern { uint8_t maskA, maskB; };   // bit i = RelayId i
+
+static esp_timer_handle_t flashTimer = nullptr;
+static portMUX_TYPE       flashMux   = portMUX_INITIALIZER_UNLOCKED;
+static FlashPattern       flashPat   = {0, 0};
+static uint32_t           flashPeriodUs = 0, flashOnUs = 0;
+static int64_t            flashAnchorUs = 0;
+static uint8_t            flashLit = 0;          // relays the flasher has on right now
+static volatile uint32_t  flashEdges = 0;        // output changes, for status redraws
+
+static FlashPattern flashPatternFor(RelayId t){
+  bool turn = (t == R_LEFT || t == R_RIGHT);
+  if (turn && FLASH_STYLE == FS_HAZARD)    return FlashPattern{(uint8_t)((1u << R_LEFT) | (1u << R_RIGHT)), 0};
+  if (turn && FLASH_STYLE == FS_ALTERNATE) return FlashPattern{(uint8_t)(1u << R_LEFT), (uint8_t)(1u << R_RIGHT)};
+  return FlashPattern{(uint8_t)(1u << t), 0};
+}
+
+static uint8_t flashMaskAt(uint32_t ph){
+  uint8_t m = 0;
+  if (ph < flashOnUs) m |= flashPat.maskA;
+  if ((ph + flashPeriodUs - flashPeriodUs/2) % flashPeriodUs < flashOnUs) m |= flashPat.maskB;
+  return m;
+}
+
+// First edge after phase ph (flashPeriodUs = start of the next period)
+static uint32_t flashNextEdge(uint32_t ph){
+  uint32_t half = flashPeriodUs / 2;
+  uint32_t e[3] = {flashOnUs, half, (half + flashOnUs) % flashPeriodUs};
+  uint32_t best = flashPeriodUs;
+  for (uint8_t i = 0; i < (flashPat.maskB ? 3 : 1); i++) if (e[i] > ph && e[i] < best) best = e[i];
+  return best;
+}
+
+// Caller holds flashMux
+static void flashDriveLocked(uint8_t want){
+  uint8_t all = flashPat.maskA | flashPat.maskB;
+  uint32_t set = 0, clr = 0;
+  for (int i=0;i<R_COUNT;i++){
+    if (!(all & (1u << i))) continue;
+    bool on = want & (1u << i);
+    if (relayOutBit[i]) (on ? set : clr) |= relayOutBit[i];
+    else digitalWrite(RELAY_PIN[i], on ? HIGH : LOW);
+    relayState[i] = on;
+  }
+  if (clr) REG_WRITE(GPIO_OUT_W1TC_REG, clr);
+  if (set){
+    REG_WRITE(GPIO_OUT_W1TS_REG, set);
+    // The ALERT ISR may have tripped since flashTimerCb() looked: undo
+    if (ocpTripLatched) REG_WRITE(GPIO_OUT_W1TC_REG, set);
+  }
+  if (want != flashLit) flashEdges = flashEdges + 1;
+  flashLit = want;
+}
+
+static void flashTickLocked(){
+  uint32_t ph = (uint32_t)((esp_timer_get_time() - flashAnchorUs) % flashPeriodUs);
+  flashDriveLocked(flashMaskAt(ph));
+  esp_timer_start_once(flashTimer, flashNextEdge(ph) - ph);
+}
+
+static void flashStopLocked(){
+  if (!flashMode) return;
+  esp_timer_stop(flashTimer);
+  flashMode = false;
+  flashDriveLocked(0);
+}
+
+static void flashTimerCb(void*){
+  portENTER_CRITICAL(&flashMux);
+  if (flashMode){
+    if (ocpTripLatched || lvpActive) flashStopLocked();   // never re-light into a fault
+    else flashTickLocked();
+  }
+  portEXIT_CRITICAL(&flashMux);
+}
+
+static void flashInit(){
+  if (flashTimer) return;
+  const esp_timer_create_args_t args = { flashTimerCb, nullptr, ESP_TIMER_TASK, "flash", false };
+  esp_timer_create(&args, &flashTimer);
+}
+
+static void flashStop(){
+  portENTER_CRITICAL(&flashMux);
+  flashStopLocked();
+  portEXIT_CRITICAL(&flashMux);
+}
+
+// (Re)start on target with the current style/period/duty; phase restarts lit
+static void flashStart(RelayId target){
+  if (target == R_NONE || !flashTimer || lvpActive || ocpTripLatched) return;
+  portENTER_CRITICAL(&flashMux);
+  flashStopLocked();
+  flashTarget   = target;
+  flashPat      = flashPatternFor(target);
+  flashPeriodUs = (uint32_t)max((uint16_t)100, FLASH_PERIOD_MS) * 1000u;
+  flashOnUs     = flashPeriodUs / 100 * max((uint8_t)5, min(FLASH_DUTY_PCT, (uint8_t)95));
+  flashAnchorUs = esp_timer_get_time();
+  flashMode     = true;
+  flashTickLocked();
+  portEXIT_CRITICAL(&flashMux);
+}
 
 // ------------------- Name Helpers -------------------
 static const char* relayName(RelayId r){
@@ -133,100 +438,550 @@ static const char* relayName(RelayId r){
 }
 static RelayId currentActiveRelay(){ for(int i=0;i<R_COUNT;i++) if(relayState[i]) return (RelayId)i; return R_NONE; }
 
+// ------------------- Task layout + inter-task messages -------------------
+// core 1: protection (OCP/LVP/relays/rotary/RF/flash), alone so its timing never waits on SPI or TLS
+// core 0: UI (TFT, encoder, menus) above network (Wi-Fi, OTA, WebServer)
+// Each direction is its own SPSC ring, so no task ever takes a lock to talk to another.
+static constexpr BaseType_t  CORE_PROT = 1, CORE_UI = 0, CORE_NET = 0;
+static constexpr UBaseType_t PRIO_PROT = 5, PRIO_UI = 2, PRIO_NET = 1;
+static constexpr UBaseType_t PRIO_SAMPLER = 6;   // INA226 sampler, on CORE_PROT
+static constexpr uint32_t    PROT_PERIOD_MS = 2;
+
+enum FaultType { FAULT_OPEN=0, FAULT_SHORT=1, FAULT_LVP=2, FAULT_MISSED=3, FAULT_OCP=4 };
+
+enum ProtCmdType : uint8_t {
+  PC_FORCE_ON,      // user chose "OK = Enable" on an OPEN/SHORT popup
+  PC_OFF_ALL,       // menu "All Relays OFF" (also stops flash)
+  PC_SET_OCP,       // value = amps
+  PC_SCAN_ALL,      // pulse every channel, stream UE_SCAN_RESULT
+  PC_SCAN_RESTORE,  // scan screen closed: restore pre-scan relay/flash state
+  PC_FLASH_CFG,     // flash style/period/duty changed: restart a running flasher
+  PC_ENGAGE_SET,    // value = relay bitmask, brought up staggered (engageSet)
+};
+struct ProtCmd { ProtCmdType type; int8_t relay; float value; uint32_t epoch; };   // epoch: PC_FORCE_ON
+
+enum UiEvtType : uint8_t {
+  UE_FAULT,         // code = FaultType, relay = channel, arg = relayEpoch; show choice popup
+                    // FAULT_OCP: mask = relays on at the trip, arg = cycles to drop them
+  UE_SCAN_RESULT,   // relay = channel, code = scan result, arg = channel time (us)
+  UE_SCAN_DONE,     // code = 1 if aborted by LVP, arg = whole scan (us)
+};
+struct UiEvt { UiEvtType type; int8_t relay; uint8_t code; uint32_t arg; uint8_t mask; };
+
+enum NetCmdType : uint8_t { NC_CONNECT, NC_FORGET, NC_OTA };
+struct NetCmd { NetCmdType type; char ssid[33]; char pass[65]; };
+
+enum NetEvtType : uint8_t { NE_CONNECT_RESULT, NE_OTA_RESULT };
+struct NetEvt { NetEvtType type; int32_t code; };   // code: 1/0 for connect, esp_err_t for OTA
+
+static SpscQueue<ProtCmd, 8>  uiToProt;
+static SpscQueue<UiEvt, 16>   protToUi;     // scan results
+static SpscQueue<UiEvt, 16>   faultToUi;    // UE_FAULT only; drained from modal screens too
+static SpscQueue<NetCmd, 4>   uiToNet;
+static SpscQueue<NetEvt, 4>   netToUi;
+
+static volatile bool rfLearning = false;   // Learn Remote wants codes, not actions
+struct RfHeard { uint32_t code; uint8_t proto; };   // proto 0 = burst hash
+static SpscQueue<RfHeard, 4> rfLearnQ;     // prot -> UI: codes heard while learning
+
+// Status is a flag, not a queue entry: flash edges and LVP readings would
+// otherwise fill the rings while a modal screen isn't draining them.
+static volatile bool uiStatusDirty = false;
+static volatile bool uiFaultsLost  = false;   // faultToUi was full; the UI says so
+
+static inline void postUi(UiEvtType t, int8_t relay=R_NONE, uint8_t code=0, uint32_t arg=0){ protToUi.push(UiEvt{t, relay, code, arg, 0}); }
+static inline void postFault(FaultType f, int8_t relay){
+  if (!faultToUi.push(UiEvt{UE_FAULT, relay, (uint8_t)f, relayEpoch, 0})) uiFaultsLost = true;
+}
+static inline void notifyStatus(){ uiStatusDirty = true; }
+static inline void sendProt(ProtCmdType t, int8_t relay=R_NONE, float value=0, uint32_t epoch=0){ uiToProt.push(ProtCmd{t, relay, value, epoch}); }
+
+// ------------------- Latency instrumentation -------------------
+// Services are timed with the cycle counter (each task is pinned, so start and
+// stop read the same core's CCOUNT). Modal screens can outlast a CCOUNT wrap
+// (~18 s at 240 MHz) and use esp_timer instead. Each probe is written by one
+// task only; the worst-stall record is shared and takes latMux.
+enum LatProbe : uint8_t {
+  LP_OCP, LP_LVP, LP_RF, LP_FLASH, LP_PROT_LOOP,            // protection task
+  LP_TELEMETRY, LP_UI_LOOP,                                 // UI task
+  LP_FAULT_POPUP, LP_SCAN_ALL, LP_WIFI_SCAN, LP_WIFI_FORGET, // modal screens
+  LP_OTA, LP_LEARN, LP_SET_OCP, LP_SET_LVP, LP_SET_TTL, LP_BRIGHTNESS, LP_FLASH_CFG, LP_DIAG,
+  LP_COUNT,
+  LP_FIRST_MODAL = LP_FAULT_POPUP,
+  LP_NONE = 0xFF,
+};
+static const char* const LAT_NAME[LP_COUNT] = {
+  "ocp", "lvp", "rf", "flash", "prot",
+  "telem", "ui",
+  "fault", "scanall", "wifi", "wififorg",
+  "ota", "learn", "set ocp", "set lvp", "set ttl", "bright", "flashcfg", "diag",
+};
+
+static LatencyHist latHist[LP_COUNT];
+struct LatStall { uint8_t probe; uint32_t us; uint32_t atMs; };
+static LatStall     latWorst = {LP_NONE, 0, 0};   // worst single service run (not loops, not modals)
+static portMUX_TYPE latMux = portMUX_INITIALIZER_UNLOCKED;
+
+static void latRecord(LatProbe p, uint32_t us){
+  latHist[p].record(us);
+  if (p >= LP_FIRST_MODAL || p == LP_PROT_LOOP || p == LP_UI_LOOP || us <= latWorst.us) return;
+  portENTER_CRITICAL(&latMux);
+  if (us > latWorst.us) latWorst = LatStall{p, us, millis()};
+  portEXIT_CRITICAL(&latMux);
+}
+static inline uint32_t latCycToUs(uint32_t cyc){ return cyc / getCpuFrequencyMhz(); }
+static inline void latTime(LatProbe p, void (*fn)()){
+  uint32_t c0 = ESP.getCycleCount();
+  fn();
+  latRecord(p, latCycToUs(ESP.getCycleCount() - c0));
+}
+static inline void latTimeSince(LatProbe p, int64_t t0Us){
+  latRecord(p, (uint32_t)(esp_timer_get_time() - t0Us));
+}
+
+// "850u", "12.5m", "3.2s": fits the 26-column diagnostics page
+static const char* latFmt(uint32_t us, char* buf, size_t n){
+  if (us < 1000)          snprintf(buf, n, "%luu", (unsigned long)us);
+  else if (us < 1000000)  snprintf(buf, n, "%.1fm", us / 1000.0f);
+  else                    snprintf(buf, n, "%.1fs", us / 1000000.0f);
+  return buf;
+}
+
+// Subsystem counters: under the latency rows on the Diagnostics page and at
+// the end of the 'l' dump. diagRow() sits with the page, after what it reads.
+enum DiagRow : uint8_t { DR_OCP, DR_RUN, DR_FB, DR_FB_PX, DR_I2C, DR_RF, DR_RF_LOST, DR_RF_TRUNC, DR_RF_LAT, DR_ENGAGE, DR_COUNT };
+static void diagRow(uint8_t row, char* buf, size_t n);
+
+static void latDump(){
+  Serial.printf("[LAT] %-8s %8s %8s %8s %8s %8s  (us)\n", "probe", "n", "p50", "p99", "mean", "max");
+  for (int p=0;p<LP_COUNT;p++){
+    const LatencyHist& h = latHist[p];
+    if (!h.count()) continue;
+    Serial.printf("[LAT] %-8s %8lu %8lu %8lu %8lu %8lu\n", LAT_NAME[p], (unsigned long)h.count(),
+                  (unsigned long)h.percentileUs(50), (unsigned long)h.percentileUs(99),
+                  (unsigned long)h.meanUs(), (unsigned long)h.maxUs());
+  }
+  for (int p=0;p<LP_COUNT;p++){
+    const LatencyHist& h = latHist[p];
+    if (!h.count()) continue;
+    char line[256]; size_t len = 0;
+    for (uint8_t b=0;b<LatencyHist::BUCKETS && len<sizeof(line);b++){
+      if (!h.bucket(b)) continue;
+      if (b < LatencyHist::BUCKETS-1)
+        len += snprintf(line+len, sizeof(line)-len, " <%lu:%lu", (unsigned long)LatencyHist::EDGE_US[b], (unsigned long)h.bucket(b));
+      else
+        len += snprintf(line+len, sizeof(line)-len, " >=%lu:%lu", (unsigned long)LatencyHist::EDGE_US[b-1], (unsigned long)h.bucket(b));
+    }
+    Serial.printf("[LAT] %-8s%s\n", LAT_NAME[p], line);
+  }
+  if (latWorst.probe != LP_NONE)
+    Serial.printf("[LAT] worst stall: %s %lu us at %lu ms\n", LAT_NAME[latWorst.probe],
+                  (unsigned long)latWorst.us, (unsigned long)latWorst.atMs);
+  for (uint8_t d=0;d<DR_COUNT;d++){
+    char row[32];
+    diagRow(d, row, sizeof(row));
+    Serial.printf("[LAT] %s\n", row);
+  }
+}
+
+static void latClear(){
+  for (int p=0;p<LP_COUNT;p++) latHist[p].clear();
+  portENTER_CRITICAL(&latMux);
+  latWorst = LatStall{LP_NONE, 0, 0};
+  portEXIT_CRITICAL(&latMux);
+}
+
+// 'l' on the console dumps, 'L' dumps and clears; 'o' dumps the last OTA's stage times
+static void otaStatsDump();
+static void latSerialService(){
+  while (Serial.available() > 0){
+    int c = Serial.read();
+    if (c == 'o') otaStatsDump();
+    if (c == 'l' || c == 'L') latDump();
+    if (c == 'L'){ latClear(); Serial.println("[LAT] cleared"); }
+  }
+}
+
+// ------------------- TFT framebuffer (double-buffered) -------------------
+// The UI draws into 'tft', an off-screen RGB565 canvas that records dirty
+// rectangles. tftPresent() copies just those rects, in panel byte order, into
+// the front buffer and hands them to the flusher task. The CC1101 is only
+// configured at boot, so after that fbInit() takes FSPI from Arduino's
+// SPIClass and drives the panel through spi_master: the flusher queues each
+// rect as DMA transactions and sleeps until they finish, so the wire time
+// costs no CPU on any task.
+static constexpr uint8_t FB_MAX_RECTS = 8;
+struct FbRect { int16_t x, y, w, h; };
+
+class FrameCanvas : public GFXcanvas16 {
+public:
+  FrameCanvas(uint16_t w, uint16_t h) : GFXcanvas16(w, h) {}
+
+  void drawPixel(int16_t x, int16_t y, uint16_t c) override { GFXcanvas16::drawPixel(x, y, c); markDirty(x, y, 1, 1); }
+  void fillScreen(uint16_t c) override { GFXcanvas16::fillScreen(c); markDirty(0, 0, width(), height()); }
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t c) override { GFXcanvas16::drawFastVLine(x, y, h, c); markDirty(x, y, 1, h); }
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t c) override { GFXcanvas16::drawFastHLine(x, y, w, c); markDirty(x, y, w, 1); }
+
+  // Hand the dirty list to the caller and start a fresh one
+  uint8_t takeDirty(FbRect* out){
+    uint8_t n = nDirty;
+    memcpy(out, dirty, n * sizeof(FbRect));
+    nDirty = 0;
+    return n;
+  }
+  bool isDirty() const { return nDirty != 0; }
+  void markAll(){ markDirty(0, 0, width(), height()); }
+
+private:
+  FbRect  dirty[FB_MAX_RECTS];
+  uint8_t nDirty = 0;
+
+  void markDirty(int16_t x, int16_t y, int16_t w, int16_t h){
+    if (x < 0){ w += x; x = 0; }
+    if (y < 0){ h += y; y = 0; }
+    if (x + w > width())  w = width()  - x;
+    if (y + h > height()) h = height() - y;
+    if (w <= 0 || h <= 0) return;
+    // Grow a touching/overlapping rect, else append; when full, fold into the last
+    for (uint8_t i=0;i<nDirty;i++){
+      FbRect& r = dirty[i];
+      if (x <= r.x + r.w && r.x <= x + w && y <= r.y + r.h && r.y <= y + h){ unite(r, x, y, w, h); return; }
+    }
+    if (nDirty < FB_MAX_RECTS) dirty[nDirty++] = FbRect{x, y, w, h};
+    else unite(dirty[FB_MAX_RECTS-1], x, y, w, h);
+  }
+  static void unite(FbRect& r, int16_t x, int16_t y, int16_t w, int16_t h){
+    int16_t x1 = max<int16_t>(r.x + r.w, x + w), y1 = max<int16_t>(r.y + r.h, y + h);
+    r.x = min(r.x, x); r.y = min(r.y, y);
+    r.w = x1 - r.x;    r.h = y1 - r.y;
+  }
+};
+static FrameCanvas tft(TFT_W, TFT_H);
+
+static uint16_t*       fbFront   = nullptr;     // what the flusher is (or was last) streaming
+static FbRect          fbJob[FB_MAX_RECTS];
+static uint8_t         fbJobN    = 0;
+static volatile bool   fbBusy    = false;
+static TaskHandle_t    fbTask    = nullptr;
+static uint32_t        fbLastPresentMs = 0;
+
+static constexpr int      FB_SPI_HZ    = 40000000;
+static constexpr uint8_t  FB_SPI_QUEUE = 8;          // transactions in flight
+static_assert(PIN_TFT_DC < 32, "fbSpiPreCb drives DC through GPIO_OUT_W1TS/W1TC");
+static spi_device_handle_t fbSpi = nullptr;
+static spi_transaction_t   fbTrans[FB_SPI_QUEUE];
+static uint8_t             fbTransNext = 0, fbTransBusy = 0;
+
+// Runs from the SPI ISR as each transaction starts: user = 1 for data, 0 for a command
+static void IRAM_ATTR fbSpiPreCb(spi_transaction_t* t){
+  REG_WRITE(t->user ? GPIO_OUT_W1TS_REG : GPIO_OUT_W1TC_REG, 1u << PIN_TFT_DC);
+}
+
+// Queue n bytes. With every slot in flight, reap the oldest first: results come back in order.
+static void fbSpiQueue(const void* p, size_t n, bool data){
+  spi_transaction_t* done;
+  if (fbTransBusy == FB_SPI_QUEUE){ spi_device_get_trans_result(fbSpi, &done, portMAX_DELAY); fbTransBusy--; }
+  spi_transaction_t& t = fbTrans[fbTransNext];
+  fbTransNext = (fbTransNext + 1) % FB_SPI_QUEUE;
+  t = spi_transaction_t{};
+  t.length = n * 8;
+  t.user   = (void*)(uintptr_t)data;
+  if (n <= sizeof(t.tx_data)){ t.flags = SPI_TRANS_USE_TXDATA; memcpy(t.tx_data, p, n); }
+  else t.tx_buffer = p;
+  spi_device_queue_trans(fbSpi, &t, portMAX_DELAY);
+  fbTransBusy++;
+}
+
+static void fbSpiDrain(){
+  spi_transaction_t* done;
+  while (fbTransBusy){ spi_device_get_trans_result(fbSpi, &done, portMAX_DELAY); fbTransBusy--; }
+}
+
+// CASET/RASET/RAMWR (the black-tab panel has no row/column offset)
+static void fbSpiWindow(const FbRect& r){
+  static const uint8_t CASET = 0x2A, RASET = 0x2B, RAMWR = 0x2C;
+  uint16_t x1 = r.x + r.w - 1, y1 = r.y + r.h - 1;
+  const uint8_t cols[4] = {(uint8_t)(r.x >> 8), (uint8_t)r.x, (uint8_t)(x1 >> 8), (uint8_t)x1};
+  const uint8_t rows[4] = {(uint8_t)(r.y >> 8), (uint8_t)r.y, (uint8_t)(y1 >> 8), (uint8_t)y1};
+  fbSpiQueue(&CASET, 1, false); fbSpiQueue(cols, 4, true);
+  fbSpiQueue(&RASET, 1, false); fbSpiQueue(rows, 4, true);
+  fbSpiQueue(&RAMWR, 1, false);
+}
+
+// Frame timing: present() handoff to last pixel on the wire. The flusher keeps
+// the running sums and publishes a one-second window; it wakes at least that
+// often so an idle screen reads 0 fps.
+static uint32_t fbFps = 0, fbFrameUsAvg = 0, fbFrameUsPeak = 0, fbPxPerSec = 0;
+
+static void fbFlusherTask(void*){
+  uint32_t frames = 0, usSum = 0, usMax = 0, pxSum = 0, winStart = millis();
+  for (;;){
+    bool job = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+    if (millis() - winStart >= 1000){
+      fbFps = frames; fbPxPerSec = pxSum;
+      fbFrameUsAvg  = frames ? usSum / frames : 0;
+      fbFrameUsPeak = usMax;
+      frames = usSum = usMax = pxSum = 0;
+      winStart = millis();
+    }
+    if (!job) continue;
+    int64_t t0 = esp_timer_get_time();
+    uint32_t px = 0;
+    for (uint8_t i=0;i<fbJobN;i++){
+      const FbRect& r = fbJob[i];
+      fbSpiWindow(r);
+      if (r.w == TFT_W) fbSpiQueue(&fbFront[r.y * TFT_W], (size_t)r.w * r.h * sizeof(uint16_t), true);   // one run
+      else for (int16_t row=0; row<r.h; row++)
+        fbSpiQueue(&fbFront[(r.y + row) * TFT_W + r.x], r.w * sizeof(uint16_t), true);
+      px += (uint32_t)r.w * r.h;
+    }
+    fbSpiDrain();
+    uint32_t us = (uint32_t)(esp_timer_get_time() - t0);
+    frames++; usSum += us; pxSum += px;
+    if (us > usMax) usMax = us;
+    fbBusy = false;
+  }
+}
+
+// After tftPanel.initR() and rfInit(): FSPI belongs to the flusher from here on
+static void fbInit(){
+  fbFront = (uint16_t*)heap_caps_malloc(TFT_W * TFT_H * sizeof(uint16_t), MALLOC_CAP_DMA | MALLOC_CAP_8BIT);
+  if (!fbFront) fbFront = (uint16_t*)ps_malloc(TFT_W * TFT_H * sizeof(uint16_t));
+  tft.fillScreen(ST77XX_BLACK);
+
+  spiTFT.end(); SPI.end();
+  spi_bus_config_t bus = {};
+  bus.mosi_io_num = PIN_FSPI_MOSI; bus.miso_io_num = PIN_FSPI_MISO; bus.sclk_io_num = PIN_FSPI_SCK;
+  bus.quadwp_io_num = bus.quadhd_io_num = -1;
+  bus.max_transfer_sz = TFT_W * TFT_H * sizeof(uint16_t);
+  spi_device_interface_config_t dev = {};
+  dev.mode = 0;
+  dev.clock_speed_hz = FB_SPI_HZ;
+  dev.spics_io_num   = PIN_TFT_CS;
+  dev.queue_size     = FB_SPI_QUEUE;
+  dev.pre_cb         = fbSpiPreCb;
+  if (spi_bus_initialize(SPI2_HOST, &bus, SPI_DMA_CH_AUTO) != ESP_OK ||
+      spi_bus_add_device(SPI2_HOST, &dev, &fbSpi) != ESP_OK){
+    Serial.println("[UI] FSPI DMA init failed, display frozen");
+    return;   // no flusher: tftPresent() stays a no-op
+  }
+  xTaskCreatePinnedToCore(fbFlusherTask, "tftflush", 3072, nullptr, PRIO_UI, &fbTask, CORE_UI);
+}
+
+// Ship pending dirty rects. Rate-capped to FRAME_MIN_MS unless force, which also
+// waits out a frame still in flight so what was just drawn is on the glass.
+static void tftPresent(bool force=false){
+  if (!fbFront || !fbTask || !tft.isDirty()) return;
+  if (fbBusy){
+    if (!force) return;
+    while (fbBusy) delay(1);
+  }
+  if (!force && millis() - fbLastPresentMs < FRAME_MIN_MS) return;
+  fbLastPresentMs = millis();
+
+  fbJobN = tft.takeDirty(fbJob);
+  const uint16_t* back = tft.getBuffer();
+  for (uint8_t i=0;i<fbJobN;i++){
+    const FbRect& r = fbJob[i];
+    for (int16_t row=0; row<r.h; row++){
+      size_t off = (r.y + row) * TFT_W + r.x;
+      for (int16_t k=0; k<r.w; k++) fbFront[off + k] = __builtin_bswap16(back[off + k]);   // panel is big-endian
+    }
+  }
+  fbBusy = true;
+  xTaskNotifyGive(fbTask);
+  if (force) while (fbBusy) delay(1);
+}
+
+static bool uiModal = false;   // a menu action or the scan screen owns the UI task
+static void uiFaultService();
+
+// delay() for UI code: keeps presenting (at the frame cap) while it waits.
+// Inside a modal screen it also raises fault popups, which nothing else would.
+static void uiDelay(uint32_t ms){
+  uint32_t t0 = millis();
+  if (uiModal) uiFaultService();
+  tftPresent();
+  while (millis() - t0 < ms){
+    uint32_t left = ms - (millis() - t0);
+    delay(min(left, FRAME_MIN_MS));
+    if (uiModal) uiFaultService();
+    tftPresent();
+  }
+}
+
 // ------------------- Forward declarations used across sections ---
 static int8_t readEncoderStep();
 static bool   readOkPressed();
 static bool   readKoPressed();               // physical "Back" button
 static bool   okIsDown();
+static inline int wrapIndex(int i, int step, int n){ return ((i + step) % n + n) % n; }
 static void   drawMenu();
 static void   scanAllRelays();
 static void   drawStatusPage(bool force=false);
 static void   refreshStatusIfChanged();
 
 // ------------------- UI: Status (Run) page -------------------
+// Retained mode: each value is a widget that remembers the text on the glass.
+// An update diffs against it and repaints only the changed glyph run, with an
+// opaque background, so nothing is cleared first and nothing flickers.
 static bool uiInMenu = false;
-static RelayId  _lastShownRelay = R_NONE;
-static bool     _lastShownFlash = false;
 static float    _lastShownSrcV  = -1.0f;
-static bool     _lastShownLvp   = false;
 static float    _lastShownLoadA = -1.0f;
 
+static constexpr int16_t GLYPH_W = 6, GLYPH_H = 8;   // built-in 5x7 font, size 1
+static constexpr uint8_t FIELD_MAX = 10;             // longest value ("TRIPPED", "-12.34A")
+
+struct StatusField {
+  const char* label;
+  int16_t     y;
+  uint16_t    fg;
+  char        shown[FIELD_MAX+1];   // what is on the glass right now
+};
+enum { SF_RELAY, SF_FLASH, SF_SRCV, SF_LVP, SF_LOAD, SF_COUNT };
+static StatusField statusFields[SF_COUNT] = {
+  {"Active Relay: ", 18, ST77XX_WHITE, ""},
+  {"Flash: ",        34, ST77XX_WHITE, ""},
+  {"SrcV: ",         50, ST77XX_WHITE, ""},
+  {"LVP: ",          66, ST77XX_WHITE, ""},
+  {"Load: ",         82, ST77XX_WHITE, ""},
+};
+static GFXcanvas16 fieldCanvas(FIELD_MAX*GLYPH_W, GLYPH_H);
+static uint16_t    fieldRun[FIELD_MAX*GLYPH_W*GLYPH_H];
+
+// SPI cost of the Run page: pixels + bytes (2 B/px + CASET/RASET/RAMWR per window),
+// rolled up once a second for the Diagnostics page
+static uint32_t statusPx = 0, statusBytes = 0;
+static uint32_t statusPxPerSec = 0, statusBytesPerSec = 0;
+static inline void statusAccount(uint32_t px){ statusPx += px; statusBytes += px*2 + 11; }
+
+static void statusStatsTick(){
+  static uint32_t winStart = 0;
+  if (millis()-winStart < 1000) return;
+  winStart = millis();
+  statusPxPerSec = statusPx; statusBytesPerSec = statusBytes;
+  statusPx = statusBytes = 0;
+}
+
+static void setStatusField(StatusField& f, const char* txt){
+  // Pad to the old length so glyphs that went away are overwritten with blanks
+  char next[FIELD_MAX+1];
+  size_t olen = strlen(f.shown);
+  size_t nlen = min(strlen(txt), (size_t)FIELD_MAX);
+  size_t len  = max(olen, nlen);
+  for (size_t i=0;i<len;i++) next[i] = (i<nlen) ? txt[i] : ' ';
+  next[len] = 0;
+
+  int first=-1, last=-1;
+  for (size_t i=0;i<len;i++) if (i>=olen || next[i]!=f.shown[i]) { if (first<0) first=i; last=i; }
+  if (first < 0) return;
+
+  // Render the changed run off-screen, then push it as one window
+  int16_t runW = (last-first+1) * GLYPH_W;
+  fieldCanvas.fillScreen(ST77XX_BLACK);
+  fieldCanvas.setTextWrap(false);
+  fieldCanvas.setTextColor(f.fg, ST77XX_BLACK);
+  fieldCanvas.setCursor(0, 0);
+  for (int i=first;i<=last;i++) fieldCanvas.write(next[i]);
+  const uint16_t* src = fieldCanvas.getBuffer();
+  for (int16_t row=0; row<GLYPH_H; row++)
+    memcpy(&fieldRun[row*runW], &src[row*FIELD_MAX*GLYPH_W], runW*sizeof(uint16_t));
+  int16_t x = strlen(f.label) * GLYPH_W + first * GLYPH_W;
+  tft.drawRGBBitmap(x, f.y, fieldRun, runW, GLYPH_H);
+  statusAccount((uint32_t)runW * GLYPH_H);
+
+  memcpy(f.shown, txt, nlen); f.shown[nlen] = 0;
+}
+
+// force = full repaint (page entry); otherwise only changed glyphs go out.
 static void drawStatusPage(bool force){
-  RelayId act = currentActiveRelay();
-  bool flash = flashMode;
-  float srcV = _lastShownSrcV;
-  float loadA = _lastShownLoadA;
+  if (force){
+    tft.fillScreen(ST77XX_BLACK);
+    statusAccount((uint32_t)tft.width() * tft.height());
+    tft.setCursor(0, 0);
+    tft.setTextColor(ST77XX_CYAN);
+    tft.print("TLTB - Run");
 
-  if (!force && act==_lastShownRelay && flash==_lastShownFlash && fabs(srcV-_lastShownSrcV)<0.05f && fabs(loadA-_lastShownLoadA)<0.05f && lvpActive==_lastShownLvp) return;
+    tft.setTextColor(ST77XX_WHITE);
+    for (int i=0;i<SF_COUNT;i++){
+      tft.setCursor(0, statusFields[i].y);
+      tft.print(statusFields[i].label);
+      statusAccount(strlen(statusFields[i].label) * GLYPH_W * GLYPH_H);
+      statusFields[i].shown[0] = 0;
+    }
 
-  tft.fillScreen(ST77XX_BLACK);
-  tft.setCursor(0, 0);
-  tft.setTextColor(ST77XX_CYAN);
-  tft.print("TLTB - Run");
-
-  tft.setTextColor(ST77XX_WHITE);
-  tft.setCursor(0, 18);
-  tft.print("Active Relay: ");
-  tft.print(relayName(act));
-
-  tft.setCursor(0, 34);
-  tft.print("Flash: ");
-  tft.print(flash ? "ON" : "OFF");
-
-  tft.setCursor(0, 50);
-  tft.print("SrcV: ");
-  tft.print(_lastShownSrcV, 2);
-  tft.print("V");
-
-  tft.setCursor(0, 66);
-  tft.print("LVP: ");
-  tft.print(lvpActive ? "TRIPPED" : "OK");
-
-  tft.setCursor(0, 82);
-  tft.print("Load: ");
-  tft.print(_lastShownLoadA, 2);
-  tft.print("A");
-
-  // Hint line
-  tft.setCursor(0, 98);
-  tft.setTextColor(ST77XX_YELLOW);
-  tft.print("OK=Menu  Hold OK=Scan  Back=Exit");
+    // Hint line
+    tft.setCursor(0, 98);
+    tft.setTextColor(ST77XX_YELLOW);
+    tft.print("OK=Menu  Hold OK=Scan  Back=Exit");
+  }
 
-  _lastShownRelay = act;
-  _lastShownFlash = flash;
-  _lastShownLvp   = lvpActive;
-  _lastShownLoadA = loadA;
+  char buf[FIELD_MAX+1];
+  uint8_t nOn = 0;
+  for (int i=0;i<R_COUNT;i++) if (relayState[i]) nOn++;
+  if (nOn > 1){
+    snprintf(buf, sizeof(buf), "%s+%u", relayName(currentActiveRelay()), (unsigned)(nOn - 1));
+    setStatusField(statusFields[SF_RELAY], buf);
+  } else setStatusField(statusFields[SF_RELAY], relayName(currentActiveRelay()));
+  setStatusField(statusFields[SF_FLASH], flashMode ? "ON" : "OFF");
+  snprintf(buf, sizeof(buf), "%.2fV", _lastShownSrcV);
+  setStatusField(statusFields[SF_SRCV], buf);
+  setStatusField(statusFields[SF_LVP], lvpActive ? "TRIPPED" : "OK");
+  snprintf(buf, sizeof(buf), "%.2fA", _lastShownLoadA);
+  setStatusField(statusFields[SF_LOAD], buf);
 }
 
 static inline void refreshStatusIfChanged(){
   if (!uiInMenu) drawStatusPage(false);
 }
 
+// ------------------- I2C bus accounting -------------------
+// Every INA226 register access goes through wr16/rd16 below and is counted here.
+static std::atomic<uint32_t> i2cTxn{0};      // transactions since boot
+static std::atomic<uint32_t> i2cBusyUs{0};   // time spent inside Wire calls
+static inline void i2cAccount(uint32_t t0){
+  i2cTxn.fetch_add(1, std::memory_order_relaxed);
+  i2cBusyUs.fetch_add(micros() - t0, std::memory_order_relaxed);
+}
+
 // ------------------- INA226 (Load/OCP) -------------------
 namespace INA226 {
   static uint8_t addr = 0x40;  // LOAD sensor at 0x40
 
   static void wr16(uint8_t r, uint16_t v){
+    uint32_t t0 = micros();
     Wire.beginTransmission(addr); Wire.write(r);
     Wire.write((uint8_t)(v>>8)); Wire.write((uint8_t)(v&0xFF));
     Wire.endTransmission();
+    i2cAccount(t0);
   }
   static uint16_t rd16(uint8_t r){
+    uint32_t t0 = micros();
     Wire.beginTransmission(addr); Wire.write(r); Wire.endTransmission(false);
     Wire.requestFrom((int)addr,2);
-    return (Wire.read()<<8)|Wire.read();
+    uint16_t v = (Wire.read()<<8)|Wire.read();
+    i2cAccount(t0);
+    return v;
   }
 
   static void setOcpLimit(float amps); // forward-declare
 
-  static void begin(){
+  static InaProfile profile = INA_PROFILE_LOAD;
+
+  static void setProfile(const InaProfile& p){
+    profile = p;
+    wr16(INA_REG_CONFIG, inaConfigWord(p));
+  }
+  static uint32_t conversionUs(){ return inaConversionUs(profile); }
+
+  static void begin(const InaProfile& p = INA_PROFILE_LOAD){
     Wire.begin(PIN_I2C_SDA, PIN_I2C_SCL, 400000);
 
     // Reset
     wr16(0x00, 0x8000); delay(2);
 
-    // Config: AVG=16, VBUSCT=1.1ms, VSHCT=1.1ms, MODE=Shunt+Bus continuous
-    wr16(0x00, (0b010<<9)|(0b100<<6)|(0b100<<3)|0b111);
+    // Config: averaging + conversion times from the profile, continuous
+    setProfile(p);
 
     // Calibration for 2.5 mΩ, 1mA/bit
     wr16(0x05, 0x0800);
@@ -241,13 +996,37 @@ namespace INA226 {
     return r * CURRENT_LSB_A;
   }
 
-  static bool overCurrent(){ return digitalRead(PIN_INA_ALERT) == LOW; }
+  // ALERT is busy with SOL, so conversion-ready is read from CVRF (read clears it)
+  static bool conversionReady(){ return rd16(INA_REG_MASK_ENABLE) & INA_MASK_CVRF; }
+
+  static bool overCurrent(){ return ocpTripLatched || digitalRead(PIN_INA_ALERT) == LOW; }
+
+  // Shunt register direct (2.5 uV/LSB); valid in shunt-only mode, no calibration involved
+  static float shuntCurrentA(){
+    int16_t r = (int16_t)rd16(INA_REG_SHUNT_V);
+    return r * 0.0000025f / SHUNT_OHMS;
+  }
+
+  // The next conversion, read once: a back-to-back read (~110 us) outpaces a
+  // fast-profile conversion, so wait for CVRF. Two conversion times without
+  // one and the register is read as it is.
+  static float nextShuntCurrentA(){
+    uint32_t t0 = micros(), limit = 2 * conversionUs();
+    while (!conversionReady() && micros() - t0 < limit) {}
+    return shuntCurrentA();
+  }
+
+  // Program the SOL trip point without touching the configured OCP_LIMIT_A
+  static void setAlertLimitA(float amps){
+    // SOL compares the shunt register (2.5 uV/LSB), not the current register
+    uint16_t limit = (uint16_t)roundf(amps * SHUNT_OHMS / 0.0000025f);
+    wr16(INA_REG_ALERT_LIMIT, limit);
+    wr16(INA_REG_MASK_ENABLE, INA_MASK_SOL);  // SOL, transparent (ALERT follows the compare)
+  }
 
   static void setOcpLimit(float amps){
     OCP_LIMIT_A = amps;
-    uint16_t limit = (uint16_t)round(OCP_LIMIT_A / CURRENT_LSB_A);
-    wr16(0x06, limit);   // Alert Limit
-    wr16(0x07, 0x0002);  // Mask/Enable: enable SOL (bit1)
+    setAlertLimitA(OCP_LIMIT_A);
   }
 }
 
@@ -256,26 +1035,40 @@ namespace INA226_SRC {
   static uint8_t addr = 0x41;  // SOURCE sensor at 0x41 (wire A0 high on the second INA226)
 
   static void wr16(uint8_t r, uint16_t v){
+    uint32_t t0 = micros();
     Wire.beginTransmission(addr); Wire.write(r);
     Wire.write((uint8_t)(v>>8)); Wire.write((uint8_t)(v&0xFF));
     Wire.endTransmission();
+    i2cAccount(t0);
   }
   static uint16_t rd16(uint8_t r){
+    uint32_t t0 = micros();
     Wire.beginTransmission(addr); Wire.write(r); Wire.endTransmission(false);
     Wire.requestFrom((int)addr,2);
-    return (Wire.read()<<8)|Wire.read();
+    uint16_t v = (Wire.read()<<8)|Wire.read();
+    i2cAccount(t0);
+    return v;
   }
 
-  static void begin(){
+  static InaProfile profile = INA_PROFILE_SRC;
+
+  static uint32_t conversionUs(){ return inaConversionUs(profile); }
+
+  static void begin(const InaProfile& p = INA_PROFILE_SRC){
     // Assume Wire.begin already called by INA226::begin()
     // Reset
     wr16(0x00, 0x8000); delay(2);
-    // Config: AVG=16, VBUSCT=1.1ms, VSHCT=1.1ms, MODE=Shunt+Bus continuous
-    wr16(0x00, (0b010<<9)|(0b100<<6)|(0b100<<3)|0b111);
+    // Config: averaging + conversion times from the profile, continuous
+    profile = p;
+    wr16(INA_REG_CONFIG, inaConfigWord(p));
     // No calibration needed for reading VBUS
-    pinMode(PIN_INA2_ALERT, INPUT_PULLUP); // reserved
+    // ALERT2 pulls low when a conversion lands; reading Mask/Enable releases it
+    wr16(INA_REG_MASK_ENABLE, INA_MASK_CNVR);
+    pinMode(PIN_INA2_ALERT, INPUT_PULLUP);
   }
 
+  static void ackConversion(){ (void)rd16(INA_REG_MASK_ENABLE); }
+
   // INA226 VBUS register (0x02) LSB = 1.25mV
   static float busVoltageV(){
     uint16_t raw = rd16(0x02);
@@ -283,75 +1076,528 @@ namespace INA226_SRC {
   }
 }
 
-// ------------------- Fault popup forward declarations (needed by pulseTest) -------------------
-enum FaultType { FAULT_OPEN=0, FAULT_SHORT=1, FAULT_LVP=2 };
-static bool showFaultChoicePopup(FaultType ft, RelayId r);
+// ------------------- INA226 sampler (shared cache) -------------------
+// The only reader of INA226 data registers, paced by the sensors themselves:
+// the source INA226 raises ALERT2 on conversion-ready, and the load INA226
+// (whose ALERT belongs to OCP) is checked for CVRF when its conversion is due.
+// Each conversion is read once and published as a timestamped snapshot through
+// a seqlock; LVP, telemetry, the pulse test and scan-all read that snapshot
+// instead of putting their own transactions on the bus.
+struct InaSample {
+  uint32_t n;       // load conversions read, 0 = nothing published yet
+  uint32_t tUs;     // micros() when the load register was read
+  float    loadA;
+  uint32_t srcN;    // source conversions read
+  uint32_t tSrcUs;
+  float    srcV;
+};
+static std::atomic<uint32_t> inaSeq{0};   // odd while a write is in progress
+static InaSample inaShared = {0, 0, 0.0f, 0, 0, 0.0f};
+static TaskHandle_t inaTask = nullptr;
+static constexpr uint32_t INA_NOTE_SRC_READY = 1u << 0;
+static constexpr uint32_t INA_NOTE_CAPTURE   = 1u << 1;
+static constexpr uint32_t INA_NOTE_ENGAGE    = 1u << 2;
+static constexpr uint32_t INA_NOTE_SET_OCP   = 1u << 3;   // OCP_LIMIT_A changed: reprogram ALERT
+
+static void IRAM_ATTR inaSrcReadyIsr(){
+  BaseType_t woke = pdFALSE;
+  if (inaTask) xTaskNotifyFromISR(inaTask, INA_NOTE_SRC_READY, eSetBits, &woke);
+  if (woke) portYIELD_FROM_ISR();
+}
+
+static void inaPublish(const InaSample& v){
+  uint32_t q = inaSeq.load(std::memory_order_relaxed);
+  inaSeq.store(q + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  inaShared = v;
+  inaSeq.store(q + 2, std::memory_order_release);
+}
+
+// Lock-free read of the newest snapshot; retries if it raced the sampler.
+static InaSample inaLatest(){
+  InaSample v; uint32_t s0, s1;
+  do {
+    s0 = inaSeq.load(std::memory_order_acquire);
+    v = inaShared;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    s1 = inaSeq.load(std::memory_order_relaxed);
+  } while ((s0 & 1) || s0 != s1);
+  return v;
+}
+
+// Unconditional read of both sensors (boot, before the ready signals are armed)
+static void inaSampleOnce(){
+  InaSample v = inaShared;
+  v.loadA = INA226::currentA(); v.tUs = micros(); v.n++;
+  INA226_SRC::ackConversion();
+  v.srcV = INA226_SRC::busVoltageV(); v.tSrcUs = micros(); v.srcN++;
+  inaPublish(v);
+}
+
+// Bus load, rolled up once a second by the sampler for the Diagnostics page
+static uint32_t inaTxnPerSec  = 0;
+static float    inaBusUtilPct = 0.0f;
+
+static void inaStatsTick(){
+  static uint32_t winStart = 0, lastTxn = 0, lastBusy = 0;
+  uint32_t now = millis();
+  if (now - winStart < 1000) return;
+  uint32_t txn = i2cTxn.load(std::memory_order_relaxed), busy = i2cBusyUs.load(std::memory_order_relaxed);
+  uint32_t winUs = (now - winStart) * 1000u;
+  inaTxnPerSec  = (uint32_t)((uint64_t)(txn - lastTxn) * 1000u / (now - winStart));
+  inaBusUtilPct = 100.0f * (busy - lastBusy) / winUs;
+  winStart = now; lastTxn = txn; lastBusy = busy;
+}
+
+// ------------------- Inrush capture (runs on the sampler task) -------------------
+// For a pulse test the sampler switches the load INA226 to single 140 us shunt
+// conversions, closes the relay itself and streams the inrush curve into the
+// classifier until the verdict is certain. SOL is parked at FAST_SHORT_A for the
+// duration so a lamp's cold-filament spike doesn't hard-trip at OCP_LIMIT_A.
+static const InrushConfig INRUSH_CFG = {
+  OPEN_THRESH_A,      // openA
+  FAST_SHORT_A,       // shortA
+  1500,               // shortHoldUs
+  2000,               // minUs
+  15000,              // openMinUs
+  PULSE_MS * 1000,    // maxUs
+  8,                  // settleN
+  0.03f,              // settleBandA
+};
+static InrushClassifier inrush(INRUSH_CFG);
+static RelayId          inaCapRelay  = R_NONE;
+static TaskHandle_t     inaCapWaiter = nullptr;
+static volatile bool    inaCapAbort  = false;   // waiter gave up: decide now, close nothing more
+
+// Current other channels already draw, on the fast profile, so a channel is
+// classified on what it adds rather than on the bus total
+static float inaFastBaseA(RelayId except){
+  bool any = false;
+  for (int i=0;i<R_COUNT;i++) if (i != except && relayState[i]) any = true;
+  if (!any) return 0.0f;
+  delayMicroseconds(INA226::conversionUs());   // first conversion on the new profile
+  float sum = 0;
+  for (int i=0;i<4;i++) sum += INA226::nextShuntCurrentA();
+  return sum / 4;
+}
+
+static void inaRunCapture(){
+  INA226::setProfile(INA_PROFILE_INRUSH);
+  INA226::setAlertLimitA(FAST_SHORT_A);
+  float base = inaFastBaseA(inaCapRelay);
+  inrush.reset(micros());
+  if (!inaCapAbort) relayOn(inaCapRelay);
+  while (!inrush.decided()){
+    if (inaCapAbort){ inrush.finish(micros()); break; }
+    if (ocpTripLatched){ inrush.tripped(micros()); break; }
+    float a = INA226::nextShuntCurrentA();
+    inrush.feed(micros(), a - base);
+  }
+  INA226::setProfile(INA_PROFILE_LOAD);
+  INA226::setOcpLimit(OCP_LIMIT_A);
+  xTaskNotifyGive(inaCapWaiter);
+}
+
+// Sampler late with a capture or engage: have it decide from what it has and
+// hand back, so the caller never races it on the classifier or the relays.
+static void inaAwaitSampler(uint32_t timeoutMs){
+  if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(timeoutMs))) return;
+  inaCapAbort = true;
+  (void)ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  inaCapAbort = false;
+}
+
+// Called from the protection task: pulse 'r' and classify it. The relay is left
+// on; the caller drops it for OPEN/SHORT.
+static const InrushResult& inaInrushTest(RelayId r){
+  inaCapRelay  = r;
+  inaCapWaiter = xTaskGetCurrentTaskHandle();
+  xTaskNotify(inaTask, INA_NOTE_CAPTURE, eSetBits);
+  inaAwaitSampler(PULSE_MS + 100);
+  return inrush.result();
+}
+
+// ------------------- Staggered engage (runs on the sampler task) -------------------
+// Brings several channels up in one fast-sampling session. The next channel
+// closes as soon as the bus current plus its expected inrush peak fits under
+// ENGAGE_BUDGET_A. A channel without a fresh verdict also waits for the bus
+// to settle, because it is classified on the current it adds over that
+// baseline. Whenever the bus settles, and at the end, the total is checked
+// against OCP_LIMIT_A and the newest channel dropped if it doesn't fit.
+static constexpr float    ENGAGE_BUDGET_A     = FAST_SHORT_A * 0.8f;   // stacked inrush ceiling
+static constexpr float    ENGAGE_STEADY_FRAC  = 0.9f;                  // of OCP_LIMIT_A, settled total
+static constexpr float    ENGAGE_PEAK_GUESS_A = 15.0f;                 // inrush of an untested channel
+static constexpr uint32_t ENGAGE_WAIT_MAX_US  = 250000;                // no headroom by then: stop
+static constexpr uint8_t  ENGAGE_SETTLE_N     = 8;                     // samples in the settle window
+
+enum EngageStatus : uint8_t { EG_PENDING, EG_OK, EG_OPEN, EG_SHORT, EG_BUDGET, EG_SKIPPED };
+struct EngageStep {
+  RelayId      relay;
+  bool         cached;      // fresh OK verdict: engage on presence, no classification
+  float        expPeakA;    // inrush it is expected to add
+  EngageStatus status;
+  float        baseA;       // bus current just before it closed
+  InrushResult res;         // classified channels only
+};
+static EngageStep engageSteps[R_COUNT];
+static uint8_t    engageN      = 0;
+static float      engageTotalA = 0.0f;   // bus current when the sequence handed back
+static uint32_t   engageUs     = 0;
+
+// Sample the bus until it has room for peakA more (and, if 'settle', has
+// stopped moving). meanA is the settled level, or the last sample when
+// settling wasn't asked for. False on a trip, an abort or after
+// ENGAGE_WAIT_MAX_US.
+static bool inaBusWait(float peakA, bool settle, float& meanA){
+  static constexpr uint8_t N = ENGAGE_SETTLE_N;
+  float win[N]; uint8_t n = 0, i = 0;
+  uint32_t t0 = micros();
+  for (;;){
+    if (ocpTripLatched || inaCapAbort) return false;
+    float a = INA226::nextShuntCurrentA();
+    win[i] = a; i = (i + 1) % N; if (n < N) n++;
+    bool fits = a + peakA <= ENGAGE_BUDGET_A;
+    if (fits && !settle){ meanA = a; return true; }
+    if (fits && n == N){
+      float lo = win[0], hi = win[0], sum = 0;
+      for (uint8_t k=0;k<N;k++){ lo = min(lo, win[k]); hi = max(hi, win[k]); sum += win[k]; }
+      float mean = sum / N;
+      if (hi - lo <= max(INRUSH_CFG.settleBandA, 0.05f * mean)){ meanA = mean; return true; }
+    }
+    if (micros() - t0 > ENGAGE_WAIT_MAX_US) return false;
+  }
+}
+
+static void inaEngageStep(EngageStep& s){
+  if (s.cached){
+    // Known good: present as soon as it adds current; slow starters get the OPEN window
+    relayOn(s.relay);
+    uint32_t tc = micros();
+    s.status = EG_OPEN;
+    while (!ocpTripLatched && !inaCapAbort && micros() - tc < INRUSH_CFG.openMinUs)
+      if (INA226::nextShuntCurrentA() - s.baseA > OPEN_THRESH_A){ s.status = EG_OK; break; }
+    if (ocpTripLatched) s.status = EG_SHORT;
+    else if (s.status == EG_OPEN && inaCapAbort) s.status = EG_SKIPPED;   // cut short, not seen open
+  } else {
+    inrush.reset(micros());
+    relayOn(s.relay);
+    while (!inrush.decided()){
+      if (inaCapAbort){ inrush.finish(micros()); break; }
+      if (ocpTripLatched){ inrush.tripped(micros()); break; }
+      inrush.feed(micros(), INA226::nextShuntCurrentA() - s.baseA);
+    }
+    s.res = inrush.result();
+    s.status = s.res.cls == INRUSH_OK ? EG_OK : s.res.cls == INRUSH_SHORT ? EG_SHORT : EG_OPEN;
+  }
+  if (s.status != EG_OK) relayOff(s.relay);
+}
+
+// Settled bus over the steady limit: the most recent channel doesn't fit
+static bool inaEngageOverBudget(float settledA, uint8_t upTo){
+  if (settledA <= ENGAGE_STEADY_FRAC * OCP_LIMIT_A) return false;
+  for (int k=upTo; k>=0; k--){
+    EngageStep& s = engageSteps[k];
+    if (s.status != EG_OK) continue;
+    relayOff(s.relay);
+    s.status = EG_BUDGET;
+    break;
+  }
+  return true;
+}
+
+static void inaRunEngage(){
+  INA226::setProfile(INA_PROFILE_INRUSH);
+  INA226::setAlertLimitA(FAST_SHORT_A);
+  uint32_t t0 = micros();
+  delayMicroseconds(INA226::conversionUs());
+  uint8_t k = 0;
+  for (; k<engageN && !inaCapAbort; k++){
+    EngageStep& s = engageSteps[k];
+    // An untested channel is classified on what it adds, so it needs a quiet
+    // bus; that settled level is also the total check for the steps before it
+    if (!inaBusWait(s.expPeakA, !s.cached, s.baseA)){
+      if (!ocpTripLatched && !inaCapAbort) s.status = EG_BUDGET;
+      break;
+    }
+    if (!s.cached && k && inaEngageOverBudget(s.baseA, k-1)) break;
+    inaEngageStep(s);
+    if (s.status == EG_SHORT) break;   // the ALERT ISR has dropped everything
+  }
+  // Final total once the last inrush has died down, dropping channels until it fits
+  float a = 0;
+  for (uint8_t drops=0; drops<=engageN; drops++){
+    if (!inaBusWait(0, true, a)){ a = INA226::shuntCurrentA(); break; }
+    if (!inaEngageOverBudget(a, engageN - 1)) break;
+  }
+  for (uint8_t j=0;j<engageN;j++) if (engageSteps[j].status == EG_PENDING) engageSteps[j].status = EG_SKIPPED;
+  engageTotalA = a;
+  engageUs = micros() - t0;
+  INA226::setProfile(INA_PROFILE_LOAD);
+  INA226::setOcpLimit(OCP_LIMIT_A);
+  xTaskNotifyGive(inaCapWaiter);
+}
+
+static void inaSamplerTask(void*){
+  InaSample v = inaShared;
+  uint32_t loadDueUs = micros();
+  uint32_t srcLastUs = micros();
+  for (;;){
+    // Sleep until ALERT2 fires or the load conversion is due
+    int32_t untilLoad = (int32_t)(loadDueUs - micros());
+    TickType_t wait = untilLoad > 0 ? pdMS_TO_TICKS(untilLoad / 1000 + 1) : 0;
+    uint32_t bits = 0;
+    xTaskNotifyWait(0, UINT32_MAX, &bits, wait);
+
+    if (bits & INA_NOTE_CAPTURE){
+      inaRunCapture();
+      loadDueUs = micros() + INA226::conversionUs();
+    }
+    if (bits & INA_NOTE_ENGAGE){
+      inaRunEngage();
+      loadDueUs = micros() + INA226::conversionUs();
+    }
+    if (bits & INA_NOTE_SET_OCP) INA226::setOcpLimit(OCP_LIMIT_A);
+
+    bool fresh = false;
+    uint32_t srcPeriodUs = INA226_SRC::conversionUs();
+    // A missed edge would leave ALERT2 low forever; re-arm if it has gone quiet
+    if ((bits & INA_NOTE_SRC_READY) || micros() - srcLastUs > 3 * srcPeriodUs){
+      INA226_SRC::ackConversion();
+      v.srcV = INA226_SRC::busVoltageV(); v.tSrcUs = micros(); v.srcN++;
+      srcLastUs = v.tSrcUs;
+      fresh = true;
+    }
+    if ((int32_t)(micros() - loadDueUs) >= 0){
+      if (INA226::conversionReady()){
+        v.loadA = INA226::currentA(); v.tUs = micros(); v.n++;
+        loadDueUs = v.tUs + INA226::conversionUs();
+        fresh = true;
+      } else {
+        loadDueUs = micros() + 1000;   // landed late; look again shortly
+      }
+    }
+    if (fresh) inaPublish(v);
+    inaStatsTick();
+  }
+}
+
+static void inaSamplerStart(){
+  xTaskCreatePinnedToCore(inaSamplerTask, "ina", 4096, nullptr, PRIO_SAMPLER, &inaTask, CORE_PROT);
+  attachInterrupt(digitalPinToInterrupt(PIN_INA2_ALERT), inaSrcReadyIsr, FALLING);
+}
+
+// ------------------- Fault popup forward declarations -------------------
+static bool showFaultChoicePopup(const UiEvt& ev);
+
+// ------------------- Verification cache -------------------
+// Last pulse-test verdict per channel. A fresh OK lets the channel engage
+// without another pulse; an OCP or LVP trip, or the TTL, forces a re-test.
+struct VerifyEntry { bool valid; InrushClass cls; float steadyA; float peakA; uint32_t tMs; };
+static VerifyEntry verifyCache[R_COUNT] = {};
+
+// Cached engage still gets checked: the first full load conversion must show the
+// channel adding current over what the bus drew before it closed.
+static RelayId  verifyWatchRelay = R_NONE;
+static uint32_t verifyWatchN = 0, verifyWatchMs = 0;
+static float    verifyWatchBaseA = 0.0f;
+
+static void verifyStore(RelayId r, const InrushResult& res){
+  verifyCache[r] = VerifyEntry{true, res.cls, res.steadyA, res.peakA, millis()};
+}
+static void verifyInvalidateAll(){
+  for (int i=0;i<R_COUNT;i++) verifyCache[i].valid = false;
+  verifyWatchRelay = R_NONE;
+}
+static bool verifyFresh(RelayId r){
+  const VerifyEntry& e = verifyCache[r];
+  return VERIFY_TTL_MS && e.valid && e.cls == INRUSH_OK && millis() - e.tMs < VERIFY_TTL_MS;
+}
 
 // ------------------- Pulse Test -------------------
+// Runs on the protection task. A fault leaves the relay off and asks the UI
+// task for the OPEN/SHORT choice; "OK = Enable" comes back as PC_FORCE_ON.
 static bool pulseTestAndEngage(RelayId rly) {
   // Block if LVP is active
   if (lvpActive) {
     buzzerAlarm(300);
-    (void)showFaultChoicePopup(FAULT_LVP, rly);
+    postFault(FAULT_LVP, rly);
     return false;
   }
 
-  relayOn(rly);
-  delay(PULSE_MS);
+  // Passed recently: engage now, verifyWatchService() confirms the load
+  if (verifyFresh(rly)) {
+    InaSample before = inaLatest();
+    relayOn(rly);
+    verifyWatchRelay = rly;
+    verifyWatchBaseA = before.loadA;      // other channels already on
+    verifyWatchN  = before.n + 1;         // conversion in flight may predate the relay
+    verifyWatchMs = millis();
+    buzzerBeep();
+    notifyStatus();
+    return true;
+  }
 
-  float ia = INA226::currentA();
-  delay(POST_PULSE_MS);
+  const InrushResult& res = inaInrushTest(rly);
+  InrushClass cls = res.cls;
+  verifyStore(rly, res);
 
   // Short-circuit detection
-  if (ia >= FAST_SHORT_A || INA226::overCurrent()) {
+  if (cls == INRUSH_SHORT || INA226::overCurrent()) {
     relayOff(rly);
+    (void)ocpConsume();   // trip during the pulse belongs to this test, not ocpService()
+    verifyCache[rly].valid = false;
     buzzerAlarm();
-
-    if (showFaultChoicePopup(FAULT_SHORT, rly)) {
-      relayOn(rly);
-      buzzerBeep();
-      refreshStatusIfChanged();
-      return true;
-    } else {
-      refreshStatusIfChanged();
-      return false;
-    }
+    postFault(FAULT_SHORT, rly);
+    notifyStatus();
+    return false;
   }
 
   // Open-circuit detection
-  if (ia < OPEN_THRESH_A) {
+  if (cls != INRUSH_OK) {
     relayOff(rly);
     buzzerAlarm();
-
-    if (showFaultChoicePopup(FAULT_OPEN, rly)) {
-      relayOn(rly);
-      buzzerBeep();
-      refreshStatusIfChanged();
-      return true;
-    } else {
-      refreshStatusIfChanged();
-      return false;
-    }
+    postFault(FAULT_OPEN, rly);
+    notifyStatus();
+    return false;
   }
 
   // Normal engage
   buzzerBeep();
-  refreshStatusIfChanged();
+  notifyStatus();
   return true;
 }
 
+// Several channels at once (e.g. TAIL+MARKER+BRAKE). The sampler staggers them
+// under the inrush budget, biggest expected inrush first while the bus is
+// emptiest; faults are reported per channel as in pulseTestAndEngage().
+// Returns the mask of channels on afterwards.
+static uint8_t engageSet(uint8_t mask){
+  if (lvpActive) {
+    buzzerAlarm(300);
+    postFault(FAULT_LVP, R_NONE);
+    return 0;
+  }
+  engageN = 0;
+  for (int i=0;i<R_COUNT;i++){
+    if (!(mask & (1u << i)) || relayState[i]) continue;
+    bool cached = verifyFresh((RelayId)i);
+    const VerifyEntry& e = verifyCache[i];
+    EngageStep st{};
+    st.relay = (RelayId)i; st.cached = cached; st.status = EG_PENDING;
+    st.expPeakA   = cached ? max(e.peakA, e.steadyA) : ENGAGE_PEAK_GUESS_A;
+    uint8_t k = engageN++;
+    for (; k > 0 && engageSteps[k-1].expPeakA < st.expPeakA; k--) engageSteps[k] = engageSteps[k-1];
+    engageSteps[k] = st;
+  }
+  if (engageN){
+    inaCapWaiter = xTaskGetCurrentTaskHandle();
+    xTaskNotify(inaTask, INA_NOTE_ENGAGE, eSetBits);
+    // Steps still pending once the sampler hands back were skipped by it
+    inaAwaitSampler(engageN * (PULSE_MS + ENGAGE_WAIT_MAX_US / 1000) + ENGAGE_WAIT_MAX_US / 1000 + 100);
+  }
+
+  bool fault = false, any = false;
+  for (uint8_t k=0;k<engageN;k++){
+    const EngageStep& st = engageSteps[k];
+    switch (st.status){
+      case EG_OK:
+        if (!st.cached) verifyStore(st.relay, st.res);
+        any = true;
+        break;
+      case EG_OPEN:
+        verifyCache[st.relay].valid = false;
+        postFault(FAULT_OPEN, st.relay);
+        fault = true;
+        break;
+      case EG_SHORT:
+        (void)ocpConsume();   // trip during the sequence belongs to it, not ocpService()
+        verifyCache[st.relay].valid = false;
+        postFault(FAULT_SHORT, st.relay);
+        fault = true;
+        break;
+      default: break;         // budget/skipped: left off, nothing wrong with the load
+    }
+  }
+  uint8_t on = 0;
+  for (int i=0;i<R_COUNT;i++) if (relayState[i]) on |= (1u << i);
+  if (engageN){
+    if (fault) buzzerAlarm(); else if (any) buzzerBeep();
+  }
+  notifyStatus();
+  return on;
+}
+
+// Follow-up for a cached engage: a load that has gone open since the last
+// pulse shows up in the first sampler reading taken wholly after switch-on.
+// Shorts need no help here; the ALERT ISR already covers them.
+static void verifyWatchService(){
+  RelayId r = verifyWatchRelay;
+  if (r == R_NONE) return;
+  if (!relayState[r]) { verifyWatchRelay = R_NONE; return; }
+
+  InaSample v = inaLatest();
+  if (v.n > verifyWatchN) {
+    verifyWatchRelay = R_NONE;
+    if (v.loadA - verifyWatchBaseA < OPEN_THRESH_A) {
+      relayOff(r);
+      verifyCache[r].valid = false;
+      buzzerAlarm();
+      postFault(FAULT_OPEN, r);
+      notifyStatus();
+    }
+  } else if (millis() - verifyWatchMs > VERIFY_WATCH_MS) {
+    verifyWatchRelay = R_NONE;          // sampler stalled; next engage pulses again
+    verifyCache[r].valid = false;
+  }
+}
+
 // ------------------- Rotary -------------------
+// The eight positions are consecutive pins in GPIO bank 1, so one register
+// read is the whole switch. Any edge restarts a settle timer; when it fires
+// the snapshot must show exactly one position grounded, and only a change of
+// that clean position is queued for the protection task.
+static_assert(PIN_SW_POS1 >= 32 && PIN_SW_POS8 == PIN_SW_POS1 + 7 && PIN_SW_POS8 < 64,
+              "rotary pins must be consecutive in GPIO bank 1");
+static constexpr bool rotaryPin(int p){ return p >= PIN_SW_POS1 && p <= PIN_SW_POS8; }
+static_assert(!rotaryPin(PIN_FSPI_SCK) && !rotaryPin(PIN_FSPI_MOSI) && !rotaryPin(PIN_FSPI_MISO),
+              "rotary edge interrupts must not sit on the FSPI lines");
+static constexpr uint8_t  ROT_SHIFT     = PIN_SW_POS1 - 32;
+static constexpr uint32_t ROT_SETTLE_US = 20000;   // detent bounce + break-before-make gap
+
+static SpscQueue<uint8_t, 4> rotEvtQ;              // settle timer -> protection task
+static esp_timer_handle_t    rotTimer = nullptr;
+static volatile uint8_t      rotPos = 0;           // last clean position (0 = none yet)
+
+// 1..8, or 0 when no position or several are grounded
 static int readRotaryPos(){
-  if(!digitalRead(PIN_SW_POS1))return 1;
-  if(!digitalRead(PIN_SW_POS2))return 2;
-  if(!digitalRead(PIN_SW_POS3))return 3;
-  if(!digitalRead(PIN_SW_POS4))return 4;
-  if(!digitalRead(PIN_SW_POS5))return 5;
-  if(!digitalRead(PIN_SW_POS6))return 6;
-  if(!digitalRead(PIN_SW_POS7))return 7;
-  if(!digitalRead(PIN_SW_POS8))return 8;
-  return 0;
+  uint32_t low = ~(REG_READ(GPIO_IN1_REG) >> ROT_SHIFT) & 0xFFu;
+  if (!low || (low & (low - 1))) return 0;
+  return __builtin_ctz(low) + 1;
 }
+
+static void IRAM_ATTR rotEdgeIsr(){
+  esp_timer_stop(rotTimer);
+  esp_timer_start_once(rotTimer, ROT_SETTLE_US);
+}
+
+static void rotSettledCb(void*){
+  int pos = readRotaryPos();
+  if (!pos || pos == rotPos) return;   // between detents: wait for the next edge
+  rotPos = (uint8_t)pos;
+  rotEvtQ.push((uint8_t)pos);
+}
+
+static void rotaryInit(){
+  if (!rotTimer){
+    const esp_timer_create_args_t args = { rotSettledCb, nullptr, ESP_TIMER_TASK, "rot", false };
+    esp_timer_create(&args, &rotTimer);
+  }
+  for (int i=0;i<8;i++) attachInterrupt(digitalPinToInterrupt(PIN_SW_POS1 + i), rotEdgeIsr, CHANGE);
+  // Boot position is applied like any other change, from the timer task so
+  // rotEvtQ keeps one producer; an edge that beat us here already armed it
+  esp_timer_start_once(rotTimer, 0);
+}
+
 static RelayId relayFromRotary(int pos){
   switch(pos){
     case 3:return R_LEFT;   case 4:return R_RIGHT;
@@ -363,135 +1609,290 @@ static RelayId relayFromRotary(int pos){
 static bool rfEnabled=false;
 static void applyRotaryMode(int pos){
   switch(pos){
-    case 1: rfEnabled=false; flashMode=false; relayOffAll(); break;
+    case 1: rfEnabled=false; flashStop(); relayOffAll(); break;
     case 2: rfEnabled=true;  break;
     case 3: case 4: case 5: case 6: case 7: case 8:{
-      rfEnabled=false; flashMode=false; relayOffAll();
+      rfEnabled=false; flashStop(); relayOffAll();
       RelayId tgt=relayFromRotary(pos);
       if (tgt!=R_NONE) pulseTestAndEngage(tgt);
       flashTarget=tgt;
     } break;
   }
-  refreshStatusIfChanged();
+  notifyStatus();
+}
+
+// Several queued positions (a quick sweep) collapse into the newest one
+static void rotaryService(){
+  uint8_t pos = 0, p;
+  while (rotEvtQ.pop(p)) pos = p;
+  if (pos) applyRotaryMode(pos);
+}
+
+// ------------------- CC1101: GDO0 edge capture -------------------
+// Every GDO0 transition is timestamped by an ISR into a lock-free ring, so no
+// edge depends on what any task is doing. The protection task runs the ring
+// through the OOK decoder and, for unknown protocols, assembles bursts (ended by
+// RF_GAP_US of silence) for the hash fallback, without ever polling the pin.
+struct RfEdge { uint32_t tUs; uint8_t level; };   // level = GDO0 before this edge
+static constexpr uint16_t RF_RING       = 512;
+static constexpr uint32_t RF_GAP_US     = 8000;  // silence that ends a burst
+static constexpr uint16_t RF_BURST_MAX  = 256;   // pulses kept per burst
+static constexpr uint16_t RF_MIN_PULSES = 8;
+
+static SpscQueue<RfEdge, RF_RING> rfEdgeQ;
+static uint32_t          rfGdo0Bit   = 0;        // DRAM copy of the GDO0 input bit
+static volatile uint32_t rfEdgeDrops = 0;        // ring full, edge lost
+
+static void IRAM_ATTR rfEdgeIsr(){
+  RfEdge e{ (uint32_t)micros(), (uint8_t)((REG_READ(GPIO_IN_REG) & rfGdo0Bit) ? 0 : 1) };
+  if (!rfEdgeQ.push(e)) rfEdgeDrops = rfEdgeDrops + 1;
 }
 
-// ------------------- CC1101: init -------------------
 static void rfInit(){
   ELECHOUSE_cc1101.setSpiPin(PIN_FSPI_SCK, PIN_FSPI_MISO, PIN_FSPI_MOSI, PIN_CC1101_CS);
   ELECHOUSE_cc1101.Init();
   ELECHOUSE_cc1101.setMHZ(433.92);
   pinMode(PIN_CC1101_GDO0, INPUT);
+  rfGdo0Bit = 1u << PIN_CC1101_GDO0;
+  attachInterrupt(digitalPinToInterrupt(PIN_CC1101_GDO0), rfEdgeIsr, CHANGE);
 }
 
-// ------------------- RF "hash" capture (learn + runtime) -------------------
-static inline uint32_t fnv1a(uint32_t h, uint32_t x){ h ^= x; return h * 16777619UL; }
-
-// Capture an RF burst from GDO0 and convert to a stable 32-bit "fingerprint".
-static uint32_t captureRfHashBlocking(uint32_t arm_ms=5000) {
-  uint32_t start = millis();
-  int last = digitalRead(PIN_CC1101_GDO0);
+struct RfBurst {
+  uint16_t us[RF_BURST_MAX];    // pulse widths
+  uint8_t  level[RF_BURST_MAX]; // GDO0 level during each pulse
+  uint16_t n;
+  uint32_t tEndUs;              // last edge
+  bool     truncated;           // longer than RF_BURST_MAX
+  bool     lossy;               // ring overflowed while it was arriving
+  bool     decoded;             // the decoder produced a frame from it
+};
 
-  // Wait for first falling edge (button press)
-  while (millis() - start < arm_ms) {
-    int cur = digitalRead(PIN_CC1101_GDO0);
-    if (last == HIGH && cur == LOW) break;
-    last = cur;
-    if (!digitalRead(PIN_ENC_KO)) return 0; // Back cancels
-    delay(1);
+enum RfEvent : uint8_t { RF_EV_NONE, RF_EV_FRAME, RF_EV_BURST };
+
+static RfDecoder rfDecoder;
+
+// Frame counters and edge-to-decision latency, shown on the Diagnostics page
+static uint32_t rfFrames = 0, rfHashed = 0, rfMissed = 0, rfTruncated = 0;
+static uint32_t rfLatLastUs = 0, rfLatMaxUs = 0, rfLatSumUs = 0;
+static uint32_t rfEvtEdgeUs = 0;   // last edge belonging to the event just returned
+
+// Drain the ring one event at a time: a decoded frame, or a complete burst
+// (which the caller hashes if nothing in it decoded).
+static RfEvent rfCollect(RfBurst& out, RfFrame& frame){
+  static RfBurst  b;
+  static uint32_t lastT = 0, dropsAtStart = 0;
+  static uint8_t  lineLevel = 0;
+  static bool     burstReady = false;
+  auto finish = [&]() -> bool {
+    bool done = b.n >= RF_MIN_PULSES;
+    if (done){ b.lossy = rfEdgeDrops != dropsAtStart; out = b; }
+    b.n = 0; b.truncated = false; b.decoded = false; dropsAtStart = rfEdgeDrops;
+    return done;
+  };
+
+  if (burstReady){ burstReady = false; rfEvtEdgeUs = out.tEndUs; return RF_EV_BURST; }
+  RfEdge e;
+  while (rfEdgeQ.pop(e)){
+    uint32_t d = e.tUs - lastT;
+    uint32_t prevT = lastT;
+    lastT = e.tUs; lineLevel = !e.level;
+    bool got = rfDecoder.feed((uint16_t)(d > 65535 ? 65535 : d), e.level, frame);
+    if (got) b.decoded = true;
+    if (d >= RF_GAP_US) burstReady = finish();
+    else if (b.n < RF_BURST_MAX){ b.us[b.n] = (uint16_t)d; b.level[b.n] = e.level; b.n++; b.tEndUs = e.tUs; }
+    else b.truncated = true;
+    if (got){ rfEvtEdgeUs = prevT; return RF_EV_FRAME; }   // a ready burst goes out next call
+    if (burstReady){ burstReady = false; rfEvtEdgeUs = out.tEndUs; return RF_EV_BURST; }
   }
-  if (millis() - start >= arm_ms) return 0;
 
-  // Record edge durations until a gap
-  static uint16_t dur[128];
-  int idx = 0;
-  uint32_t tEdge = micros();
-  const uint32_t GAP_US = 8000;
-
-  while (idx < (int)(sizeof(dur)/sizeof(dur[0]))) {
-    int cur = digitalRead(PIN_CC1101_GDO0);
-    if (cur != last) {
-      uint32_t now = micros();
-      uint32_t d = now - tEdge;
-      tEdge = now;
-      dur[idx++] = (uint16_t)min<uint32_t>(d, 65535);
-      last = cur;
-    }
-    if (micros() - tEdge > GAP_US) break;
-    if (!digitalRead(PIN_ENC_KO)) return 0; // cancel
+  // Quiet line: the trailing gap of the last frame never gets an edge of its own
+  uint32_t quiet = micros() - lastT;
+  if (lineLevel == 0 && quiet >= RfDecoder::FRAME_GAP_US && rfDecoder.pending()){
+    if (rfDecoder.flush(frame)){ b.decoded = true; rfEvtEdgeUs = lastT; return RF_EV_FRAME; }
   }
-  if (idx < 8) return 0;
+  if (b.n && quiet >= RF_GAP_US && finish()){ rfEvtEdgeUs = out.tEndUs; return RF_EV_BURST; }
+  return RF_EV_NONE;
+}
 
+// ------------------- RF codes (learn + runtime) -------------------
+// Decoded frames key on protocol + code; anything the decoder doesn't know
+// falls back to the duration-bucket hash (protocol 0).
+
+static inline uint32_t fnv1a(uint32_t h, uint32_t x){ h ^= x; return h * 16777619UL; }
+
+// Stable 32-bit "fingerprint" of an undecoded burst's pulse widths.
+static uint32_t rfHashBurst(const RfBurst& b) {
   // Normalize to buckets and hash
-  uint32_t sum=0; for (int i=0;i<idx;i++) sum += dur[i];
-  uint16_t avg = (uint16_t)(sum / idx);
+  uint32_t sum=0; for (int i=0;i<b.n;i++) sum += b.us[i];
+  uint16_t avg = (uint16_t)(sum / b.n);
   uint16_t thr = (avg > 400 ? avg : 400);
 
   uint32_t h = 2166136261UL;
-  for (int i=0;i<idx;i++) {
-    uint8_t bucket = (dur[i] > thr*2) ? 2 : (dur[i] > thr ? 1 : 0);
+  for (int i=0;i<b.n;i++) {
+    uint8_t bucket = (b.us[i] > thr*2) ? 2 : (b.us[i] > thr ? 1 : 0);
     h = fnv1a(h, (uint32_t)bucket + 0x9E);
   }
-  h = fnv1a(h, (uint32_t)idx ^ 0xA5A5A5A5UL);
-  return h ? h : 0xFFFFFFFF;
+  h = fnv1a(h, (uint32_t)b.n ^ 0xA5A5A5A5UL);
+  return h ? h : 0xFFFFFFFF;
+}
+
+// Learn Remote (UI task): wait for the protection task to hand over a code.
+enum RfLearnRes : uint8_t { RL_CODE, RL_SKIP, RL_CANCEL };
+static RfLearnRes rfAwaitLearnCode(uint32_t arm_ms, RfHeard& code) {
+  while (rfLearnQ.pop(code)) {}   // anything heard before the prompt
+  uint32_t start = millis();
+  while (millis() - start < arm_ms) {
+    if (rfLearnQ.pop(code)) return RL_CODE;
+    if (readOkPressed()) return RL_SKIP;
+    if (readKoPressed()) return RL_CANCEL;     // Back cancels
+    uiDelay(10);
+  }
+  return RL_CANCEL;
+}
+
+// ------------------- RF code table -------------------
+// Loaded from NVS once at boot; only startRfLearn() writes NVS. The table is
+// read by the protection task and edited by the UI task only while rfLearning
+// holds rfHandleCode() off it.
+static RfCodeTable rfCodes;
+static constexpr uint8_t RF_MATCH_TOL_BITS = 0;   // >0: accept a decoded code this many bits off
+
+static void rfPrefKey(char* key, size_t n, int relay, uint8_t k, const char* suffix = ""){
+  if (k) snprintf(key, n, "%s%u%s", RF_PREF_KEYS[relay], k, suffix);
+  else   snprintf(key, n, "%s%s", RF_PREF_KEYS[relay], suffix);
+}
+
+// The protocol sits beside each code under "<key>p"; codes saved before it
+// existed have none and load as hashes.
+static void rfCodesLoad(){
+  rfCodes.clear();
+  char key[16];
+  for (int i=0;i<R_COUNT;i++){
+    for (uint8_t k=0;k<RfCodeTable::MAX_PER_RELAY;k++){
+      rfPrefKey(key, sizeof(key), i, k);
+      uint32_t code = prefs.getULong(key, 0);
+      rfPrefKey(key, sizeof(key), i, k, "p");
+      if (code) rfCodes.add(code, i, prefs.getUChar(key, 0));
+    }
+  }
+}
+
+static void rfCodesSave(int relay){
+  uint32_t codes[RfCodeTable::MAX_PER_RELAY];
+  uint8_t  protos[RfCodeTable::MAX_PER_RELAY];
+  uint8_t n = rfCodes.codesFor(relay, codes, protos);
+  char key[16];
+  for (uint8_t k=0;k<RfCodeTable::MAX_PER_RELAY;k++){
+    rfPrefKey(key, sizeof(key), relay, k);
+    if (k < n) prefs.putULong(key, codes[k]);
+    else if (prefs.isKey(key)) prefs.remove(key);
+    rfPrefKey(key, sizeof(key), relay, k, "p");
+    if (k < n && protos[k]) prefs.putUChar(key, protos[k]);
+    else if (prefs.isKey(key)) prefs.remove(key);
+  }
+}
+
+// ------------------- RF service (uses learned codes) -------------------
+static constexpr uint32_t RF_HOLD_MS = 160;   // same code again within this = button still held
+
+static void rfHandleCode(RfHeard code, uint8_t tolBits);
+
+static void rfService(){
+  static RfBurst  burst;
+  static RfHeard  unknownFrame = {0, 0};   // decoded, not in the table: waits for its burst
+  RfFrame frame;
+  for (RfEvent ev; (ev = rfCollect(burst, frame)) != RF_EV_NONE; ){
+    RfHeard code; uint8_t tol = 0;   // a hash is all-or-nothing
+    if (ev == RF_EV_FRAME){
+      code = RfHeard{frame.code, frame.proto}; tol = RF_MATCH_TOL_BITS;
+      // Fobs paired before the decoder are stored as burst hashes, so a frame
+      // the table doesn't know gets one hash try when its burst completes
+      if (!rfLearning && rfCodes.match(code.code, code.proto, tol) < 0){
+        if (!unknownFrame.code) unknownFrame = code;
+        continue;
+      }
+    } else {
+      RfHeard frameCode = unknownFrame;
+      unknownFrame = RfHeard{0, 0};
+      if (burst.truncated) rfTruncated++;
+      if (burst.decoded && !frameCode.code) continue;   // already acted on its first frame
+      if (burst.lossy && !frameCode.code){ rfMissed++; continue; }
+      if (burst.lossy) code = frameCode;                 // a hash of a lossy burst means nothing
+      else {
+        code = RfHeard{rfHashBurst(burst), 0};
+        rfHashed++;
+        if (frameCode.code && rfCodes.find(code.code) < 0) code = frameCode;   // unknown either way
+      }
+    }
+    rfFrames++;
+    uint32_t lat = micros() - rfEvtEdgeUs;
+    rfLatLastUs = lat; rfLatSumUs += lat;
+    if (lat > rfLatMaxUs) rfLatMaxUs = lat;
+    rfHandleCode(code, tol);
+  }
 }
 
-// ------------------- RF service (uses learned codes) -------------------
-static void rfService(){
+static void rfHandleCode(RfHeard code, uint8_t tolBits){
+  // Remotes repeat the frame for as long as the button is down; act once per press
+  static RfHeard  heldCode = {0, 0};
+  static uint32_t heldMs = 0;
+  uint32_t nowMs = millis();
+  bool same = code.code == heldCode.code && code.proto == heldCode.proto;
+  if (same && nowMs - heldMs < RF_HOLD_MS){ heldMs = nowMs; return; }
+  heldCode = code; heldMs = nowMs;
+
+  if (rfLearning) { rfLearnQ.push(code); return; }
   if (!rfEnabled) return;
 
-  static int last = HIGH;
-  int cur = digitalRead(PIN_CC1101_GDO0);
-  if (last == HIGH && cur == LOW) {
-    // Capture this press quickly
-    uint32_t code = captureRfHashBlocking(200);
-    if (code) {
-      // Map to learned relay
-      RelayId target = R_NONE;
-      for (int i=0;i<R_COUNT;i++){
-        if (code == prefs.getULong(RF_PREF_KEYS[i], 0)) { target = (RelayId)i; break; }
-      }
+  // Map to learned relay
+  int8_t hit = rfCodes.match(code.code, code.proto, tolBits);
+  RelayId target = (hit >= 0 && hit < R_COUNT) ? (RelayId)hit : R_NONE;
 
-      if (target != R_NONE) {
-        static uint32_t lastPressMs[R_COUNT] = {0};
-        uint32_t now = millis();
-        bool isDouble = (now - lastPressMs[target]) < DOUBLE_PRESS_MS;
-        lastPressMs[target] = now;
-
-        if (isDouble) {
-          flashMode = !flashMode;
-          flashTarget = target;
-          if (!flashMode) relayOff(flashTarget);
-        } else {
-          if (relayState[target]) { relayOff(target); buzzerBeep(); }
-          else if (pulseTestAndEngage(target)) { /* engaged */ }
-          lastRfRelay = target;
-          flashTarget = target;
-        }
-        refreshStatusIfChanged();
-      } else {
-        // Unknown button → short chirp
-        buzzerBeep(30);
-      }
+  if (target != R_NONE) {
+    static uint32_t lastPressMs[R_COUNT] = {0};
+    uint32_t now = millis();
+    bool isDouble = (now - lastPressMs[target]) < DOUBLE_PRESS_MS;
+    lastPressMs[target] = now;
+
+    if (isDouble) {
+      buzzerPlay(BUZZ_DOUBLE);
+      if (flashMode) flashStop(); else flashStart(target);
+    } else {
+      if (relayState[target]) { relayOff(target); buzzerBeep(); }
+      else if (pulseTestAndEngage(target)) { /* engaged */ }
+      lastRfRelay = target;
+      flashTarget = target;
     }
+    heldMs = millis();   // repeats queued behind a pulse test are still the same press
+    notifyStatus();
+  } else {
+    // Unknown button → short chirp
+    buzzerPlay(BUZZ_CHIRP);
   }
-  last = cur;
 }
 
+// The flasher runs on its timer; this only redraws the Run page as it blinks
 static void serviceFlashMode(){
-  static uint32_t last=0; static bool on=false;
-  if (!flashMode || flashTarget==R_NONE) return;
-  int pos = readRotaryPos();
-  if (pos>=3 && pos<=8) flashTarget = relayFromRotary(pos);
-  if (millis()-last > 400) {
-    last = millis(); on = !on;
-    if (on) relayOn(flashTarget); else relayOff(flashTarget);
-    refreshStatusIfChanged();
-  }
+  static uint32_t seen = 0;
+  uint32_t e = flashEdges;
+  if (e != seen){ seen = e; notifyStatus(); }
 }
 
 // ------------------- Wi-Fi + OTA -------------------
 WebServer server(80);
 
+// UI task: wait for a specific network-task reply (other replies are dropped).
+static bool uiAwaitNet(NetEvtType want, NetEvt& out, uint32_t timeout_ms){
+  uint32_t t0 = millis();
+  while (millis()-t0 < timeout_ms){
+    NetEvt ev;
+    while (netToUi.pop(ev)) if (ev.type==want){ out=ev; return true; }
+    if (readKoPressed() && want==NE_CONNECT_RESULT) return false;
+    uiDelay(20);
+  }
+  return false;
+}
+
 // Connect using saved creds (returns true on success)
 static bool wifiConnectSaved(uint32_t timeout_ms=20000){
   String ssid = prefs.getString(KEY_WIFI_SSID, "");
@@ -529,10 +1930,10 @@ static int tftSelectFromList(const String* items, int count, const char* title)
 
     // input
     int8_t step = readEncoderStep();
-    if (step) idx = (idx + step + count) % count;
+    if (step) idx = wrapIndex(idx, step, count);
     if (readOkPressed()) return idx;
     if (readKoPressed()) return -1;
-    delay(60);
+    uiDelay(60);
   }
 }
 
@@ -582,7 +1983,7 @@ static bool tftEnterPassword(char* outPass, size_t outCap, const char* ssid) {
 
     // input
     int8_t step = readEncoderStep();
-    if (step) cur = (cur + step + total) % total;
+    if (step) cur = wrapIndex(cur, step, total);
 
     if (readOkPressed()) {
       if (cur < baseCount) {                   // append char
@@ -601,7 +2002,7 @@ static bool tftEnterPassword(char* outPass, size_t outCap, const char* ssid) {
       }
     }
     if (readKoPressed()) return false;         // cancel
-    delay(50);
+    uiDelay(50);
   }
 }
 
@@ -610,9 +2011,10 @@ static void wifiScanAndConnectUI(){
   tft.fillScreen(ST77XX_BLACK);
   tft.setCursor(0,0); tft.setTextColor(ST77XX_WHITE);
   tft.print("Scanning Wi-Fi...");
+  tftPresent(true);
   WiFi.mode(WIFI_STA);
   int n = WiFi.scanNetworks(/*async=*/false,true);
-  if (n <= 0) { tft.setCursor(0,14); tft.print("No networks found"); delay(1000); return; }
+  if (n <= 0) { tft.setCursor(0,14); tft.print("No networks found"); uiDelay(1000); return; }
 
   // Build list: "SSID  (RSSI) [OPEN/SEC]" (limit to first 12)
   const int MAX_SHOW = min(n, 12);
@@ -638,16 +2040,17 @@ static void wifiScanAndConnectUI(){
     pass = String(buf);
   }
 
-  // Try connect
+  // Try connect (network task joins + saves creds; UI just waits for the verdict)
   tft.fillScreen(ST77XX_BLACK); tft.setCursor(0,0);
   tft.printf("Connecting to\n%s\n", ssid.c_str());
-  WiFi.begin(ssid.c_str(), pass.c_str());
-  uint32_t t0 = millis();
-  while (WiFi.status()!=WL_CONNECTED && millis()-t0<20000) delay(200);
-
-  if (WiFi.status()==WL_CONNECTED) {
-    prefs.putString(KEY_WIFI_SSID, ssid);
-    prefs.putString(KEY_WIFI_PASS, pass);
+  NetCmd nc{NC_CONNECT, {0}, {0}};
+  strlcpy(nc.ssid, ssid.c_str(), sizeof(nc.ssid));
+  strlcpy(nc.pass, pass.c_str(), sizeof(nc.pass));
+  uiToNet.push(nc);
+  NetEvt ev{NE_CONNECT_RESULT, 0};
+  bool ok = uiAwaitNet(NE_CONNECT_RESULT, ev, 22000) && ev.code;
+
+  if (ok) {
     tft.setCursor(0,30); tft.print("Connected!");
     tft.setCursor(0,42); tft.print(WiFi.localIP());
     buzzerBeep(90);
@@ -655,53 +2058,670 @@ static void wifiScanAndConnectUI(){
     tft.setCursor(0,30); tft.print("Failed.");
     buzzerAlarm(300);
   }
-  delay(1200);
+  uiDelay(1200);
 }
 
 // Forget creds
 static void wifiForget(){
   prefs.remove(KEY_WIFI_SSID);
   prefs.remove(KEY_WIFI_PASS);
-  WiFi.disconnect(true,true);
+  uiToNet.push(NetCmd{NC_FORGET, {0}, {0}});
   tft.fillScreen(ST77XX_BLACK); tft.setCursor(0,0);
   tft.print("Wi-Fi creds cleared");
-  delay(900);
+  uiDelay(900);
+}
+
+// ------------------- OTA (network task) -------------------
+// The release asset streams into the inactive app slot through the flash
+// writer below, one chunk at a time, so the UI can draw progress and Back can
+// cancel between chunks. Both run at the bottom of core 0's priorities:
+// protection on core 1 never waits on them and keeps its full rate until the
+// reboot at the very end.
+static constexpr size_t    OTA_CHUNK         = 4096;    // largest read off the wire in one go
+static constexpr uint32_t  OTA_STALL_MS      = 15000;   // no bytes for this long: give up
+static constexpr uint32_t  OTA_REBOOT_MS     = 1500;    // "Rebooting" stays up this long
+static constexpr esp_err_t OTA_ERR_CANCELLED = 0x15FF;  // past the IDF's ESP_ERR_OTA_* codes
+static constexpr esp_err_t OTA_UP_TO_DATE    = 0x15FE;  // manifest names this build: nothing downloaded
+
+enum OtaStage : uint8_t { OTA_IDLE, OTA_CHECK, OTA_CONNECT, OTA_DOWNLOAD, OTA_FINISH, OTA_DONE, OTA_FAILED };
+static const char* const OTA_STAGE_NAME[] = { "Idle", "Checking", "Connecting", "Downloading", "Verifying", "Done", "Failed" };
+
+// Written by the network task only, read by the UI. done/total count bytes on
+// the wire, so with a compressed asset they track the transfer, not the image.
+struct OtaProgress {
+  std::atomic<uint8_t>  stage{OTA_IDLE};
+  std::atomic<uint32_t> done{0}, total{0};
+  std::atomic<uint32_t> startMs{0};   // first body byte
+  std::atomic<uint32_t> rawTotal{0};  // image bytes (== total unless compressed)
+  std::atomic<uint8_t>  source{0};    // OtaSource of the asset in flight
+};
+static OtaProgress       otaProg;
+static std::atomic<bool> otaCancel{false};   // UI -> net: stop at the next chunk (UI clears it before NC_OTA)
+
+// ------------------- OTA flash writer (pipelined) -------------------
+// The network task only reads, inflates and patches. Image bytes go into a
+// ring of sector-sized blocks that the writer task drains: it erases 64 KB
+// blocks ahead of the data while the ring fills, programs each block behind
+// it and hashes it on the SHA accelerator, so the wire keeps moving while the
+// flash is busy. The first 16 bytes (the image magic) are held back and
+// written just before the boot switch, so a cut-short image never boots.
+static constexpr uint8_t     OTA_RING_BLOCKS = 4;        // 16 KB: a 64 KB erase's worth of wire at ~100 KB/s
+static constexpr size_t      OTA_SECTOR      = 4096;
+static constexpr size_t      OTA_ERASE_BLOCK = 65536;
+static constexpr size_t      OTA_HEAD_HOLD   = 16;
+static constexpr uint8_t     OTA_IMAGE_MAGIC = 0xE9;
+static constexpr UBaseType_t PRIO_OTA_WRITER = PRIO_NET + 1;   // a full block never waits behind a read
+
+// Where update time goes: bytes through each stage and wall-clock
+// microseconds in it. Network task: net (waiting for and reading the wire),
+// decode (inflate, patch, copy into the ring, and any CPU the writer takes
+// meanwhile), stall (ring full). Writer: erase, program, sha, idle (ring
+// empty). Reset per asset; 'o' on the console dumps them.
+struct OtaStats {
+  uint32_t netBytes, netUs;
+  uint32_t decodeBytes, decodeUs;
+  uint32_t stallUs;
+  uint32_t eraseBytes, eraseUs;
+  uint32_t programBytes, programUs;
+  uint32_t shaBytes, shaUs;
+  uint32_t idleUs;
+  uint32_t totalUs;
+};
+static OtaStats otaStats;
+static uint32_t otaStatsT0 = 0;
+
+struct OtaBlock { uint8_t idx; uint16_t len; };   // len 0: end of image (or abort)
+
+struct OtaWriter {
+  const esp_partition_t* part;
+  uint32_t size, eraseEnd;       // image bytes; erase stops at the end of its last sector
+  uint32_t erased, written;      // writer side
+  uint32_t queued;               // producer side: bytes handed to put()
+  uint8_t  fill;                 // producer's block in progress
+  uint16_t fillLen;
+  uint8_t  head[OTA_HEAD_HOLD];
+  uint8_t  digest[Sha256::DIGEST];
+  mbedtls_sha256_context sha;
+  std::atomic<esp_err_t> err{ESP_OK};
+  std::atomic<bool>      running{false}, abort{false}, done{false};
+  std::atomic<bool>      fresh{false};   // new session: the writer refills otaFree itself
+};
+static OtaWriter              otaW;
+static uint8_t                otaRing[OTA_RING_BLOCKS][OTA_SECTOR];
+static SpscQueue<OtaBlock, 8> otaFull;   // network -> writer
+static SpscQueue<uint8_t, 8>  otaFree;   // writer -> network
+static TaskHandle_t           otaWriterTask = nullptr, otaProducer = nullptr;
+
+static void otaEraseNext(){
+  uint32_t n = min((uint32_t)OTA_ERASE_BLOCK, otaW.eraseEnd - otaW.erased);
+  uint32_t t0 = micros();
+  esp_err_t e = esp_partition_erase_range(otaW.part, otaW.erased, n);
+  otaStats.eraseUs += micros() - t0;
+  if (e != ESP_OK){ otaW.err = e; return; }
+  otaStats.eraseBytes += n;
+  otaW.erased += n;
+}
+
+static void otaWriteBlock(const OtaBlock& b){
+  const uint8_t* p = otaRing[b.idx];
+  uint32_t off = otaW.written;
+  while (otaW.erased < off + b.len && otaW.err == ESP_OK) otaEraseNext();
+  if (otaW.err != ESP_OK) return;
+
+  uint32_t t0 = micros();
+  mbedtls_sha256_update(&otaW.sha, p, b.len);
+  otaStats.shaUs += micros() - t0;
+  otaStats.shaBytes += b.len;
+
+  size_t skip = 0;
+  if (off < OTA_HEAD_HOLD){
+    skip = min((size_t)b.len, OTA_HEAD_HOLD - off);
+    memcpy(otaW.head + off, p, skip);
+  }
+  t0 = micros();
+  esp_err_t e = esp_partition_write(otaW.part, off + skip, p + skip, b.len - skip);
+  otaStats.programUs += micros() - t0;
+  if (e != ESP_OK){ otaW.err = e; return; }
+  otaStats.programBytes += b.len;
+  otaW.written += b.len;
+}
+
+static void otaWriterLoop(void*){
+  for (;;){
+    // Each ring keeps one producer and one consumer: the writer stocks otaFree
+    if (otaW.fresh.exchange(false)){
+      for (uint8_t i = 1; i < OTA_RING_BLOCKS; i++) otaFree.push(i);
+      xTaskNotifyGive(otaProducer);
+    }
+    OtaBlock b;
+    if (!otaW.running || !otaFull.pop(b)){
+      // Nothing to program: erase ahead while the ring fills
+      if (otaW.running && !otaW.abort && !otaW.done && otaW.err == ESP_OK && otaW.erased < otaW.eraseEnd){ otaEraseNext(); continue; }
+      uint32_t t0 = micros();
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      if (otaW.running) otaStats.idleUs += micros() - t0;
+      continue;
+    }
+    if (!b.len){
+      if (!otaW.abort) mbedtls_sha256_finish(&otaW.sha, otaW.digest);
+      mbedtls_sha256_free(&otaW.sha);
+      otaW.done = true;
+    } else {
+      if (!otaW.abort && otaW.err == ESP_OK) otaWriteBlock(b);
+      otaFree.push(b.idx);
+    }
+    xTaskNotifyGive(otaProducer);
+  }
+}
+
+// Network task side. begin() opens the inactive slot for 'size' image bytes
+// and starts the erase; put() copies into the ring and only waits when all
+// blocks are in flight; finish() drains it and hands back the SHA-256;
+// commit() writes the held-back head and switches the boot partition.
+static bool otaWriterBegin(uint32_t size){
+  otaW.err = ESP_OK;
+  otaW.part = esp_ota_get_next_update_partition(nullptr);
+  if (!otaW.part || !size || size > otaW.part->size){ otaW.err = ESP_ERR_INVALID_SIZE; return false; }
+  if (!otaWriterTask) xTaskCreatePinnedToCore(otaWriterLoop, "otaw", 4096, nullptr, PRIO_OTA_WRITER, &otaWriterTask, CORE_NET);
+  otaProducer = xTaskGetCurrentTaskHandle();
+  // otaFull was drained up to the last session's end marker; leftover free
+  // blocks are ours to drop, and the writer restocks them when it sees 'fresh'
+  uint8_t i;
+  while (otaFree.pop(i)) {}
+  otaW.fill = 0; otaW.fillLen = 0;
+  otaW.size = size;
+  otaW.eraseEnd = (size + OTA_SECTOR - 1) / OTA_SECTOR * OTA_SECTOR;
+  otaW.erased = otaW.written = otaW.queued = 0;
+  mbedtls_sha256_init(&otaW.sha);
+  mbedtls_sha256_starts(&otaW.sha, 0);
+  otaW.abort = false; otaW.done = false;
+  otaW.fresh = true;
+  otaW.running = true;
+  xTaskNotifyGive(otaWriterTask);
+  return true;
+}
+
+// Queue the end marker and wait for the writer to reach it
+static void otaWriterDrain(){
+  otaFull.push(OtaBlock{0, 0});
+  xTaskNotifyGive(otaWriterTask);
+  while (!otaW.done) ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(20));
+  otaW.running = false;
+}
+
+static bool otaWriterPut(const uint8_t* p, size_t n){
+  if (otaW.err != ESP_OK) return false;
+  if (!otaW.queued && n && p[0] != OTA_IMAGE_MAGIC){ otaW.err = ESP_ERR_OTA_VALIDATE_FAILED; return false; }
+  if (otaW.queued + n > otaW.size){ otaW.err = ESP_ERR_INVALID_SIZE; return false; }
+  otaW.queued += n;
+  while (n){
+    size_t k = min(n, OTA_SECTOR - otaW.fillLen);
+    memcpy(otaRing[otaW.fill] + otaW.fillLen, p, k);
+    otaW.fillLen += k; p += k; n -= k;
+    if (otaW.fillLen < OTA_SECTOR) break;
+    otaFull.push(OtaBlock{otaW.fill, (uint16_t)OTA_SECTOR});
+    xTaskNotifyGive(otaWriterTask);
+    otaW.fillLen = 0;
+    uint32_t t0 = micros();
+    while (!otaFree.pop(otaW.fill)){
+      if (otaW.err != ESP_OK) return false;
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(20));
+    }
+    otaStats.stallUs += micros() - t0;
+  }
+  return otaW.err == ESP_OK;
+}
+
+static esp_err_t otaWriterFinish(uint8_t digest[Sha256::DIGEST]){
+  if (otaW.fillLen) otaFull.push(OtaBlock{otaW.fill, otaW.fillLen});
+  otaWriterDrain();
+  if (otaW.err != ESP_OK) return otaW.err;
+  if (otaW.written != otaW.size) return ESP_ERR_INVALID_SIZE;
+  memcpy(digest, otaW.digest, Sha256::DIGEST);
+  return ESP_OK;
+}
+
+static esp_err_t otaWriterCommit(){
+  esp_err_t e = esp_partition_write(otaW.part, 0, otaW.head, min((size_t)otaW.size, OTA_HEAD_HOLD));
+  return e == ESP_OK ? esp_ota_set_boot_partition(otaW.part) : e;
+}
+
+static void otaWriterAbort(){
+  if (!otaW.running) return;
+  otaW.abort = true;
+  otaWriterDrain();
+}
+
+static void otaStatsDump(){
+  const OtaStats& t = otaStats;
+  struct Row { const char* name; uint32_t bytes, us; };
+  const Row rows[] = { {"net", t.netBytes, t.netUs}, {"decode", t.decodeBytes, t.decodeUs},
+                       {"sha", t.shaBytes, t.shaUs}, {"erase", t.eraseBytes, t.eraseUs},
+                       {"program", t.programBytes, t.programUs} };
+  Serial.printf("[OTA] %-8s %8s %8s %8s\n", "stage", "KB", "ms", "KB/s");
+  for (const Row& r : rows)
+    Serial.printf("[OTA] %-8s %8lu %8lu %8.1f\n", r.name, (unsigned long)(r.bytes / 1024), (unsigned long)(r.us / 1000),
+                  r.us ? r.bytes * 1000000.0f / 1024.0f / r.us : 0.0f);
+  Serial.printf("[OTA] ring full %lu ms, writer idle %lu ms, total %lu ms\n", (unsigned long)(t.stallUs / 1000),
+                (unsigned long)(t.idleUs / 1000), (unsigned long)(t.totalUs / 1000));
+}
+
+static esp_err_t otaFail(esp_err_t err, const char* why){
+  otaWriterAbort();
+  otaProg.stage = OTA_FAILED;
+  Serial.printf("[OTA] %s after %lu/%lu bytes\n", why, (unsigned long)otaProg.done.load(), (unsigned long)otaProg.total.load());
+  return err;
+}
+
+// Conditional check before any image bytes move: one small GET of the
+// manifest, with If-None-Match carrying the ETag saved when the manifest last
+// named this build. 304, or a manifest naming FW_VERSION, means nothing to do.
+// No manifest (older releases) or an unreadable one falls back to the full
+// image; haveManifest then stays false and only Update's own checks apply.
+static esp_err_t otaCheck(OtaManifest& m, bool& haveManifest){
+  haveManifest = false;
+  WiFiClientSecure client; client.setInsecure();
+  HTTPClient http;
+  http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
+  static const char* HDRS[] = {"ETag"};
+  http.collectHeaders(HDRS, 1);
+  if (!http.begin(client, OTA_MANIFEST_URL)) return ESP_FAIL;
+  String mine = String(FW_VERSION) + " ";
+  String saved = prefs.getString(KEY_OTA_ETAG, "");
+  if (saved.startsWith(mine)) http.addHeader("If-None-Match", saved.substring(mine.length()));
+
+  int code = http.GET();
+  if (code == HTTP_CODE_NOT_MODIFIED){
+    Serial.printf("[OTA] manifest unchanged (304), %s is current\n", FW_VERSION);
+    return OTA_UP_TO_DATE;
+  }
+  if (code < 0) return ESP_FAIL;
+  if (code != HTTP_CODE_OK){
+    Serial.printf("[OTA] no manifest (%d), full download\n", code);
+    return ESP_OK;
+  }
+  String body = http.getString();
+  if (!otaManifestParse(body.c_str(), body.length(), m)){
+    Serial.println("[OTA] manifest unreadable, full download");
+    return ESP_OK;
+  }
+  haveManifest = true;
+  if (strcmp(m.version, FW_VERSION) == 0){
+    String etag = http.header("ETag");
+    if (etag.length()) prefs.putString(KEY_OTA_ETAG, mine + etag);
+    Serial.printf("[OTA] manifest names %s, nothing to do\n", FW_VERSION);
+    return OTA_UP_TO_DATE;
+  }
+  Serial.printf("[OTA] %s -> %s, %lu bytes\n", FW_VERSION, m.version, (unsigned long)m.size);
+  return ESP_OK;
+}
+
+// One asset download: pulled in chunks by the raw loop or by the inflater.
+// Every chunk is where cancel, stall and progress are handled.
+struct OtaStream {
+  HTTPClient* http;
+  WiFiClient* in;
+  uint32_t    got, len;       // wire bytes
+  uint32_t    written;        // image bytes into the flash writer
+  uint32_t    tLastByte;
+  esp_err_t   err;
+  const OtaManifest* man;     // nullptr without one
+};
+
+static size_t otaPullWire(OtaStream& s, uint8_t* buf, size_t cap){
+  for (;;){
+    if (s.got >= s.len) return 0;
+    if (otaCancel){ s.err = OTA_ERR_CANCELLED; return 0; }
+    int avail = s.in->available();
+    if (avail > 0){
+      int n = s.in->read(buf, min((size_t)avail, min(cap, (size_t)(s.len - s.got))));
+      if (n <= 0) continue;
+      s.got += n;
+      otaProg.done = s.got;
+      s.tLastByte = millis();
+      return (size_t)n;
+    }
+    if (!s.http->connected() || millis() - s.tLastByte > OTA_STALL_MS){ s.err = ESP_ERR_TIMEOUT; return 0; }
+    delay(1);
+  }
+}
+
+static size_t otaPull(void* ctx, uint8_t* buf, size_t cap){
+  uint32_t t0 = micros();
+  size_t n = otaPullWire(*(OtaStream*)ctx, buf, cap);
+  otaStats.netUs += micros() - t0;
+  otaStats.netBytes += n;
+  return n;
+}
+
+static bool otaSink(void* ctx, const uint8_t* p, size_t n){
+  OtaStream& s = *(OtaStream*)ctx;
+  if (!otaWriterPut(p, n)){ s.err = otaW.err; return false; }
+  s.written += n;
+  return true;
+}
+
+static esp_err_t otaStreamFail(const OtaStream& s){
+  return otaFail(s.err, s.err == OTA_ERR_CANCELLED ? "cancelled" : s.err == ESP_ERR_TIMEOUT ? "stream stalled" : esp_err_to_name(s.err));
+}
+
+// GET url; HTTP status, or <0 for transport errors
+static int otaOpen(HTTPClient& http, WiFiClient& client, const char* url){
+  http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);   // /latest/ redirects to the asset
+  if (!http.begin(client, url)) return HTTPC_ERROR_CONNECTION_REFUSED;
+  return http.GET();
+}
+
+// The slot opens once the image size is known: from the TL header, or for a
+// delta from the patch header, and it has to agree with the manifest either way
+static bool otaBegin(OtaStream& s, uint32_t rawLen){
+  if (s.man && rawLen != s.man->size){ s.err = ESP_ERR_INVALID_SIZE; Serial.println("[OTA] size differs from manifest"); return false; }
+  if (!otaWriterBegin(rawLen)){ s.err = otaW.err; return false; }
+  otaProg.rawTotal = rawLen;
+  return true;
+}
+
+// ------------------- Delta OTA -------------------
+// A release can carry bsdiff-style patches (src/delta_patch.h) from earlier
+// releases, named after the SHA-256 of the image they apply to. The patch
+// inflates and applies in one pass: new bytes come from the running slot
+// plus the patch and go straight into the flash writer, so only the changes
+// cross the link. The running image is identified by hashing it back out of flash.
+static DeltaApplier otaDelta;
+
+static bool otaRunningImage(uint8_t sha[Sha256::DIGEST], uint32_t& len){
+  static uint8_t  cached[Sha256::DIGEST];
+  static uint32_t cachedLen = 0;   // hashed once per boot
+  if (!cachedLen){
+    const esp_partition_t* run = esp_ota_get_running_partition();
+    uint32_t n = ESP.getSketchSize();
+    if (!run || !n) return false;
+    static uint8_t buf[1024];
+    mbedtls_sha256_context h;
+    mbedtls_sha256_init(&h);
+    mbedtls_sha256_starts(&h, 0);
+    bool ok = true;
+    for (uint32_t at = 0; ok && at < n; at += sizeof(buf)){
+      uint32_t k = min((uint32_t)sizeof(buf), n - at);
+      ok = esp_partition_read(run, at, buf, k) == ESP_OK;
+      if (ok) mbedtls_sha256_update(&h, buf, k);
+    }
+    if (ok) mbedtls_sha256_finish(&h, cached);
+    mbedtls_sha256_free(&h);
+    if (!ok) return false;
+    cachedLen = n;
+  }
+  memcpy(sha, cached, sizeof(cached));
+  len = cachedLen;
+  return true;
+}
+
+static bool otaReadOld(void*, uint32_t off, uint8_t* buf, size_t n){
+  return esp_partition_read(esp_ota_get_running_partition(), off, buf, n) == ESP_OK;
+}
+
+static bool otaDeltaOut(void* ctx, const uint8_t* p, size_t n){
+  OtaStream& s = *(OtaStream*)ctx;
+  if (!s.written && !otaW.running && !otaBegin(s, otaDelta.newSize())) return false;
+  return otaSink(ctx, p, n);
+}
+
+static bool otaDeltaIn(void* ctx, const uint8_t* p, size_t n){
+  OtaStream& s = *(OtaStream*)ctx;
+  if (otaDelta.feed(p, n)) return true;
+  if (!s.err) s.err = ESP_ERR_INVALID_RESPONSE;
+  return false;
+}
+
+// ------------------- OTA fetch -------------------
+enum OtaSource : uint8_t { OTA_SRC_DELTA, OTA_SRC_GZ, OTA_SRC_RAW };
+static const char* const OTA_SOURCE_NAME[] = { "delta", "gzip", "raw" };
+
+// One asset into the inactive slot, written but not committed. A missing
+// asset returns ESP_ERR_NOT_FOUND before Update is touched, so the caller can
+// move on to the next source; everything else has gone through otaFail().
+static esp_err_t otaFetch(OtaSource src, const char* url, OtaStream& s){
+  otaProg.stage = OTA_CONNECT;
+  otaProg.source = src;
+  otaProg.done = 0; otaProg.total = 0;
+  WiFiClientSecure client; client.setInsecure();
+  HTTPClient http;
+  int code = otaOpen(http, client, url);
+  if (code == HTTP_CODE_NOT_FOUND){
+    Serial.printf("[OTA] no %s asset\n", OTA_SOURCE_NAME[src]);
+    return ESP_ERR_NOT_FOUND;
+  }
+  if (code != HTTP_CODE_OK){
+    Serial.printf("[OTA] GET -> %d\n", code);
+    return otaFail(code < 0 ? ESP_FAIL : ESP_ERR_INVALID_RESPONSE, "GET failed");
+  }
+  int len = http.getSize();
+  if (len <= 0) return otaFail(ESP_ERR_INVALID_SIZE, "no length");
+
+  s.http = &http; s.in = http.getStreamPtr();
+  s.got = 0; s.len = len; s.written = 0; s.err = ESP_OK;
+  s.tLastByte = millis();
+  otaStats = OtaStats{};
+  otaStatsT0 = micros();
+  otaProg.total = len;
+  otaProg.startMs = millis();
+  otaProg.stage = OTA_DOWNLOAD;
+
+  // A gzip asset names its inflated size in the header, ahead of the first block
+  static uint8_t buf[OTA_CHUNK];
+  GzipHeader hdr;
+  size_t     have = 0;
+  if (src != OTA_SRC_RAW){
+    int hp = 0;
+    while ((hp = gzipParseHeader(buf, have, hdr)) == 0 && have < 64){
+      size_t n = otaPull(&s, buf + have, 64 - have);
+      if (!n) return s.err ? otaStreamFail(s) : otaFail(ESP_ERR_INVALID_RESPONSE, "gzip header cut short");
+      have += n;
+    }
+    if (hp <= 0) return otaFail(ESP_ERR_INVALID_RESPONSE, "not a TL gzip image");
+  }
+
+  if (src == OTA_SRC_RAW){
+    if (!otaBegin(s, len)) return otaFail(s.err, esp_err_to_name(s.err));
+    while (s.written < (uint32_t)len){
+      size_t n = otaPull(&s, buf, sizeof(buf));   // the writer ring re-blocks it into sectors
+      if (!n || !otaSink(&s, buf, n)) return otaStreamFail(s);
+    }
+  } else {
+    static Inflater inf;   // 4 KB window + input buffer; inflates straight into Update (or the patch applier)
+    bool delta = src == OTA_SRC_DELTA;
+    if (delta){
+      uint8_t  base[Sha256::DIGEST];
+      uint32_t baseLen;
+      if (!otaRunningImage(base, baseLen)) return otaFail(ESP_ERR_NOT_SUPPORTED, "running image unreadable");
+      otaDelta.begin(base, baseLen, otaReadOld, otaDeltaOut, &s);
+    } else if (!otaBegin(s, hdr.rawSize)) return otaFail(s.err, esp_err_to_name(s.err));
+    Inflater::Status st = inf.gunzip(hdr, buf + hdr.len, have - hdr.len, otaPull, delta ? otaDeltaIn : otaSink, &s);
+    if (st == Inflater::INF_OK && delta && !otaDelta.finished()) st = Inflater::INF_ERR_CHECK;
+    if (st != Inflater::INF_OK){
+      if (s.err && s.err != ESP_ERR_INVALID_RESPONSE) return otaStreamFail(s);
+      if (delta && otaDelta.status() != DeltaApplier::DP_OK){
+        Serial.printf("[OTA] patch error %d at %lu image bytes\n", otaDelta.status(), (unsigned long)otaDelta.produced());
+        return otaFail(ESP_ERR_INVALID_RESPONSE, otaDelta.status() == DeltaApplier::DP_ERR_BASE ? "patch is for another image" : "bad patch");
+      }
+      Serial.printf("[OTA] inflate error %d at %lu bytes\n", st, (unsigned long)inf.outBytes());
+      return otaFail(ESP_ERR_INVALID_RESPONSE, "bad compressed stream");
+    }
+  }
+  http.end();
+  return ESP_OK;
 }
 
+// Delta first, then the gzip image, then the raw one; whichever lands, the
+// boot switch only happens for exactly the image the release describes.
+// Returns ESP_OK with the boot partition switched; the caller reboots.
 static esp_err_t runGithubOta(){
   if (WiFi.status()!=WL_CONNECTED) return ESP_ERR_INVALID_STATE;
-  WiFiClientSecure client; client.setInsecure();
-  HTTPUpdate updater; updater.rebootOnUpdate(true);
-  tft.fillScreen(ST77XX_BLACK); tft.setCursor(0,0); tft.print("OTA updating…");
-  return (updater.update(client, OTA_LATEST_ASSET_URL)==HTTP_UPDATE_OK)?ESP_OK:ESP_FAIL;
+  otaProg.done = 0; otaProg.total = 0; otaProg.rawTotal = 0;
+  otaProg.stage = OTA_CHECK;
+
+  static OtaManifest man;
+  bool haveMan = false;
+  esp_err_t chk = otaCheck(man, haveMan);
+  if (chk == OTA_UP_TO_DATE){ otaProg.stage = OTA_IDLE; return chk; }
+  if (chk != ESP_OK) return otaFail(chk, "manifest check failed");
+  if (haveMan) otaProg.rawTotal = man.size;
+
+  static OtaStream s;
+  s.man = haveMan ? &man : nullptr;
+  esp_err_t r = ESP_ERR_NOT_FOUND;
+  OtaSource src = OTA_SRC_DELTA;
+  uint8_t  base[Sha256::DIGEST];
+  uint32_t baseLen;
+  if (otaRunningImage(base, baseLen)){
+    char hex[2 * Sha256::DIGEST + 1];
+    Sha256::toHex(base, hex);
+    hex[16] = 0;
+    r = otaFetch(src, (String(OTA_DELTA_URL_PREFIX) + hex + ".gz").c_str(), s);
+    if (r != ESP_OK && r != ESP_ERR_NOT_FOUND && r != OTA_ERR_CANCELLED)
+      Serial.println("[OTA] delta failed, fetching the full image");
+  }
+  // Releases without a compressed asset fall back to the raw image
+  if (r != ESP_OK && r != OTA_ERR_CANCELLED) r = otaFetch(src = OTA_SRC_GZ, OTA_GZ_ASSET_URL, s);
+  if (r == ESP_ERR_NOT_FOUND) r = otaFetch(src = OTA_SRC_RAW, OTA_LATEST_ASSET_URL, s);
+  if (r == ESP_ERR_NOT_FOUND) return otaFail(r, "no image");
+  if (r != ESP_OK) return r;
+
+  otaProg.stage = OTA_FINISH;
+  uint32_t producedUs = micros() - otaStatsT0;
+  uint8_t got[Sha256::DIGEST];
+  esp_err_t w = otaWriterFinish(got);
+  otaStats.decodeBytes = s.written;
+  otaStats.decodeUs = producedUs - otaStats.netUs - otaStats.stallUs;
+  if (w != ESP_OK) return otaFail(w, esp_err_to_name(w));
+  if (src == OTA_SRC_DELTA && memcmp(got, otaDelta.newSha(), sizeof(got)) != 0)
+    return otaFail(ESP_ERR_INVALID_CRC, "SHA-256 differs from patch");
+  if (haveMan && man.hasSha && memcmp(got, man.sha256, sizeof(got)) != 0)
+    return otaFail(ESP_ERR_INVALID_CRC, "SHA-256 differs from manifest");
+  w = otaWriterCommit();
+  if (w != ESP_OK) return otaFail(w, esp_err_to_name(w));
+  otaProg.stage = OTA_DONE;
+  otaStats.totalUs = micros() - otaStatsT0;
+  uint32_t ms = millis() - otaProg.startMs;
+  Serial.printf("[OTA] %lu bytes (%lu on the wire, %s) in %.1f s (%.1f KB/s), boot slot switched\n",
+                (unsigned long)s.written, (unsigned long)s.got, OTA_SOURCE_NAME[src], ms / 1000.0f,
+                ms ? s.got / 1.024f / ms : 0.0f);
+  otaStatsDump();
+  return ESP_OK;
+}
+
+// UI side of "OTA Update": the network task does the work; this screen only
+// reads otaProg. Back raises otaCancel and the download stops at its next chunk.
+static void otaUpdateUI(){
+  otaCancel = false;
+  uiToNet.push(NetCmd{NC_OTA, {0}, {0}});
+  NetEvt ev{NE_OTA_RESULT, 0};
+  bool     cancelling = false;
+  uint32_t lastDraw = 0, lastDone = 0, lastMs = millis();
+  float    rateBps = 0.0f;   // smoothed over the 500 ms redraws
+  for (;;){
+    bool got = false;
+    while (netToUi.pop(ev)) if (ev.type == NE_OTA_RESULT){ got = true; break; }
+    if (got) break;
+    if (!cancelling && readKoPressed()){ otaCancel = true; cancelling = true; lastDraw = 0; }
+    if (lastDraw && millis() - lastDraw < 500){ uiDelay(50); continue; }
+    lastDraw = millis();
+
+    uint8_t  st = otaProg.stage;
+    uint32_t done = otaProg.done, total = otaProg.total;
+    uint32_t dt = millis() - lastMs;
+    if (st == OTA_DOWNLOAD && dt && done >= lastDone){
+      float inst = (done - lastDone) * 1000.0f / dt;
+      rateBps = rateBps > 0 ? rateBps * 0.7f + inst * 0.3f : inst;
+    }
+    lastDone = done; lastMs = millis();
+
+    tft.fillScreen(ST77XX_BLACK);
+    tft.setCursor(0,0); tft.setTextColor(ST77XX_CYAN); tft.printf("OTA Update  %s", FW_VERSION);
+    tft.setTextColor(ST77XX_WHITE);
+    tft.setCursor(0,16); tft.print(cancelling ? "Cancelling..." : OTA_STAGE_NAME[st]);
+    tft.drawRect(0, 30, TFT_W, 12, ST77XX_WHITE);
+    if (total) tft.fillRect(2, 32, (int16_t)((uint64_t)(TFT_W - 4) * done / total), 8, ST77XX_GREEN);
+    tft.setCursor(0,48);
+    tft.printf("%lu / %lu KB", (unsigned long)(done / 1024), (unsigned long)(total / 1024));
+    uint32_t raw = otaProg.rawTotal;
+    if (raw && total && raw != total){
+      tft.setCursor(0,70); tft.printf("%s, %lu KB image", OTA_SOURCE_NAME[otaProg.source], (unsigned long)(raw / 1024));
+    }
+    tft.setCursor(0,60);
+    if (rateBps > 0){
+      tft.printf("%.1f KB/s  ETA %lus", rateBps / 1024.0f, (unsigned long)((total - done) / rateBps + 0.5f));
+    } else tft.print("-- KB/s");
+    // The box is still live underneath
+    InaSample v = inaLatest();
+    tft.setCursor(0,90); tft.setTextColor(ST77XX_YELLOW);
+    tft.printf("Load %.2fA  Src %.1fV", v.loadA, v.srcV);
+    tft.setCursor(0,118); tft.print("Back = cancel");
+    uiDelay(50);
+  }
+
+  tft.fillScreen(ST77XX_BLACK); tft.setCursor(0,0); tft.setTextColor(ST77XX_WHITE);
+  if (ev.code == ESP_OK){
+    sendProt(PC_OFF_ALL);   // drop the loads cleanly before the network task reboots
+    tft.print("Update OK, rebooting...");
+    const OtaStats& t = otaStats;
+    uint32_t flashUs = t.eraseUs + t.programUs;
+    tft.setCursor(0,16);
+    tft.printf("net %.0f  flash %.0f KB/s", t.netUs ? t.netBytes * 1000000.0f / 1024.0f / t.netUs : 0.0f,
+               flashUs ? t.programBytes * 1000000.0f / 1024.0f / flashUs : 0.0f);
+    buzzerBeep(90);
+  } else if (ev.code == OTA_UP_TO_DATE){
+    tft.printf("Up to date (%s)", FW_VERSION);
+    buzzerBeep();
+  } else {
+    tft.print(ev.code == ESP_ERR_INVALID_STATE ? "Wi-Fi not connected"
+            : ev.code == OTA_ERR_CANCELLED     ? "OTA cancelled"
+            : ev.code == ESP_ERR_INVALID_CRC   ? "Image hash mismatch"
+            : ev.code == ESP_ERR_TIMEOUT       ? "OTA stalled"
+            : ev.code == ESP_ERR_NOT_FOUND     ? "No image on server"
+            :                                    "OTA failed");
+    if (ev.code != OTA_ERR_CANCELLED) buzzerAlarm(300);
+  }
+  uiDelay(ev.code == ESP_OK ? OTA_REBOOT_MS : 1200);
 }
 
 // ------------------- Menu UI -------------------
 static const char* menuItems[] = {
   
   "All Relays OFF",
+  "Light Set ON",
   "Set OCP Limit",
   "Set Low-Volt Cutoff",
+  "Verify Cache TTL",
   "Learn Remote",
   "Brightness",
+  "Flash Pattern",
   "Wi-Fi Scan & Connect",
   "Wi-Fi Forget",
   "OTA Update",
+  "Diagnostics",
   
 };
 static int menuCount = sizeof(menuItems)/sizeof(menuItems[0]);
 static int menuIndex=0;
+static constexpr uint8_t MENU_ROWS = 10;   // rows that fit above the footer; the list scrolls
+static constexpr uint8_t LIGHT_SET_MASK = (1u << R_TAIL) | (1u << R_MARKER) | (1u << R_BRAKE);
 
 static void drawMenu(){
   uiInMenu = true;
   tft.fillScreen(ST77XX_BLACK); tft.setCursor(0,0);
   tft.setTextColor(ST77XX_CYAN); tft.print("Menu");
-  for (int i=0;i<menuCount;i++){
+  int top = max(0, min(menuIndex - MENU_ROWS/2, menuCount - (int)MENU_ROWS));
+  for (int i=top;i<menuCount && i<top+MENU_ROWS;i++){
     if (i==menuIndex) tft.setTextColor(ST77XX_BLACK, ST77XX_CYAN);
     else              tft.setTextColor(ST77XX_WHITE, ST77XX_BLACK);
-    tft.setCursor(0, i*12+14); tft.print(menuItems[i]);
+    tft.setCursor(0, (i-top)*10+14); tft.print(menuItems[i]);
   }
-  tft.setCursor(0, 14 + menuCount*12 + 4);
+  if (menuCount > MENU_ROWS){
+    tft.setTextColor(ST77XX_CYAN, ST77XX_BLACK);
+    tft.setCursor(TFT_W - 2*GLYPH_W, 0); tft.printf("%c%c", top ? '^' : ' ', top + MENU_ROWS < menuCount ? 'v' : ' ');
+  }
+  tft.setCursor(0, 14 + min(menuCount, (int)MENU_ROWS)*10 + 4);
   tft.setTextColor(ST77XX_YELLOW);
   tft.print("Back = Exit");
 }
@@ -712,25 +2732,95 @@ static void exitMenuToStatus(){
 }
 
 // ------------------- Encoder + Back button helpers -------------------
-static bool btn_last=true;
-static int8_t readEncoderStep(){
-  static uint8_t last=0;
-  uint8_t a=digitalRead(PIN_ENC_A), b=digitalRead(PIN_ENC_B), cur=(a<<1)|b;
-  int8_t s=0;
-  if((last==0&&cur==1)||(last==1&&cur==3)||(last==3&&cur==2)||(last==2&&cur==0))s=+1;
-  if((last==0&&cur==2)||(last==2&&cur==3)||(last==3&&cur==1)||(last==1&&cur==0))s=-1;
-  last=cur; return s;
+// Quadrature is decoded in a pin-change ISR into a running count, so steps
+// are never lost to a slow redraw or a uiDelay(); the UI takes whole detents.
+// OK/Back edges restart a one-shot settle timer; its callback snapshots both
+// buttons and queues clean press/release events for the UI task.
+static constexpr int8_t   ENC_QUARTERS_PER_DETENT = 4;   // full quadrature cycle per click
+static constexpr uint32_t BTN_SETTLE_US = 8000;
+
+enum InputEvtType : uint8_t { IN_OK_DOWN, IN_OK_UP, IN_KO_DOWN, IN_KO_UP };
+struct InputEvt { InputEvtType type; uint32_t tMs; };
+static SpscQueue<InputEvt, 16> inputQ;   // settle timer -> UI
+
+// (last<<2)|cur -> -1/0/+1; a two-bit jump is a glitch and counts nothing
+static const int8_t ENC_QDEC[16] = { 0,+1,-1, 0, -1, 0, 0,+1, +1, 0, 0,-1,  0,-1,+1, 0 };
+static std::atomic<int32_t> encQuarters{0};
+static uint8_t              encLast = 0;
+static int32_t              encTaken = 0;        // quarters already handed to the UI
+static esp_timer_handle_t   btnTimer = nullptr;
+static bool                 btnOkDown = false, btnKoDown = false;   // settled (timer side)
+
+static inline uint32_t IRAM_ATTR gpioLevel(int pin){
+  return pin < 32 ? (REG_READ(GPIO_IN_REG) >> pin) & 1u : (REG_READ(GPIO_IN1_REG) >> (pin - 32)) & 1u;
+}
+
+static void IRAM_ATTR encIsr(){
+  uint8_t cur = (uint8_t)((gpioLevel(PIN_ENC_A) << 1) | gpioLevel(PIN_ENC_B));
+  int8_t d = ENC_QDEC[(encLast << 2) | cur];
+  encLast = cur;
+  if (d) encQuarters.fetch_add(d, std::memory_order_relaxed);
+}
+
+static void IRAM_ATTR btnEdgeIsr(){
+  esp_timer_stop(btnTimer);                    // every bounce restarts the window
+  esp_timer_start_once(btnTimer, BTN_SETTLE_US);
 }
-static bool readOkPressed(){ bool cur=!digitalRead(PIN_ENC_OK); bool p=(cur && !btn_last); btn_last=cur; return p; }
-static bool readKoPressed(){ return !digitalRead(PIN_ENC_KO); }  // Physical "Back"
-static bool okIsDown(){ return !digitalRead(PIN_ENC_OK); }
 
+static void btnSettledCb(void*){
+  bool ok = !gpioLevel(PIN_ENC_OK), ko = !gpioLevel(PIN_ENC_KO);
+  uint32_t t = millis();
+  if (ok != btnOkDown){ btnOkDown = ok; inputQ.push(InputEvt{ok ? IN_OK_DOWN : IN_OK_UP, t}); }
+  if (ko != btnKoDown){ btnKoDown = ko; inputQ.push(InputEvt{ko ? IN_KO_DOWN : IN_KO_UP, t}); }
+}
+
+static void inputInit(){
+  encLast = (uint8_t)((gpioLevel(PIN_ENC_A) << 1) | gpioLevel(PIN_ENC_B));
+  btnOkDown = !gpioLevel(PIN_ENC_OK); btnKoDown = !gpioLevel(PIN_ENC_KO);
+  if (!btnTimer){
+    const esp_timer_create_args_t args = { btnSettledCb, nullptr, ESP_TIMER_TASK, "btn", false };
+    esp_timer_create(&args, &btnTimer);
+  }
+  attachInterrupt(digitalPinToInterrupt(PIN_ENC_A),  encIsr,     CHANGE);
+  attachInterrupt(digitalPinToInterrupt(PIN_ENC_B),  encIsr,     CHANGE);
+  attachInterrupt(digitalPinToInterrupt(PIN_ENC_OK), btnEdgeIsr, CHANGE);
+  attachInterrupt(digitalPinToInterrupt(PIN_ENC_KO), btnEdgeIsr, CHANGE);
+}
+
+// UI side: fold queued events into pending presses and the held state
+static uint8_t okPresses = 0, koPresses = 0;
+static bool    okHeld = false;
+static void inputPoll(){
+  InputEvt e;
+  while (inputQ.pop(e)){
+    switch (e.type){
+      case IN_OK_DOWN: okHeld = true; if (okPresses < 255) okPresses++; break;
+      case IN_OK_UP:   okHeld = false; break;
+      case IN_KO_DOWN: if (koPresses < 255) koPresses++; break;
+      case IN_KO_UP:   break;
+    }
+  }
+}
+
+// Whole detents turned since the last call (any number, not just one)
+static int8_t readEncoderStep(){
+  int32_t d = (encQuarters.load(std::memory_order_relaxed) - encTaken) / ENC_QUARTERS_PER_DETENT;
+  d = max((int32_t)-127, min(d, (int32_t)127));
+  encTaken += d * ENC_QUARTERS_PER_DETENT;
+  return (int8_t)d;
+}
+static bool readOkPressed(){ inputPoll(); if (!okPresses) return false; okPresses--; return true; }
+static bool readKoPressed(){ inputPoll(); if (!koPresses) return false; koPresses--; return true; }  // Physical "Back"
+static bool okIsDown(){ inputPoll(); return okHeld; }
 // ------------------- Fault choice popup (interactive) -------------------
 
 
 // Returns true if user presses OK to enable anyway, false if Back to cancel
-static bool showFaultChoicePopup(FaultType ft, RelayId r) {
-  bool wasInMenu = uiInMenu;
+// Returns true for "OK = Enable". The caller puts the screen back.
+static bool showFaultChoicePopup(const UiEvt& ev) {
+  FaultType ft = (FaultType)ev.code;
+  RelayId   r  = (RelayId)ev.relay;
+  bool info = (ft == FAULT_LVP || ft == FAULT_MISSED || ft == FAULT_OCP);   // nothing to enable
 
   for (;;) {
     tft.fillScreen(ST77XX_BLACK);
@@ -742,15 +2832,28 @@ static bool showFaultChoicePopup(FaultType ft, RelayId r) {
     } else if (ft == FAULT_SHORT) {
       tft.setTextColor(ST77XX_RED, ST77XX_BLACK);
       tft.print("SHORT detected");
-    } else {
+    } else if (ft == FAULT_LVP) {
       tft.setTextColor(ST77XX_RED, ST77XX_BLACK);
       tft.print("LOW SOURCE VOLTAGE");
+    } else if (ft == FAULT_OCP) {
+      tft.setTextColor(ST77XX_RED, ST77XX_BLACK);
+      tft.print("OVERCURRENT TRIP");
+    } else {
+      tft.setTextColor(ST77XX_RED, ST77XX_BLACK);
+      tft.print("FAULTS NOT SHOWN");
     }
 
     tft.setCursor(0, 20);
     tft.setTextColor(ST77XX_WHITE, ST77XX_BLACK);
     if (ft == FAULT_LVP) {
       tft.print("Battery below cutoff\nRelays disabled");
+    } else if (ft == FAULT_MISSED) {
+      tft.print("More faults than fit\nCheck the outputs");
+    } else if (ft == FAULT_OCP) {
+      tft.print("Dropped:");
+      for (int i=0;i<R_COUNT;i++) if (ev.mask & (1u << i)){ tft.print(' '); tft.print(relayName((RelayId)i)); }
+      tft.setCursor(0, 46);
+      tft.printf("in %lu cycles", (unsigned long)ev.arg);
     } else {
       tft.print("On relay: ");
       tft.print(relayName(r));
@@ -760,6 +2863,8 @@ static bool showFaultChoicePopup(FaultType ft, RelayId r) {
       tft.setCursor(0, 46);
       tft.setTextColor(ST77XX_YELLOW, ST77XX_BLACK);
       tft.printf("Raise > %.1fV to clear", LV_CUTOFF_V + LV_RELEASE_HYST_V);
+    }
+    if (info) {
       tft.setCursor(0, 62);
       tft.setTextColor(ST77XX_CYAN, ST77XX_BLACK);
       tft.print("Back = OK");
@@ -773,104 +2878,97 @@ static bool showFaultChoicePopup(FaultType ft, RelayId r) {
       tft.print("OK = Enable");
     }
 
-    if (ft == FAULT_LVP) {
-      if (readOkPressed() || readKoPressed()) { // single button to exit
-        if (wasInMenu) drawMenu(); else drawStatusPage(true);
-        return false;
-      }
+    if (info) {
+      if (readOkPressed() || readKoPressed()) return false;   // single button to exit
     } else {
-      if (readOkPressed()) {             // OK → enable anyway
-        if (wasInMenu) drawMenu(); else drawStatusPage(true);
-        return true;
-      }
-      if (readKoPressed()) {             // Back → cancel
-        if (wasInMenu) drawMenu(); else drawStatusPage(true);
-        return false;
-      }
+      if (readOkPressed()) return true;    // OK → enable anyway
+      if (readKoPressed()) return false;   // Back → cancel
     }
-    delay(10);
+    uiDelay(10);
   }
 }
 
 // ------------------- Menu handlers ----
+// Scan-all screen: the protection task pulses (scanAllService) and streams
+// one UE_SCAN_RESULT per channel; this just renders until UE_SCAN_DONE.
 static void scanAllRelays(){
-  // Preserve state
-  RelayId prev = currentActiveRelay();
-  bool prevFlash = flashMode; RelayId prevFlashT = flashTarget;
-  flashMode = false; relayOffAll();
-
   enum S{S_OK=0,S_OPEN,S_SHORT};
-  S res[R_COUNT];
 
   // Title
   tft.fillScreen(ST77XX_BLACK);
   tft.setCursor(0,0); tft.setTextColor(ST77XX_CYAN); tft.print("Scanning outputs…");
-
-  for(int i=0;i<R_COUNT;i++){
-    // Abort if LVP during scan
-    if (lvpActive) break;
-
-    // Pulse
-    relayOn((RelayId)i);
-    delay(PULSE_MS);
-    float ia = INA226::currentA();
-    bool ocp = INA226::overCurrent();
-    delay(POST_PULSE_MS);
-    relayOff((RelayId)i);
-
-    if (ocp || ia >= FAST_SHORT_A) res[i]=S_SHORT;
-    else if (ia < OPEN_THRESH_A)   res[i]=S_OPEN;
-    else                           res[i]=S_OK;
-
-    // Render incremental result line
-    tft.setCursor(0, 16 + i*12);
-    switch(res[i]){
-      case S_OK:   tft.setTextColor(ST77XX_GREEN, ST77XX_BLACK); break;
-      case S_OPEN: tft.setTextColor(ST77XX_YELLOW, ST77XX_BLACK); break;
-      case S_SHORT:tft.setTextColor(ST77XX_RED, ST77XX_BLACK); break;
+  sendProt(PC_SCAN_ALL);
+
+  bool aborted = false;
+  uint32_t totalUs = 0;
+  for (bool done=false; !done; ){
+    UiEvt ev;
+    while (protToUi.pop(ev)){
+      if (ev.type==UE_SCAN_DONE){ aborted = ev.code; totalUs = ev.arg; done = true; break; }
+      if (ev.type!=UE_SCAN_RESULT || ev.relay<0 || ev.relay>=R_COUNT) continue;
+      int i = ev.relay;
+      // Render incremental result line
+      tft.setCursor(0, 16 + i*12);
+      switch(ev.code){
+        case S_OK:   tft.setTextColor(ST77XX_GREEN, ST77XX_BLACK); break;
+        case S_OPEN: tft.setTextColor(ST77XX_YELLOW, ST77XX_BLACK); break;
+        case S_SHORT:tft.setTextColor(ST77XX_RED, ST77XX_BLACK); break;
+      }
+      tft.printf("%-7s : %-5s %3lums\n", RELAY_LABELS[i], ev.code==S_OK?"OK":(ev.code==S_OPEN?"OPEN":"SHORT"),
+                 (unsigned long)(ev.arg / 1000));
     }
-    tft.printf("%-7s : %s\n", RELAY_LABELS[i], res[i]==S_OK?"OK":(res[i]==S_OPEN?"OPEN":"SHORT"));
-
+    uiDelay(10);
   }
 
   tft.setCursor(0, 16 + R_COUNT*12 + 6);
   tft.setTextColor(ST77XX_WHITE, ST77XX_BLACK);
-  if (lvpActive) tft.print("LVP tripped — scan aborted");
-  else           tft.print("Back/OK = Exit");
+  if (aborted) tft.print("LVP tripped — scan aborted");
+  else         tft.printf("Scan %.2f s  Back/OK = Exit", totalUs / 1e6f);
 
   // Wait for exit
   while(true){
     if (readKoPressed() || readOkPressed()) break;
-    delay(20);
+    uiDelay(20);
   }
 
   // Restore previous state
-  if (prev!=R_NONE && !lvpActive){ relayOn(prev); }
-  flashMode = prevFlash; flashTarget = prevFlashT;
+  sendProt(PC_SCAN_RESTORE);
   drawStatusPage(true);
 }
 static void startRfLearn(){
-  // 6-step wizard: LEFT, RIGHT, BRAKE, TAIL, MARKER, AUX
+  // 6-step wizard: LEFT, RIGHT, BRAKE, TAIL, MARKER, AUX. Each code is added
+  // to that relay's fobs (oldest dropped past RfCodeTable::MAX_PER_RELAY).
+  rfLearning = true;   // rfService() hands codes to rfLearnQ instead of acting
+  struct Release { ~Release(){ rfLearning = false; } } release;
+  uint8_t saved = 0;
   for (int i=0;i<R_COUNT;i++){
+    uint32_t have[RfCodeTable::MAX_PER_RELAY];
     tft.fillScreen(ST77XX_BLACK);
     tft.setCursor(0,0);  tft.setTextColor(ST77XX_WHITE);
-    tft.printf("Learn %s\n", RELAY_LABELS[i]);
+    tft.printf("Learn %s (%u/%u)\n", RELAY_LABELS[i], rfCodes.codesFor(i, have), RfCodeTable::MAX_PER_RELAY);
     tft.setCursor(0,14); tft.print("Press remote button");
-    tft.setCursor(0,26); tft.print("Back = cancel");
+    tft.setCursor(0,26); tft.print("OK = skip  Back = cancel");
 
-    uint32_t code = captureRfHashBlocking(8000);
-    if (code == 0){
+    tftPresent(true);
+    RfHeard code = {0, 0};
+    RfLearnRes res = rfAwaitLearnCode(8000, code);
+    if (res == RL_SKIP) continue;
+    if (res == RL_CANCEL){
       tft.fillScreen(ST77XX_BLACK); tft.setCursor(0,0); tft.print("Learning cancelled");
-      delay(1000); return;
+      uiDelay(1000); return;
     }
 
-    prefs.putULong(RF_PREF_KEYS[i], code);
-    tft.setCursor(0,40); tft.print("Saved: 0x"); tft.print(code, HEX);
-    buzzerBeep(80); delay(800);
+    int8_t was = rfCodes.find(code.code, code.proto);
+    rfCodes.add(code.code, i, code.proto);
+    rfCodesSave(i);
+    if (was >= 0 && was != i) rfCodesSave(was);   // code moved off another relay
+    saved++;
+    tft.setCursor(0,40); tft.print("Saved: 0x"); tft.print(code.code, HEX);
+    buzzerBeep(80); uiDelay(800);
   }
   tft.fillScreen(ST77XX_BLACK);
-  tft.setCursor(0,0); tft.print("All 6 saved!");
-  buzzerBeep(120); delay(1000);
+  tft.setCursor(0,0); tft.printf("%u saved!", saved);
+  buzzerBeep(120); uiDelay(1000);
 }
 
 static void adjustOcpLimit(){
@@ -879,11 +2977,11 @@ static void adjustOcpLimit(){
     int8_t s = readEncoderStep();
     if (s) cur += s;           // 1 A steps
     cur = max(5.0f, min(cur, 30.0f));
-    INA226::setOcpLimit(cur);
+    if (cur != OCP_LIMIT_A) sendProt(PC_SET_OCP, R_NONE, cur);
     tft.fillScreen(ST77XX_BLACK);
     tft.setCursor(0,0); tft.printf("OCP: %.1f A\n", cur);
     tft.setCursor(0,16); tft.setTextColor(ST77XX_YELLOW); tft.print("Back = Exit");
-    delay(140);
+    uiDelay(140);
   }
   prefs.putFloat(KEY_OCP, cur);
 }
@@ -899,11 +2997,31 @@ static void adjustLvCutoff(){
     tft.setCursor(0,0); tft.printf("LVP cutoff: %.1f V\n", cur);
     tft.setCursor(0,14); tft.printf("Release at: %.1f V\n", cur + LV_RELEASE_HYST_V);
     tft.setCursor(0,30); tft.setTextColor(ST77XX_YELLOW); tft.print("Back = Save/Exit");
-    delay(120);
+    uiDelay(120);
   }
   prefs.putFloat(KEY_LV_CUTOFF, cur);
 }
 
+// How long a passed pulse test lets the channel engage without another; 0 = always pulse
+static void adjustVerifyTtl(){
+  int sec = VERIFY_TTL_MS / 1000;
+  while (!readKoPressed()){
+    int8_t s = readEncoderStep();
+    if (s) sec += s * 10;             // 10 s steps
+    sec = max(0, min(sec, 600));
+    VERIFY_TTL_MS = (uint32_t)sec * 1000;   // verifyFresh() uses it from the next engage
+    tft.fillScreen(ST77XX_BLACK);
+    tft.setCursor(0,0);
+    if (sec) tft.printf("Verify TTL: %d s\n", sec);
+    else     tft.print("Verify TTL: off");
+    tft.setCursor(0,14); tft.print("Passed channels skip the");
+    tft.setCursor(0,24); tft.print("pulse test for this long");
+    tft.setCursor(0,40); tft.setTextColor(ST77XX_YELLOW); tft.print("Back = Save/Exit");
+    uiDelay(120);
+  }
+  prefs.putULong(KEY_VERIFY_TTL, VERIFY_TTL_MS);
+}
+
 static void adjustBrightness(){
   int val = prefs.getInt(KEY_BRIGHT, 200);
   ledcAttachPin(PIN_TFT_BL, 0); ledcSetup(0, 5000, 8);
@@ -915,22 +3033,158 @@ static void adjustBrightness(){
     tft.fillScreen(ST77XX_BLACK);
     tft.setCursor(0,0); tft.printf("Brightness: %d\n", val);
     tft.setCursor(0,16); tft.setTextColor(ST77XX_YELLOW); tft.print("Back = Exit");
-    delay(100);
+    uiDelay(100);
   }
   prefs.putInt(KEY_BRIGHT, val);
 }
 
+// Style / period / duty; OK moves between fields, Back saves. A running
+// flasher picks the new settings up on exit.
+static void adjustFlash(){
+  static const char* STYLE_NAME[FS_COUNT] = {"Single", "Hazard", "Alternate"};
+  int field = 0;
+  int style = FLASH_STYLE, period = FLASH_PERIOD_MS, duty = FLASH_DUTY_PCT;
+  while (!readKoPressed()){
+    if (readOkPressed()) field = (field + 1) % 3;
+    int8_t s = readEncoderStep();
+    if (s){
+      if (field == 0)      style  = wrapIndex(style, s, FS_COUNT);
+      else if (field == 1) period = max(200, min(period + s*50, 3000));   // 50 ms steps
+      else                 duty   = max(10, min(duty + s*5, 90));
+    }
+    tft.fillScreen(ST77XX_BLACK);
+    tft.setCursor(0,0); tft.setTextColor(ST77XX_CYAN); tft.print("Flash pattern");
+    for (int f=0; f<3; f++){
+      tft.setCursor(0, 16 + f*14);
+      if (f == field) tft.setTextColor(ST77XX_BLACK, ST77XX_CYAN);
+      else            tft.setTextColor(ST77XX_WHITE, ST77XX_BLACK);
+      if (f == 0)      tft.printf("Style:  %s", STYLE_NAME[style]);
+      else if (f == 1) tft.printf("Period: %d ms", period);
+      else             tft.printf("Duty:   %d %%", duty);
+    }
+    tft.setCursor(0, 64); tft.setTextColor(ST77XX_WHITE, ST77XX_BLACK);
+    tft.print("Hazard/Alt: LEFT+RIGHT");
+    tft.setCursor(0, 90); tft.setTextColor(ST77XX_YELLOW);
+    tft.print("OK = Next  Back = Save");
+    uiDelay(100);
+  }
+  FLASH_STYLE = (FlashStyle)style; FLASH_PERIOD_MS = (uint16_t)period; FLASH_DUTY_PCT = (uint8_t)duty;
+  prefs.putUChar(KEY_FLASH_STYLE, FLASH_STYLE);
+  prefs.putUShort(KEY_FLASH_PERIOD, FLASH_PERIOD_MS);
+  prefs.putUChar(KEY_FLASH_DUTY, FLASH_DUTY_PCT);
+  sendProt(PC_FLASH_CFG);
+}
+
+// One counter row, 26 columns at most: name in the latency name column
+static void diagRow(uint8_t row, char* buf, size_t n){
+  char a[8], b[8];
+  switch (row){
+    case DR_OCP:
+      snprintf(buf, n, "%-8s%4lu trip %5lucyc", "ocp", (unsigned long)ocpTripCount,
+               (unsigned long)ocpLastFault.latencyCyc);
+      break;
+    case DR_RUN:
+      snprintf(buf, n, "%-8s%lu px/s %lu B/s", "run", (unsigned long)statusPxPerSec,
+               (unsigned long)statusBytesPerSec);
+      break;
+    case DR_FB:   // frame time avg/max over the last second
+      snprintf(buf, n, "%-8s%2lufps %s/%s", "fb", (unsigned long)fbFps,
+               latFmt(fbFrameUsAvg, a, sizeof(a)), latFmt(fbFrameUsPeak, b, sizeof(b)));
+      break;
+    case DR_FB_PX:
+      snprintf(buf, n, "%-8s%lu px/s", "fb px", (unsigned long)fbPxPerSec);
+      break;
+    case DR_I2C:
+      snprintf(buf, n, "%-8s%lu txn/s %.1f%%", "i2c", (unsigned long)inaTxnPerSec, inaBusUtilPct);
+      break;
+    case DR_RF:
+      snprintf(buf, n, "%-8s%lu fr %lu hash", "rf", (unsigned long)rfFrames, (unsigned long)rfHashed);
+      break;
+    case DR_RF_LOST:   // lossy bursts skipped, edges the ring dropped
+      snprintf(buf, n, "%-8s%lu miss %lu drop", "rf lost", (unsigned long)rfMissed, (unsigned long)rfEdgeDrops);
+      break;
+    case DR_RF_TRUNC:
+      snprintf(buf, n, "%-8s %lu", "rf trunc", (unsigned long)rfTruncated);
+      break;
+    case DR_RF_LAT: {  // edge to decision: last/avg/max
+      char c[8];
+      snprintf(buf, n, "%-8s%s/%s/%s", "rf lat", latFmt(rfLatLastUs, a, sizeof(a)),
+               latFmt(rfFrames ? rfLatSumUs / rfFrames : 0, b, sizeof(b)), latFmt(rfLatMaxUs, c, sizeof(c)));
+    } break;
+    case DR_ENGAGE:   // last staggered engage: settled bus, sequence length
+      snprintf(buf, n, "%-8s%.2fA in %s", "engage", engageTotalA, latFmt(engageUs, a, sizeof(a)));
+      break;
+    default: snprintf(buf, n, "-"); break;
+  }
+}
+
+// Per-service latency table, then the counter rows: encoder scrolls, OK dumps to serial
+static void diagnosticsUI(){
+  static constexpr int ROWS = 9, TOTAL = LP_COUNT + DR_COUNT;
+  int top = 0;
+  uint32_t lastDraw = 0;
+  bool dirty = true;
+  while (!readKoPressed()){
+    int8_t s = readEncoderStep();
+    if (s){ top = max(0, min(top + s, TOTAL - ROWS)); dirty = true; }
+    if (readOkPressed()){ latDump(); buzzerBeep(); }
+    if (dirty || millis() - lastDraw > 500){
+      dirty = false; lastDraw = millis();
+      char a[8], b[8], c[8];
+      tft.fillScreen(ST77XX_BLACK);
+      tft.setCursor(0,0); tft.setTextColor(ST77XX_CYAN);
+      tft.printf("%-8s%6s%6s%6s", "Latency", "p50", "p99", "max");
+      for (int i=0;i<ROWS && top+i<TOTAL;i++){
+        tft.setCursor(0, 12 + i*10);
+        if (top+i >= LP_COUNT){
+          char row[32];
+          diagRow(top+i - LP_COUNT, row, sizeof(row));
+          tft.setTextColor(ST77XX_GREEN);
+          tft.print(row);
+          continue;
+        }
+        const LatencyHist& h = latHist[top+i];
+        tft.setTextColor(top+i >= LP_FIRST_MODAL ? ST77XX_CYAN : ST77XX_WHITE);
+        if (!h.count()){ tft.printf("%-8s     -", LAT_NAME[top+i]); continue; }
+        tft.printf("%-8s%6s%6s%6s", LAT_NAME[top+i], latFmt(h.percentileUs(50), a, sizeof(a)),
+                   latFmt(h.percentileUs(99), b, sizeof(b)), latFmt(h.maxUs(), c, sizeof(c)));
+      }
+      tft.setCursor(0, 106); tft.setTextColor(ST77XX_YELLOW);
+      if (latWorst.probe != LP_NONE)
+        tft.printf("Worst %s %s @%lus", LAT_NAME[latWorst.probe], latFmt(latWorst.us, a, sizeof(a)),
+                   (unsigned long)(latWorst.atMs / 1000));
+      else tft.print("Worst -");
+      tft.setCursor(0, 118); tft.print("OK=Dump  Back=Exit");
+    }
+    uiDelay(50);
+  }
+}
+
+// Same order as menuItems[]; LP_NONE = not a modal screen
+static const LatProbe MENU_PROBE[] = {
+  LP_NONE, LP_NONE, LP_SET_OCP, LP_SET_LVP, LP_SET_TTL, LP_LEARN, LP_BRIGHTNESS, LP_FLASH_CFG, LP_WIFI_SCAN,
+  LP_WIFI_FORGET, LP_OTA, LP_DIAG,
+};
+static_assert(sizeof(MENU_PROBE)/sizeof(MENU_PROBE[0]) == sizeof(menuItems)/sizeof(menuItems[0]),
+              "MENU_PROBE out of step with menuItems");
+
 static void doMenuAction(int idx){
+  int64_t t0 = esp_timer_get_time();
   switch(idx){
-    case 0: wifiScanAndConnectUI(); break;
-    case 1: wifiForget(); break;
-    case 2: runGithubOta(); break;
-    case 3: relayOffAll(); flashMode=false; break;
-    case 4: startRfLearn(); break;
-    case 5: adjustOcpLimit(); break;
-    case 6: adjustLvCutoff(); break;
-    case 7: adjustBrightness(); break;
+    case 0:  sendProt(PC_OFF_ALL); break;
+    case 1:  sendProt(PC_ENGAGE_SET, R_NONE, LIGHT_SET_MASK); break;
+    case 2:  adjustOcpLimit(); break;
+    case 3:  adjustLvCutoff(); break;
+    case 4:  adjustVerifyTtl(); break;
+    case 5:  startRfLearn(); break;
+    case 6:  adjustBrightness(); break;
+    case 7:  adjustFlash(); break;
+    case 8:  wifiScanAndConnectUI(); break;
+    case 9:  wifiForget(); break;
+    case 10: otaUpdateUI(); break;
+    case 11: diagnosticsUI(); break;
   }
+  if (MENU_PROBE[idx] != LP_NONE) latTimeSince(MENU_PROBE[idx], t0);
 }
 
 // ------------------- Telemetry (SrcV + LoadA) -------------------
@@ -939,12 +3193,31 @@ static void telemetryService(){
   if (millis()-last < 200) return; // 5 Hz
   last = millis();
 
-  float newV = INA226_SRC::busVoltageV();
-  float newI = INA226::currentA();
+  InaSample v = inaLatest();
+  float newV = v.srcV;
+  float newI = v.loadA;
   bool changed=false;
   if (fabs(newV - _lastShownSrcV) > 0.05f) { _lastShownSrcV = newV; changed=true; }
   if (fabs(newI - _lastShownLoadA) > 0.05f) { _lastShownLoadA = newI; changed=true; }
-  if (changed && !uiInMenu) drawStatusPage(true);
+  if (changed && !uiInMenu) drawStatusPage(false);
+}
+
+// ------------------- OCP service -------------------
+static void ocpService(){
+  // ALERT already low when a relay closed (e.g. within one conversion of the
+  // last trip) gives the ISR no edge: trip on the level instead
+  if (!ocpTripLatched && digitalRead(PIN_INA_ALERT) == LOW && currentActiveRelay() != R_NONE){
+    OcpFault f;
+    ocpDropAll(f);
+    xQueueSend(ocpFaultQ, &f, 0);
+  }
+  if (!ocpConsume(&ocpLastFault)) return;   // also stops the flasher
+  verifyInvalidateAll();
+  buzzerAlarm();
+  // Hard OCP trip = SHORT; no bypass here
+  if (!faultToUi.push(UiEvt{UE_FAULT, R_NONE, FAULT_OCP, ocpLastFault.latencyCyc, ocpLastFault.relayMask}))
+    uiFaultsLost = true;
+  notifyStatus();
 }
 
 // ------------------- LVP service -------------------
@@ -955,24 +3228,231 @@ static void lvpService(){
   if (millis()-last < 100) return; // ~10Hz
   last = millis();
 
-  SRC_V = INA226_SRC::busVoltageV();
+  SRC_V = inaLatest().srcV;
 
   // Hysteresis: trip below cutoff, release when above cutoff + hysteresis
   if (!lvpActive && SRC_V > 0 && SRC_V < LV_CUTOFF_V) {
     lvpActive = true;
-    flashMode = false;
+    flashStop();
     relayOffAll();
+    verifyInvalidateAll();
     buzzerAlarm(300);
   } else if (lvpActive && SRC_V >= (LV_CUTOFF_V + LV_RELEASE_HYST_V)) {
     lvpActive = false;
-    buzzerBeep(80);
+    buzzerPlay(BuzzPattern{BZ_NOTICE, 1, {80}});
+  }
+
+  // tell the UI task so it can redraw
+  static float lastV = -1.0f; static bool lastLvp = false;
+  if (fabs(SRC_V - lastV) > 0.05f || lastLvp != lvpActive) {
+    lastV   = SRC_V;
+    lastLvp = lvpActive;
+    notifyStatus();
+  }
+}
+
+// ------------------- Scan-all (protection side) -------------------
+static uint8_t scanPrevMask = 0;
+static bool    scanPrevFlash = false;
+static RelayId scanPrevFlashT = R_NONE;
+
+// Adaptive: each channel ends as soon as its inrush classifies, and results
+// stream to the UI as they land.
+static void scanAllService(){
+  // Preserve state (restored on PC_SCAN_RESTORE once the results screen closes)
+  scanPrevMask = 0;
+  for (int i=0;i<R_COUNT;i++) if (relayState[i]) scanPrevMask |= (1u << i);
+  scanPrevFlash = flashMode; scanPrevFlashT = flashTarget;
+  flashStop(); relayOffAll();
+
+  enum S{S_OK=0,S_OPEN,S_SHORT};
+  uint32_t t0 = micros();
+  for(int i=0;i<R_COUNT;i++){
+    // Abort if LVP during scan
+    lvpService();
+    if (lvpActive) break;
+
+    // Pulse until the waveform is conclusive
+    uint32_t tc = micros();
+    const InrushResult& r = inaInrushTest((RelayId)i);
+    bool ocp = INA226::overCurrent();
+    relayOff((RelayId)i);
+    if (ocp) (void)ocpConsume();
+    if (ocp) verifyCache[i].valid = false; else verifyStore((RelayId)i, r);
+
+    S res;
+    if (ocp || r.cls == INRUSH_SHORT) res=S_SHORT;
+    else if (r.cls != INRUSH_OK)      res=S_OPEN;
+    else                              res=S_OK;
+    postUi(UE_SCAN_RESULT, i, res, micros() - tc);
+    delay(SCAN_GAP_MS);
+  }
+  postUi(UE_SCAN_DONE, R_NONE, lvpActive ? 1 : 0, micros() - t0);
+}
+
+static void scanRestore(){
+  if (scanPrevMask && !lvpActive) engageSet(scanPrevMask);   // just scanned: cached, staggered
+  if (scanPrevFlash && !lvpActive) flashStart(scanPrevFlashT);
+  else flashTarget = scanPrevFlashT;
+  notifyStatus();
+}
+
+// ------------------- Protection command service -------------------
+static void protCmdService(){
+  ProtCmd c;
+  while (uiToProt.pop(c)){
+    switch (c.type){
+      case PC_FORCE_ON:   // ignored if everything was dropped since the fault
+        if (!lvpActive && c.epoch == relayEpoch){ relayOn((RelayId)c.relay); buzzerBeep(); }
+        break;
+      case PC_OFF_ALL:      flashStop(); relayOffAll(); break;
+      case PC_FLASH_CFG:    if (flashMode) flashStart(flashTarget); break;
+      case PC_ENGAGE_SET:   engageSet((uint8_t)c.value); break;
+      case PC_SET_OCP:      // the sampler owns the INA226s; it writes the registers
+        OCP_LIMIT_A = c.value;
+        xTaskNotify(inaTask, INA_NOTE_SET_OCP, eSetBits);
+        break;
+      case PC_SCAN_ALL:     scanAllService(); break;
+      case PC_SCAN_RESTORE: scanRestore(); break;
+    }
+    notifyStatus();
+  }
+}
+
+// ------------------- UI event service -------------------
+// Fault popups, one per queued fault. Over a modal screen the canvas is saved
+// and put back afterwards, since that screen may only redraw on changes.
+static void uiFaultService(){
+  static bool inPopup = false;   // the popup itself waits in uiDelay()
+  if (inPopup || (faultToUi.empty() && !uiFaultsLost)) return;
+  inPopup = true;
+  const size_t bytes = (size_t)TFT_W * TFT_H * sizeof(uint16_t);
+  uint16_t* saved = uiModal ? (uint16_t*)malloc(bytes) : nullptr;
+  if (saved) memcpy(saved, tft.getBuffer(), bytes);
+
+  UiEvt ev;
+  while (faultToUi.pop(ev)){
+    int64_t t0 = esp_timer_get_time();
+    bool force = showFaultChoicePopup(ev);
+    latTimeSince(LP_FAULT_POPUP, t0);
+    if (force) sendProt(PC_FORCE_ON, ev.relay, 0, ev.arg);
+  }
+  if (uiFaultsLost){
+    uiFaultsLost = false;
+    (void)showFaultChoicePopup(UiEvt{UE_FAULT, R_NONE, FAULT_MISSED, 0, 0});
+  }
+
+  if (saved){ memcpy(tft.getBuffer(), saved, bytes); tft.markAll(); free(saved); }
+  else if (uiInMenu) drawMenu();
+  else drawStatusPage(true);
+  inPopup = false;
+}
+
+static void uiEventService(){
+  uiFaultService();
+  if (uiStatusDirty){ uiStatusDirty = false; refreshStatusIfChanged(); }
+  UiEvt ev;
+  while (protToUi.pop(ev)) {}   // stray scan events after the scan screen closed
+}
+
+// ------------------- Tasks -------------------
+// Protection: OCP records, LVP, rotary, RF, flash, relay commands. Never touches the TFT.
+static void protectionTask(void*){
+  TickType_t wake = xTaskGetTickCount();
+  for (;;){
+    uint32_t c0 = ESP.getCycleCount();
+    // Hard OCP trip (relays already dropped by the ALERT ISR)
+    latTime(LP_OCP, ocpService);
+    // Low Voltage Protection service
+    latTime(LP_LVP, lvpService);
+    verifyWatchService();
+    protCmdService();
+    rotaryService();
+    latTime(LP_RF, rfService);
+    latTime(LP_FLASH, serviceFlashMode);
+    latRecord(LP_PROT_LOOP, latCycToUs(ESP.getCycleCount() - c0));
+    vTaskDelayUntil(&wake, pdMS_TO_TICKS(PROT_PERIOD_MS));
+  }
+}
+
+// UI: encoder, buttons, menus, popups and the Run page. Modal screens block only this task.
+static void uiTask(void*){
+  for (;;){
+    int64_t tLoop = esp_timer_get_time();   // a pass can hold a modal screen past a CCOUNT wrap
+    int8_t step = readEncoderStep();
+
+    if (uiInMenu) {
+      if (step){ menuIndex=wrapIndex(menuIndex, step, menuCount); drawMenu(); }
+      if (readOkPressed()){
+        uiModal = true; doMenuAction(menuIndex); uiModal = false;
+        drawMenu();
+      }
+      if (readKoPressed()){ exitMenuToStatus(); }  // Back exits menu
+    } else {
+      // On status page
+      // OK: released before ~800ms opens Menu, held past it runs Scan All.
+      // Decided from queued edges, so a tap during a slow redraw still counts.
+      static uint32_t okDownMs = 0; static bool okPending = false;
+      if (readOkPressed()){ okDownMs = millis(); okPending = true; }
+      if (okPending && !okIsDown()){ okPending = false; drawMenu(); }
+      else if (okPending && millis()-okDownMs > 800){
+        okPending = false;
+        int64_t t0 = esp_timer_get_time();
+        uiModal = true; scanAllRelays(); uiModal = false;
+        latTimeSince(LP_SCAN_ALL, t0);
+      }
+      if (readKoPressed()){ drawStatusPage(true); } // Back refresh (or wire E-stop here)
+    }
+
+    uiEventService();
+    // Telemetry for run page (SrcV + LoadA)
+    latTime(LP_TELEMETRY, telemetryService);
+    statusStatsTick();
+    latSerialService();
+    // Whole pass, modal screens included: a long one here is the UI stall
+    latTimeSince(LP_UI_LOOP, tLoop);
+
+    uiDelay(5);
   }
+}
 
-  // push to status page cache for redraw
-  if (fabs(SRC_V - _lastShownSrcV) > 0.05f || _lastShownLvp != lvpActive) {
-    _lastShownSrcV = SRC_V;
-    _lastShownLvp  = lvpActive;
-    refreshStatusIfChanged();
+// Network: Wi-Fi join, OTA and the WebServer. Lowest priority; may block for seconds.
+static void netTask(void*){
+  // Auto-connect Wi-Fi if saved
+  if (wifiConnectSaved(8000)) {
+    Serial.print("[NET] Wi-Fi connected ");
+    Serial.println(WiFi.localIP());
+  }
+  server.begin();
+
+  for (;;){
+    NetCmd c;
+    while (uiToNet.pop(c)){
+      switch (c.type){
+        case NC_CONNECT: {
+          WiFi.mode(WIFI_STA);
+          WiFi.begin(c.ssid, c.pass);
+          uint32_t t0 = millis();
+          while (WiFi.status()!=WL_CONNECTED && millis()-t0<20000) delay(200);
+          bool ok = WiFi.status()==WL_CONNECTED;
+          if (ok) {
+            prefs.putString(KEY_WIFI_SSID, c.ssid);
+            prefs.putString(KEY_WIFI_PASS, c.pass);
+          }
+          netToUi.push(NetEvt{NE_CONNECT_RESULT, ok ? 1 : 0});
+        } break;
+        case NC_FORGET:
+          WiFi.disconnect(true,true);
+          break;
+        case NC_OTA: {
+          esp_err_t r = runGithubOta();
+          netToUi.push(NetEvt{NE_OTA_RESULT, (int32_t)r});
+          if (r == ESP_OK){ delay(OTA_REBOOT_MS); ESP.restart(); }   // protection runs right up to here
+        } break;
+      }
+    }
+    server.handleClient();
+    delay(10);
   }
 }
 
@@ -980,92 +3460,62 @@ static void lvpService(){
 static void initPins(){
   pinMode(PIN_ENC_A,INPUT_PULLUP); pinMode(PIN_ENC_B,INPUT_PULLUP);
   pinMode(PIN_ENC_OK,INPUT_PULLUP); pinMode(PIN_ENC_KO,INPUT_PULLUP);
+  inputInit();
   pinMode(PIN_BUZZER,OUTPUT); digitalWrite(PIN_BUZZER,LOW);
+  buzzerInit();
+  flashInit();
 
   pinMode(PIN_SW_POS1,INPUT_PULLUP); pinMode(PIN_SW_POS2,INPUT_PULLUP);
   pinMode(PIN_SW_POS3,INPUT_PULLUP); pinMode(PIN_SW_POS4,INPUT_PULLUP);
   pinMode(PIN_SW_POS5,INPUT_PULLUP); pinMode(PIN_SW_POS6,INPUT_PULLUP);
   pinMode(PIN_SW_POS7,INPUT_PULLUP); pinMode(PIN_SW_POS8,INPUT_PULLUP);
+  rotaryInit();
 
   for(int i=0;i<R_COUNT;i++){ pinMode(RELAY_PIN[i],OUTPUT); digitalWrite(RELAY_PIN[i],LOW); }
 }
 
+#ifndef TLTB_BENCH   // the on-target bench (test/test_bench) brings its own setup()/loop()
 void setup(){
   Serial.begin(115200);
   prefs.begin(NVS_NS, false);
 
   spiTFT.begin(PIN_FSPI_SCK, PIN_FSPI_MISO, PIN_FSPI_MOSI, -1);
-  tft.initR(INITR_BLACKTAB); tft.setRotation(1);
+  tftPanel.initR(INITR_BLACKTAB); tftPanel.setRotation(1);
   pinMode(PIN_TFT_BL,OUTPUT); digitalWrite(PIN_TFT_BL,HIGH);
 
   initPins();
   INA226::begin();
   INA226_SRC::begin();
+  ocpInit();
   rfInit();
+  fbInit();
 
   // Restore saved OCP / LVP / brightness on boot
   float ocp = prefs.getFloat(KEY_OCP, OCP_LIMIT_A);
   INA226::setOcpLimit(ocp);
   LV_CUTOFF_V = prefs.getFloat(KEY_LV_CUTOFF, LV_CUTOFF_V);
+  VERIFY_TTL_MS = prefs.getULong(KEY_VERIFY_TTL, VERIFY_TTL_MS);
+  FLASH_STYLE     = (FlashStyle)min((int)prefs.getUChar(KEY_FLASH_STYLE, FLASH_STYLE), (int)FS_COUNT - 1);
+  FLASH_PERIOD_MS = prefs.getUShort(KEY_FLASH_PERIOD, FLASH_PERIOD_MS);
+  FLASH_DUTY_PCT  = prefs.getUChar(KEY_FLASH_DUTY, FLASH_DUTY_PCT);
+  rfCodesLoad();
   int bright = prefs.getInt(KEY_BRIGHT, 255);
   ledcAttachPin(PIN_TFT_BL, 0); ledcSetup(0, 5000, 8); ledcWrite(0, bright);
 
-  // Auto-connect Wi-Fi if saved
-  if (wifiConnectSaved(8000)) {
-    tft.fillScreen(ST77XX_BLACK); tft.setCursor(0,0);
-    tft.print("Wi-Fi connected\n");
-    tft.print(WiFi.localIP());
-    delay(700);
-  }
-
   // Start on Run Status page
-  _lastShownSrcV = INA226_SRC::busVoltageV();
-  _lastShownLoadA = INA226::currentA();
+  inaSampleOnce();
+  _lastShownSrcV = inaLatest().srcV;
+  _lastShownLoadA = inaLatest().loadA;
   drawStatusPage(true);
+
+  inaSamplerStart();
+  xTaskCreatePinnedToCore(protectionTask, "prot", 6144,  nullptr, PRIO_PROT, nullptr, CORE_PROT);
+  xTaskCreatePinnedToCore(uiTask,         "ui",   8192,  nullptr, PRIO_UI,   nullptr, CORE_UI);
+  xTaskCreatePinnedToCore(netTask,        "net",  12288, nullptr, PRIO_NET,  nullptr, CORE_NET);
 }
 
+// All work lives in the pinned tasks; the Arduino loop task has nothing to do.
 void loop(){
-  int8_t step = readEncoderStep();
-
-  if (uiInMenu) {
-    if (step){ menuIndex=(menuIndex+step+menuCount)%menuCount; drawMenu(); delay(120); }
-    if (readOkPressed()){ doMenuAction(menuIndex); drawMenu(); }
-    if (readKoPressed()){ exitMenuToStatus(); }  // Back exits menu
-  } else {
-    // On status page
-    // Long-press OK to run Scan All (hold > ~800ms)
-    static uint32_t okDownMs = 0; static bool scanning=false;
-    if (okIsDown()){
-      if (!okDownMs) okDownMs = millis();
-      if (!scanning && millis()-okDownMs > 800){ scanning=true; scanAllRelays(); }
-    } else { okDownMs = 0; scanning=false; }
-
-    // Short press still opens Menu
-    if (readOkPressed()){ drawMenu(); }
-    if (readKoPressed()){ drawStatusPage(true); } // Back refresh (or wire E-stop here)
-  }
-
-  static int lastPos=0; int pos=readRotaryPos();
-  if (pos && pos!=lastPos){ applyRotaryMode(pos); lastPos=pos; }
-
-  // Hard OCP trip
-  if (INA226::overCurrent()){
-    flashMode = false;
-    RelayId culprit = currentActiveRelay(); // best guess
-    (void)culprit;
-    relayOffAll();
-    buzzerAlarm();
-    // Hard OCP trip = SHORT; no bypass here
-    refreshStatusIfChanged();
-  }
-
-  // Low Voltage Protection service
-  lvpService();
-  // Telemetry for run page (SrcV + LoadA)
-  telemetryService();
-
-  rfService();
-  serviceFlashMode();
-
-  delay(5);
-}
\ No newline at end of file
+  vTaskDelete(nullptr);
+}
+#endif
@@ -0,0 +1,53 @@
+#include "ota_manifest.h"
+#include <string.h>
+
+// Value of "key": in json[0..n), with p left on its first character
+static const char* findValue(const char* json, size_t n, const char* key) {
+  size_t kl = strlen(key);
+  const char* end = json + n;
+  for (const char* p = json; p + kl + 2 <= end; p++) {
+    if (*p != '"' || memcmp(p + 1, key, kl) != 0 || p[kl + 1] != '"') continue;
+    const char* q = p + kl + 2;
+    while (q < end && (*q == ' ' || *q == '\t' || *q == '\r' || *q == '\n')) q++;
+    if (q >= end || *q != ':') continue;
+    for (q++; q < end && (*q == ' ' || *q == '\t' || *q == '\r' || *q == '\n'); q++) {}
+    return q < end ? q : nullptr;
+  }
+  return nullptr;
+}
+
+// Quoted string value into out (cap bytes with NUL); no escapes expected
+static bool readString(const char* p, const char* end, char* out, size_t cap) {
+  if (!p || *p != '"') return false;
+  size_t i = 0;
+  for (p++; p < end && *p != '"'; p++) {
+    if (*p == '\\' || i + 1 >= cap) return false;
+    out[i++] = *p;
+  }
+  out[i] = 0;
+  return p < end && i > 0;
+}
+
+bool otaManifestParse(const char* json, size_t n, OtaManifest& out) {
+  const char* end = json + n;
+  memset(&out, 0, sizeof(out));
+
+  if (!readString(findValue(json, n, "version"), end, out.version, sizeof(out.version))) return false;
+
+  const char* p = findValue(json, n, "size");
+  if (!p || *p < '0' || *p > '9') return false;
+  uint64_t size = 0;
+  for (; p < end && *p >= '0' && *p <= '9'; p++) {
+    size = size * 10 + (uint64_t)(*p - '0');
+    if (size > 0xFFFFFFFFu) return false;
+  }
+  out.size = (uint32_t)size;
+  if (!out.size) return false;
+
+  if (const char* h = findValue(json, n, "sha256")) {
+    char hex[2 * Sha256::DIGEST + 1];
+    if (!readString(h, end, hex, sizeof(hex)) || !Sha256::fromHex(hex, out.sha256)) return false;
+    out.hasSha = true;
+  }
+  return true;
+}
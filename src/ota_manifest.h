@@ -0,0 +1,22 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include "sha256.h"
+
+// ------- Release manifest (pure logic, no hardware access) -------
+// A few hundred bytes published next to firmware.bin so a check costs one
+// small GET instead of the whole image:
+//   {"version":"1.4.0","size":958464,"sha256":"<64 hex>"}
+// Only these keys are read; anything else in the object is skipped.
+
+struct OtaManifest {
+  static constexpr size_t VERSION_MAX = 32;
+  char     version[VERSION_MAX];
+  uint32_t size;
+  uint8_t  sha256[Sha256::DIGEST];
+  bool     hasSha;
+};
+
+// False unless "version" and "size" are present and well formed; a present
+// but malformed "sha256" also fails (a manifest we can't check is no use).
+bool otaManifestParse(const char* json, size_t n, OtaManifest& out);
@@ -0,0 +1,89 @@
+#include "rf_codes.h"
+
+void RfCodeTable::clear() {
+  for (uint8_t i = 0; i < SLOTS; i++) slot_[i] = Slot{0, -1, 0, 0};
+  for (uint8_t r = 0; r < MAX_RELAYS; r++) nextAge_[r] = 0;
+  count_ = 0;
+}
+
+int16_t RfCodeTable::indexOf(uint32_t code, uint8_t proto) const {
+  if (!code) return -1;
+  for (uint8_t i = home(code), n = 0; n < SLOTS; i = (i + 1) & (SLOTS - 1), n++) {
+    if (slot_[i].code == code && slot_[i].proto == proto) return i;
+    if (!slot_[i].code) return -1;
+  }
+  return -1;
+}
+
+// Backward-shift delete keeps probe chains intact without tombstones.
+void RfCodeTable::erase(int16_t idx) {
+  uint8_t hole = (uint8_t)idx;
+  slot_[hole] = Slot{0, -1, 0, 0};
+  count_--;
+  for (uint8_t i = (hole + 1) & (SLOTS - 1); slot_[i].code; i = (i + 1) & (SLOTS - 1)) {
+    uint8_t h = home(slot_[i].code);
+    // Move i into the hole unless its home lies cyclically in (hole, i]
+    bool stays = (hole <= i) ? (h > hole && h <= i) : (h > hole || h <= i);
+    if (stays) continue;
+    slot_[hole] = slot_[i];
+    slot_[i] = Slot{0, -1, 0, 0};
+    hole = i;
+  }
+}
+
+void RfCodeTable::add(uint32_t code, int8_t relay, uint8_t proto) {
+  if (!code || relay < 0 || relay >= MAX_RELAYS) return;
+  int16_t at = indexOf(code, proto);
+  if (at >= 0) erase(at);
+
+  // Full relay: drop its oldest code
+  uint8_t have = 0; int16_t oldest = -1;
+  for (uint8_t i = 0; i < SLOTS; i++) {
+    if (!slot_[i].code || slot_[i].relay != relay) continue;
+    have++;
+    if (oldest < 0 || (uint8_t)(slot_[i].age - slot_[oldest].age) > 127) oldest = i;
+  }
+  if (have >= MAX_PER_RELAY) erase(oldest);
+  if (count_ >= SLOTS / 2) return;
+
+  uint8_t i = home(code);
+  while (slot_[i].code) i = (i + 1) & (SLOTS - 1);
+  slot_[i] = Slot{code, relay, nextAge_[relay]++, proto};
+  count_++;
+}
+
+int8_t RfCodeTable::find(uint32_t code, uint8_t proto) const {
+  int16_t i = indexOf(code, proto);
+  return i < 0 ? -1 : slot_[i].relay;
+}
+
+int8_t RfCodeTable::match(uint32_t code, uint8_t proto, uint8_t tolBits) const {
+  int8_t r = find(code, proto);
+  if (r >= 0 || !tolBits || !code || !proto) return r;
+
+  uint8_t best = tolBits + 1; int8_t bestRelay = -1; bool tie = false;
+  for (uint8_t i = 0; i < SLOTS; i++) {
+    uint32_t c = slot_[i].code;
+    if (!c || slot_[i].proto != proto) continue;
+    uint8_t d = (uint8_t)__builtin_popcount(c ^ code);
+    if (d < best)                                     { best = d; bestRelay = slot_[i].relay; tie = false; }
+    else if (d == best && slot_[i].relay != bestRelay) tie = true;
+  }
+  return (best <= tolBits && !tie) ? bestRelay : -1;
+}
+
+uint8_t RfCodeTable::codesFor(int8_t relay, uint32_t* out, uint8_t* protos) const {
+  uint8_t n = 0; uint8_t age[MAX_PER_RELAY], proto[MAX_PER_RELAY];
+  for (uint8_t i = 0; i < SLOTS && n < MAX_PER_RELAY; i++) {
+    if (!slot_[i].code || slot_[i].relay != relay) continue;
+    // Insertion sort by age so NVS order (and eviction) survives a reload
+    uint8_t j = n++;
+    while (j && (uint8_t)(slot_[i].age - age[j - 1]) > 127) {
+      out[j] = out[j - 1]; age[j] = age[j - 1]; proto[j] = proto[j - 1];
+      j--;
+    }
+    out[j] = slot_[i].code; age[j] = slot_[i].age; proto[j] = slot_[i].proto;
+  }
+  if (protos) for (uint8_t j = 0; j < n; j++) protos[j] = proto[j];
+  return n;
+}
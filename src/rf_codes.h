@@ -0,0 +1,47 @@
+#pragma once
+#include <stdint.h>
+
+// ------- Learned RF code table (pure logic, no hardware access) -------
+// Open-addressed hash on the 32-bit code, loaded once from NVS, so a received
+// frame resolves to its relay without touching flash. Several fobs per relay.
+// Each code keeps the decoder protocol it arrived with (0 = a burst hash), so
+// codes of any width up to 32 bits stay comparable within their protocol.
+
+class RfCodeTable {
+public:
+  static constexpr uint8_t SLOTS         = 64;   // power of two, kept under half full
+  static constexpr uint8_t MAX_PER_RELAY = 4;
+  static constexpr uint8_t MAX_RELAYS    = 8;
+
+  RfCodeTable() { clear(); }
+
+  void clear();
+
+  // Bind code to relay. A code belongs to one relay; learning it again moves
+  // it. When the relay already has MAX_PER_RELAY codes the oldest is dropped.
+  void add(uint32_t code, int8_t relay, uint8_t proto = 0);
+
+  // Exact lookup, -1 if unknown. O(1) expected.
+  int8_t find(uint32_t code, uint8_t proto = 0) const;
+
+  // Exact first; otherwise the single closest code of the same protocol within
+  // tolBits differing bits. Hashes (proto 0) only match exactly. Ambiguous
+  // near-misses return -1.
+  int8_t match(uint32_t code, uint8_t proto, uint8_t tolBits) const;
+
+  // Codes bound to relay, oldest first, and their protocols if protos is
+  // given; returns how many were written.
+  uint8_t codesFor(int8_t relay, uint32_t* out, uint8_t* protos = nullptr) const;
+
+  uint8_t size() const { return count_; }
+
+private:
+  struct Slot { uint32_t code; int8_t relay; uint8_t age; uint8_t proto; };   // code 0 = empty
+  Slot    slot_[SLOTS];
+  uint8_t count_ = 0;
+  uint8_t nextAge_[MAX_RELAYS] = {};
+
+  static uint8_t home(uint32_t code) { return (uint8_t)((code * 2654435761u) >> 26); }  // top 6 bits
+  int16_t indexOf(uint32_t code, uint8_t proto) const;
+  void    erase(int16_t idx);
+};
@@ -0,0 +1,75 @@
+#include "rf_decode.h"
+#include <stdlib.h>
+
+// rc-switch protocols 1-5. The inverted ones (6+) start with a long high and
+// are left to the hash fallback.
+const RfProtocol RF_PROTOCOLS[] = {
+  {"PT2262/EV1527", 350, 1, 31, 1,  3, 3, 1},
+  {"rc-switch 2",   650, 1, 10, 1,  2, 2, 1},
+  {"rc-switch 3",   100, 30, 71, 4, 11, 9, 6},
+  {"rc-switch 4",   380, 1,  6, 1,  3, 3, 1},
+  {"rc-switch 5",   500, 6, 14, 1,  2, 2, 1},
+};
+const uint8_t RF_PROTOCOL_COUNT = sizeof(RF_PROTOCOLS) / sizeof(RF_PROTOCOLS[0]);
+
+static inline bool near(uint32_t us, uint32_t want, uint32_t tol) {
+  return (us > want ? us - want : want - us) <= tol;
+}
+
+bool RfDecoder::feed(uint16_t us, uint8_t level, RfFrame& out) {
+  if (level == 0 && us >= FRAME_GAP_US) return flush(out);
+  if (n_ < MAX_PULSES) { us_[n_] = us; lvl_[n_] = level; n_++; }
+  else overflow_ = true;
+  return false;
+}
+
+bool RfDecoder::flush(RfFrame& out) {
+  bool ok = n_ && !overflow_ && decode(out);
+  reset();
+  return ok;
+}
+
+// Expected layout: [hi lo] x bits, then the sync high whose low is the gap.
+// Every protocol in the table gives 0 and 1 the same total width, so the unit
+// comes from the whole frame rather than one noisy pulse.
+bool RfDecoder::decode(RfFrame& out) const {
+  uint16_t s = 0;
+  while (s < n_ && lvl_[s] == 0) s++;           // tail of a gap cut by the capture start
+  uint16_t m = n_ - s;
+  if (!(m & 1)) return false;
+  uint8_t bits = (uint8_t)((m - 1) / 2);
+  if (bits < MIN_BITS || bits > MAX_BITS) return false;
+
+  uint32_t sum = 0;
+  for (uint16_t i = s; i < n_ - 1; i++) sum += us_[i];
+  uint32_t syncHiUs = us_[n_ - 1];
+
+  bool found = false;
+  uint32_t bestErr = 0;
+  for (uint8_t p = 0; p < RF_PROTOCOL_COUNT; p++) {
+    const RfProtocol& pr = RF_PROTOCOLS[p];
+    uint32_t unit = sum / ((uint32_t)bits * (pr.zeroHi + pr.zeroLo));
+    if (unit < pr.pulseUs / 2 || unit > pr.pulseUs * 2u) continue;
+    uint32_t tol = unit * 6 / 10;                // rc-switch's 60 %
+    uint32_t syncWant = pr.syncHi * unit;
+    if (!near(syncHiUs, syncWant, syncWant * 3 / 10 > tol ? syncWant * 3 / 10 : tol)) continue;
+
+    uint32_t code = 0;
+    uint8_t  b = 0;
+    for (; b < bits; b++) {
+      uint32_t hi = us_[s + 2 * b], lo = us_[s + 2 * b + 1];
+      if (near(hi, pr.zeroHi * unit, tol) && near(lo, pr.zeroLo * unit, tol))     code <<= 1;
+      else if (near(hi, pr.oneHi * unit, tol) && near(lo, pr.oneLo * unit, tol)) code = (code << 1) | 1;
+      else break;
+    }
+    if (b != bits) continue;
+
+    // Shape-alike protocols (1 and 4) both fit; keep the one nearest its nominal unit
+    uint32_t err = (uint32_t)abs((int32_t)unit - (int32_t)pr.pulseUs) * 1000u / pr.pulseUs;
+    if (!found || err < bestErr) {
+      found = true; bestErr = err;
+      out = RfFrame{code, bits, (uint8_t)(p + 1), (uint16_t)unit};
+    }
+  }
+  return found;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <stdint.h>
+
+// ------- Fixed-code OOK decoder (pure logic, no hardware access) -------
+// Fed GDO0 pulse widths as they arrive. A frame is the data pulses between two
+// sync gaps; it is matched against the rc-switch timing table (PT2262 and
+// EV1527 remotes are protocol 1) as soon as its trailing gap starts, so the
+// first clean frame of a burst is enough.
+
+struct RfProtocol {
+  const char* name;
+  uint16_t pulseUs;          // nominal unit
+  uint8_t  syncHi, syncLo;   // widths in units
+  uint8_t  zeroHi, zeroLo;
+  uint8_t  oneHi,  oneLo;
+};
+
+struct RfFrame {
+  uint32_t code;
+  uint8_t  bits;
+  uint8_t  proto;            // 1-based index into RF_PROTOCOLS, same numbering as rc-switch
+  uint16_t unitUs;           // measured pulse unit
+};
+
+extern const RfProtocol RF_PROTOCOLS[];
+extern const uint8_t    RF_PROTOCOL_COUNT;
+
+class RfDecoder {
+public:
+  static constexpr uint16_t FRAME_GAP_US = 2000;   // low longer than any data pulse = sync
+  static constexpr uint8_t  MIN_BITS = 12, MAX_BITS = 32;
+
+  void reset() { n_ = 0; overflow_ = false; }
+
+  // One pulse: its width and the level GDO0 held during it. True (and *out
+  // filled) when this pulse is a sync gap and the pulses before it decode.
+  bool feed(uint16_t us, uint8_t level, RfFrame& out);
+
+  // Line has sat low for FRAME_GAP_US with no edge: decode what is pending.
+  bool flush(RfFrame& out);
+
+  bool pending() const { return n_ != 0; }
+
+private:
+  static constexpr uint16_t MAX_PULSES = 2 * MAX_BITS + 2;
+  uint16_t us_[MAX_PULSES];
+  uint8_t  lvl_[MAX_PULSES];
+  uint16_t n_ = 0;
+  bool     overflow_ = false;
+
+  bool decode(RfFrame& out) const;
+};
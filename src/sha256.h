@@ -0,0 +1,30 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// ------- SHA-256, streaming (pure logic, no hardware access) -------
+// Portable reference: the firmware hashes OTA images on the S3's SHA engine
+// (mbedTLS) and uses this for hex digests; host tests and tools hash with it.
+// begin() / update()* / finish().
+
+class Sha256 {
+public:
+  static constexpr size_t DIGEST = 32;
+
+  Sha256() { begin(); }
+
+  void begin();
+  void update(const uint8_t* p, size_t n);
+  void finish(uint8_t out[DIGEST]);
+
+  // 64 hex digits (either case) into 32 bytes; false on anything else
+  static bool fromHex(const char* hex, uint8_t out[DIGEST]);
+  static void toHex(const uint8_t d[DIGEST], char out[2 * DIGEST + 1]);
+
+private:
+  void block(const uint8_t* p);
+  uint32_t h_[8];
+  uint8_t  buf_[64];
+  uint64_t len_;
+  uint8_t  n_;
+};
@@ -0,0 +1,43 @@
+#pragma once
+#include <atomic>
+#include <stdint.h>
+
+// ------- Lock-free single-producer / single-consumer ring -------
+// One task (or ISR) pushes, one task pops; no mutex, no critical section.
+// N must be a power of two. Indices are free-running and wrap naturally.
+template <typename T, uint16_t N>
+class SpscQueue {
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+
+public:
+  // Producer side. Returns false (and drops v) if the ring is full.
+  // Forced inline so an IRAM ISR producer never calls into flash.
+  __attribute__((always_inline)) inline bool push(const T& v) {
+    uint16_t h = head_.load(std::memory_order_relaxed);
+    uint16_t t = tail_.load(std::memory_order_acquire);
+    if ((uint16_t)(h - t) >= N) return false;
+    buf_[h & (N - 1)] = v;
+    head_.store((uint16_t)(h + 1), std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side. Returns false if nothing is queued.
+  bool pop(T& out) {
+    uint16_t t = tail_.load(std::memory_order_relaxed);
+    uint16_t h = head_.load(std::memory_order_acquire);
+    if (h == t) return false;
+    out = buf_[t & (N - 1)];
+    tail_.store((uint16_t)(t + 1), std::memory_order_release);
+    return true;
+  }
+
+  uint16_t size() const {
+    return (uint16_t)(head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire));
+  }
+  bool empty() const { return size() == 0; }
+
+private:
+  T buf_[N];
+  std::atomic<uint16_t> head_{0};
+  std::atomic<uint16_t> tail_{0};
+};
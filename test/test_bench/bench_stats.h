@@ -0,0 +1,66 @@
+#pragma once
+#include <Arduino.h>
+#include <algorithm>
+
+// ------- Benchmark sample sets and the JSON report -------
+// Host: CPU paths are timed with the monotonic clock (the simulator's cycle
+// counter is virtual and would read 0 for pure computation); end-to-end paths
+// are timed in simulator microseconds. Target: ESP.getCycleCount().
+#ifdef TLTB_NATIVE
+#include <time.h>
+static inline uint32_t benchTicks(){
+  timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec);
+}
+static inline uint32_t benchTicksToNs(uint32_t t){ return t; }
+static const char* const BENCH_TARGET = "native";
+#else
+static inline uint32_t benchTicks(){ return ESP.getCycleCount(); }
+static inline uint32_t benchTicksToNs(uint32_t t){ return (uint32_t)((uint64_t)t * 1000u / getCpuFrequencyMhz()); }
+static const char* const BENCH_TARGET = "esp32s3";
+#endif
+
+struct BenchSeries {
+  const char* name;
+  const char* clock;    // "cpu" (ns) or "sim" (virtual us)
+  const char* unit;
+  uint32_t    n, median, p99, worst;
+};
+
+class BenchSamples {
+public:
+  static constexpr uint16_t MAX = 512;
+
+  void clear(){ n_ = 0; }
+  void add(uint32_t v){ if (n_ < MAX) v_[n_++] = v; }
+  uint16_t size() const { return n_; }
+
+  // Sorts in place; nearest-rank percentiles
+  BenchSeries summarize(const char* name, const char* clock, const char* unit){
+    BenchSeries s{name, clock, unit, n_, 0, 0, 0};
+    if (!n_) return s;
+    std::sort(v_, v_ + n_);
+    s.median = v_[(n_ - 1) / 2];
+    s.p99    = v_[(uint16_t)((99u * n_ + 99) / 100) - 1];
+    s.worst  = v_[n_ - 1];
+    return s;
+  }
+
+private:
+  uint32_t v_[MAX];
+  uint16_t n_ = 0;
+};
+
+// One JSON object on one line, so a serial log can be grepped for it
+static size_t benchJson(char* out, size_t cap, const BenchSeries* s, uint8_t n){
+  size_t len = (size_t)snprintf(out, cap, "{\"target\":\"%s\",\"cpu_mhz\":%lu,\"results\":[",
+                                BENCH_TARGET, (unsigned long)getCpuFrequencyMhz());
+  for (uint8_t i=0;i<n && len<cap;i++){
+    len += (size_t)snprintf(out+len, cap-len,
+                            "%s{\"name\":\"%s\",\"clock\":\"%s\",\"unit\":\"%s\",\"n\":%lu,\"median\":%lu,\"p99\":%lu,\"worst\":%lu}",
+                            i ? "," : "", s[i].name, s[i].clock, s[i].unit, (unsigned long)s[i].n,
+                            (unsigned long)s[i].median, (unsigned long)s[i].p99, (unsigned long)s[i].worst);
+  }
+  if (len < cap) len += (size_t)snprintf(out+len, cap-len, "]}");
+  return len < cap ? len : cap - 1;
+}
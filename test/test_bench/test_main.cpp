@@ -0,0 +1,291 @@
+// Hot-path benchmarks: RF hash/decode, inrush classification, Run page draw,
+// staggered engage and the OCP trip. Prints one "BENCH_JSON {...}" line with median/p99/worst
+// per series; the host run also writes it to $TLTB_BENCH_OUT (default
+// bench-native.json).
+//
+//   host:   pio test -e native -f test_bench
+//   target: pio test -e esp32s3-bench -v | python tools/bench_extract.py bench-esp32s3.json
+#include <unity.h>
+#ifdef TLTB_NATIVE
+#include <sim.h>
+#endif
+#include "../../src/main.cpp"   // static functions and state live in the one TU
+#include "bench_stats.h"
+
+static BenchSeries  results[16];
+static uint8_t      nResults = 0;
+static BenchSamples samples;
+static volatile uint32_t benchSink = 0;
+
+static void record(const char* name, const char* clock, const char* unit){
+  if (nResults >= sizeof(results)/sizeof(results[0])) return;
+  BenchSeries s = samples.summarize(name, clock, unit);
+  results[nResults++] = s;
+#ifdef TLTB_NATIVE
+  sim::setQuiet(false);   // firmware logs stay muted, results don't
+#endif
+  Serial.printf("[BENCH] %-18s n=%-4lu median %-7lu p99 %-7lu worst %-7lu %s\n", s.name, (unsigned long)s.n,
+                (unsigned long)s.median, (unsigned long)s.p99, (unsigned long)s.worst, s.unit);
+#ifdef TLTB_NATIVE
+  sim::setQuiet(true);
+#endif
+}
+
+template <typename F>
+static void timeCpu(uint16_t n, F&& body){
+  samples.clear();
+  for (uint16_t i=0;i<n;i++){
+    uint32_t t0 = benchTicks();
+    body();
+    samples.add(benchTicksToNs(benchTicks() - t0));
+  }
+}
+
+// PT2262/EV1527 frames, as GDO0 pulses: [bits][sync] x repeats
+static uint16_t pt2262Pulses(uint16_t* us, uint8_t* lvl, uint16_t cap, uint32_t code, uint8_t bits,
+                             uint16_t unit, uint8_t repeats){
+  uint16_t n = 0;
+  auto put = [&](uint16_t w, uint8_t l){ if (n < cap){ us[n] = w; lvl[n] = l; n++; } };
+  for (uint8_t r=0;r<repeats;r++){
+    for (int b=bits-1;b>=0;b--){
+      bool one = (code >> b) & 1;
+      put(unit * (one ? 3 : 1), 1);
+      put(unit * (one ? 1 : 3), 0);
+    }
+    put(unit, 1);
+    put(unit * 31, 0);
+  }
+  return n;
+}
+
+static const uint32_t RF_CODE = 0xA5C3E1;
+
+static void bench_rf_hash(){
+  static RfBurst b;
+  b.n = pt2262Pulses(b.us, b.level, RF_BURST_MAX, RF_CODE, 24, 350, 4);
+  timeCpu(500, [&]{ benchSink = rfHashBurst(b); });
+  TEST_ASSERT_TRUE(benchSink != 0);
+  record("rf_hash", "cpu", "ns");
+}
+
+static void bench_rf_decode(){
+  uint16_t us[64]; uint8_t lvl[64];
+  uint16_t n = pt2262Pulses(us, lvl, 64, RF_CODE, 24, 350, 1);
+  RfDecoder dec;
+  RfFrame f{};
+  bool got = false;
+  timeCpu(500, [&]{
+    dec.reset();
+    got = false;
+    for (uint16_t i=0;i<n;i++) got |= dec.feed(us[i], lvl[i], f);
+  });
+  TEST_ASSERT_TRUE(got);
+  TEST_ASSERT_EQUAL(RF_CODE, f.code);
+  record("rf_decode_frame", "cpu", "ns");
+}
+
+// Classifier cost for a whole verdict, fed the way inaRunCapture() samples
+static void benchInrush(const char* name, float steadyA, float peakA, uint32_t tauUs, InrushClass want){
+  InrushClassifier c(INRUSH_CFG);
+  timeCpu(200, [&]{
+    c.reset(0);
+    for (uint32_t t=150; !c.decided(); t+=150)
+      c.feed(t, steadyA + (peakA - steadyA) * expf(-(float)t / tauUs));
+  });
+  TEST_ASSERT_EQUAL(want, c.result().cls);
+  record(name, "cpu", "ns");
+}
+static void bench_inrush_lamp(){ benchInrush("inrush_lamp", 2.0f, 12.0f, 4000, INRUSH_OK); }
+static void bench_inrush_open(){ benchInrush("inrush_open", 0.0f, 0.0f, 1, INRUSH_OPEN); }
+
+static void bench_draw_status_full(){
+  timeCpu(100, []{ drawStatusPage(true); });
+  record("draw_status_full", "cpu", "ns");
+}
+
+static void bench_draw_status_delta(){
+  drawStatusPage(true);
+  uint16_t i = 0;
+  timeCpu(200, [&]{ _lastShownLoadA = (i++ & 1) ? 1.23f : 4.56f; drawStatusPage(false); });
+  record("draw_status_delta", "cpu", "ns");
+}
+
+// ALERT ISR body with every relay already off (nothing to switch on the bench)
+static void bench_ocp_isr(){
+  static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+  relayOffAll();
+  BenchSamples clearNs;
+  timeCpu(200, [&]{
+    portENTER_CRITICAL(&mux);
+    ocpAlertIsr();
+    portEXIT_CRITICAL(&mux);
+    OcpFault f;
+    if (ocpConsume(&f)) clearNs.add(benchTicksToNs(f.latencyCyc));
+  });
+  record("ocp_isr", "cpu", "ns");
+  TEST_ASSERT_EQUAL(200, clearNs.size());
+#ifndef TLTB_NATIVE
+  // ISR entry to relay outputs cleared, from the ISR's own cycle stamps
+  // (the host cycle counter is virtual, so this one is target-only)
+  samples = clearNs;
+  record("ocp_isr_to_clear", "cpu", "ns");
+#endif
+}
+
+#ifdef TLTB_NATIVE
+// ------------------- Simulator (virtual time) -------------------
+static const sim::Load LAMP  = {sim::LOAD_LAMP, 2.0f, 12.0f, 4000};
+static const sim::Load OPEN  = {sim::LOAD_OPEN, 0, 0, 0};
+static const sim::Load SHORT = {sim::LOAD_SHORT, 60.0f, 0, 0};
+
+static void benchPulse(const char* name, const sim::Load& load){
+  sim::setLoad(PIN_RLY_LEFT, load);
+  samples.clear();
+  for (int i=0;i<20;i++){
+    relayOffAll();
+    verifyInvalidateAll();
+    delay(3 + i);                      // walk the phase against the load conversions
+    uint64_t t0 = sim::nowUs();
+    pulseTestAndEngage(R_LEFT);
+    samples.add((uint32_t)(sim::nowUs() - t0));
+    (void)ocpConsume();
+    UiEvt e; while (faultToUi.pop(e)) {}
+  }
+  relayOffAll();
+  sim::setLoad(PIN_RLY_LEFT, LAMP);
+  record(name, "sim", "us");
+}
+static void bench_pulse_lamp(){  benchPulse("pulse_lamp", LAMP); }
+static void bench_pulse_open(){  benchPulse("pulse_open", OPEN); }
+static void bench_pulse_short(){ benchPulse("pulse_short", SHORT); }
+
+// Load shorts while engaged: fault to ALERT ISR entry (sensor path)
+static void bench_ocp_trip(){
+  samples.clear();
+  for (int i=0;i<20;i++){
+    sim::setLoad(PIN_RLY_MARKER, LAMP);
+    relayOn(R_MARKER);
+    delay(40 + (i * 7) % 37);
+    sim::setLoad(PIN_RLY_MARKER, SHORT);
+    uint32_t tFault = (uint32_t)sim::nowUs();
+    while (sim::pinOut(PIN_RLY_MARKER)) delay(1);
+    OcpFault f;
+    TEST_ASSERT_EQUAL(1, ocpConsume(&f));
+    samples.add(f.tAlertUs - tFault);
+  }
+  sim::setLoad(PIN_RLY_MARKER, LAMP);
+  verifyInvalidateAll();
+  record("ocp_trip", "sim", "us");
+  TEST_ASSERT_LESS_THAN(2 * INA226::conversionUs(), results[nResults-1].worst);
+}
+
+// TAIL+MARKER+BRAKE from off, staggered under the inrush budget (cached after the first)
+static void bench_engage_light_set(){
+  const uint8_t LIGHTS = (1u << R_TAIL) | (1u << R_MARKER) | (1u << R_BRAKE);
+  samples.clear();
+  for (int i=0;i<10;i++){
+    relayOffAll();
+    delay(20 + 7 * i);
+    uint64_t t0 = sim::nowUs();
+    TEST_ASSERT_EQUAL(LIGHTS, engageSet(LIGHTS));
+    samples.add((uint32_t)(sim::nowUs() - t0));
+    TEST_ASSERT_EQUAL(0, ocpConsume());
+    UiEvt e; while (faultToUi.pop(e)) {}
+  }
+  relayOffAll();
+  record("engage_light_set", "sim", "us");
+}
+
+// Last GDO0 edge of the first good frame to the action (2 ms protection period)
+static void bench_rf_latency(){
+  RfFrame f{RF_CODE, 24, 1, 350};
+  rfCodes.clear();
+  rfCodes.add(f.code, R_LEFT, f.proto);
+  rfEnabled = true;
+  samples.clear();
+  for (int i=0;i<10;i++){
+    relayOffAll();
+    sim::rfSendPt2262(PIN_CC1101_GDO0, RF_CODE, 24, 350, 4, 500 + 137 * i);
+    for (int k=0;k<300 && !relayState[R_LEFT];k++){ rfService(); delay(PROT_PERIOD_MS); }
+    TEST_ASSERT_TRUE(relayState[R_LEFT]);
+    samples.add(rfLatLastUs);
+    // Keep polling like the protection task so the repeats fold into this press;
+    // the next press then lands outside DOUBLE_PRESS_MS
+    for (uint32_t t0=millis(); millis()-t0 < DOUBLE_PRESS_MS + 100; ){ rfService(); delay(PROT_PERIOD_MS); }
+  }
+  rfEnabled = false;
+  relayOffAll();
+  record("rf_latency", "sim", "us");
+}
+#endif
+
+static void benchInit(){
+#ifdef TLTB_NATIVE
+  sim::setQuiet(true);
+  sim::addIna226(0x40, SHUNT_OHMS, PIN_INA_ALERT, sim::INA_LOAD);
+  sim::addIna226(0x41, SHUNT_OHMS, PIN_INA2_ALERT, sim::INA_SOURCE);
+  for (int i=0;i<R_COUNT;i++) sim::setLoad(RELAY_PIN[i], LAMP);
+  initPins();
+  INA226::begin();
+  INA226_SRC::begin();
+  ocpInit();
+  rfInit();
+  inaSampleOnce();
+  inaSamplerStart();
+  delay(50);
+#else
+  initPins();
+  pinMode(PIN_INA_ALERT, INPUT_PULLUP);
+  ocpInit();
+#endif
+}
+
+static void benchReport(){
+  static char json[3072];
+  benchJson(json, sizeof(json), results, nResults);
+#ifdef TLTB_NATIVE
+  sim::setQuiet(false);
+  const char* path = getenv("TLTB_BENCH_OUT");
+  if (!path) path = "bench-native.json";
+  if (FILE* fp = fopen(path, "w")){ fprintf(fp, "%s\n", json); fclose(fp); }
+#endif
+  Serial.printf("BENCH_JSON %s\n", json);
+}
+
+static int benchAll(){
+  benchInit();
+  UNITY_BEGIN();
+  RUN_TEST(bench_rf_hash);
+  RUN_TEST(bench_rf_decode);
+  RUN_TEST(bench_inrush_lamp);
+  RUN_TEST(bench_inrush_open);
+  RUN_TEST(bench_draw_status_full);
+  RUN_TEST(bench_draw_status_delta);
+  RUN_TEST(bench_ocp_isr);
+#ifdef TLTB_NATIVE
+  RUN_TEST(bench_pulse_lamp);
+  RUN_TEST(bench_pulse_open);
+  RUN_TEST(bench_pulse_short);
+  RUN_TEST(bench_ocp_trip);
+  RUN_TEST(bench_engage_light_set);
+  RUN_TEST(bench_rf_latency);
+#endif
+  benchReport();
+  return UNITY_END();
+}
+
+void setUp(){}
+void tearDown(){}
+
+#ifdef TLTB_NATIVE
+int main(int, char**){
+  return benchAll();
+}
+#else
+void setup(){
+  Serial.begin(115200);
+  delay(2000);   // let the test runner attach to the port
+  benchAll();
+}
+void loop(){}
+#endif
@@ -0,0 +1,871 @@
+// Firmware logic on the host simulator: the real pulse test, OCP ISR, LVP and
+// RF paths against modelled INA226s, loads and CC1101 edges in virtual time.
+#include <unity.h>
+#include <sim.h>
+#include <zlib.h>               // host zlib packs the gzip test assets like tools/ota_pack.py
+#include "../../src/main.cpp"   // static functions and state live in the one TU
+
+static const sim::Load LAMP  = {sim::LOAD_LAMP, 2.0f, 12.0f, 4000};   // ~24 W bulb
+static const sim::Load OPEN  = {sim::LOAD_OPEN, 0, 0, 0};
+static const sim::Load SHORT = {sim::LOAD_SHORT, 60.0f, 0, 0};
+
+static void bootOnce(){
+  static bool booted = false;
+  if (booted) return;
+  booted = true;
+  sim::setQuiet(true);
+  sim::addIna226(0x40, SHUNT_OHMS, PIN_INA_ALERT, sim::INA_LOAD);
+  sim::addIna226(0x41, SHUNT_OHMS, PIN_INA2_ALERT, sim::INA_SOURCE);
+  prefs.begin(NVS_NS, false);
+  initPins();
+  INA226::begin();
+  INA226_SRC::begin();
+  ocpInit();
+  rfInit();
+  fbInit();
+  inaSampleOnce();
+  inaSamplerStart();
+}
+
+static void drainUi(){ UiEvt e; while (protToUi.pop(e)) {} while (faultToUi.pop(e)) {} }
+
+static bool nextFault(UiEvt& out){ return faultToUi.pop(out); }
+
+void setUp(){
+  bootOnce();
+  sim::clearLoads();
+  for (int i=0;i<R_COUNT;i++) sim::setLoad(RELAY_PIN[i], LAMP);
+  sim::setSupply(18.0f);
+  relayOffAll();
+  verifyInvalidateAll();
+  flashStop();
+  delay(50);            // sampler settles on the new plant
+  (void)ocpConsume();
+  lvpActive = false;
+  rfEnabled = false;
+  otaCancel = false;
+  drainUi();
+}
+
+void tearDown(){ relayOffAll(); }
+
+// Two queued beeps stay two: the second waits out a short silence
+static void test_buzzer_queued_beeps_stay_separate(){
+  if (!buzzTimer) buzzerInit();
+  while (buzzBusy) delay(10);
+  buzzerBeep(60); buzzerBeep(60);
+  delay(30);  TEST_ASSERT_TRUE(sim::pinOut(PIN_BUZZER));
+  delay(50);  TEST_ASSERT_FALSE(sim::pinOut(PIN_BUZZER));   // 80 ms: the gap
+  delay(40);  TEST_ASSERT_TRUE(sim::pinOut(PIN_BUZZER));    // 120 ms: second beep
+  delay(100); TEST_ASSERT_FALSE(sim::pinOut(PIN_BUZZER));
+}
+
+static void test_pulse_lamp_engages(){
+  TEST_ASSERT_TRUE(pulseTestAndEngage(R_LEFT));
+  TEST_ASSERT_TRUE(relayState[R_LEFT]);
+  TEST_ASSERT_TRUE(sim::pinOut(PIN_RLY_LEFT));
+  const InrushResult& r = inrush.result();
+  TEST_ASSERT_EQUAL(INRUSH_OK, r.cls);
+  TEST_ASSERT_GREATER_THAN(OPEN_THRESH_A, r.steadyA);
+  // A lamp leaves no doubt once the window is in the OK band: well short of PULSE_MS
+  TEST_ASSERT_LESS_THAN(INRUSH_CFG.minUs + 2000u, r.elapsedUs);
+}
+
+// Each classifier sample is its own conversion, never a re-read of the last
+static void test_pulse_samples_are_distinct_conversions(){
+  sim::setLoad(PIN_RLY_RIGHT, OPEN);
+  TEST_ASSERT_FALSE(pulseTestAndEngage(R_RIGHT));
+  uint16_t n = inrush.kept();
+  TEST_ASSERT_GREATER_THAN(INRUSH_CFG.settleN, n);
+  uint32_t conv = inaConversionUs(INA_PROFILE_INRUSH);
+  uint32_t prev, t; float a;
+  inrush.sampleAt(0, prev, a);
+  for (uint16_t i=1;i<n;i++){
+    inrush.sampleAt(i, t, a);
+    TEST_ASSERT_GREATER_OR_EQUAL(conv, t - prev);
+    prev = t;
+  }
+}
+
+static void test_pulse_open_faults(){
+  sim::setLoad(PIN_RLY_RIGHT, OPEN);
+  TEST_ASSERT_FALSE(pulseTestAndEngage(R_RIGHT));
+  TEST_ASSERT_FALSE(sim::pinOut(PIN_RLY_RIGHT));
+  UiEvt e;
+  TEST_ASSERT_TRUE(nextFault(e));
+  TEST_ASSERT_EQUAL(FAULT_OPEN, e.code);
+  TEST_ASSERT_EQUAL(R_RIGHT, e.relay);
+}
+
+static void test_pulse_short_faults(){
+  sim::setLoad(PIN_RLY_BRAKE, SHORT);
+  uint64_t t0 = sim::nowUs();
+  TEST_ASSERT_FALSE(pulseTestAndEngage(R_BRAKE));
+  TEST_ASSERT_FALSE(sim::pinOut(PIN_RLY_BRAKE));
+  TEST_ASSERT_LESS_THAN(20000u, (uint32_t)(sim::nowUs() - t0));
+  UiEvt e;
+  TEST_ASSERT_TRUE(nextFault(e));
+  TEST_ASSERT_EQUAL(FAULT_SHORT, e.code);
+}
+
+static void test_cached_engage_skips_pulse(){
+  TEST_ASSERT_TRUE(pulseTestAndEngage(R_TAIL));
+  relayOff(R_TAIL);
+  uint64_t t0 = sim::nowUs();
+  TEST_ASSERT_TRUE(pulseTestAndEngage(R_TAIL));
+  TEST_ASSERT_LESS_THAN(1000u, (uint32_t)(sim::nowUs() - t0));
+  TEST_ASSERT_TRUE(sim::pinOut(PIN_RLY_TAIL));
+}
+
+// With another channel already lit the bus total clears OPEN_THRESH_A on its
+// own; a cached engage onto a load gone open must still be caught
+static void test_cached_engage_open_beside_lit_channel(){
+  TEST_ASSERT_TRUE(pulseTestAndEngage(R_TAIL));
+  relayOff(R_TAIL);
+  sim::setLoad(PIN_RLY_TAIL, OPEN);
+  relayOn(R_MARKER);
+  delay(50);
+  drainUi();
+  TEST_ASSERT_TRUE(pulseTestAndEngage(R_TAIL));   // cached: no pulse
+  for (int i=0;i<50 && verifyWatchRelay != R_NONE;i++){ delay(PROT_PERIOD_MS); verifyWatchService(); }
+  TEST_ASSERT_FALSE(sim::pinOut(PIN_RLY_TAIL));
+  TEST_ASSERT_TRUE(sim::pinOut(PIN_RLY_MARKER));
+  UiEvt e;
+  TEST_ASSERT_TRUE(nextFault(e));
+  TEST_ASSERT_EQUAL(FAULT_OPEN, e.code);
+  TEST_ASSERT_EQUAL(R_TAIL, e.relay);
+}
+
+// Status churn while a modal screen isn't draining must not crowd out a
+// fault, and its "OK = Enable" is void once everything has been dropped
+static void test_fault_survives_status_churn(){
+  for (int i=0;i<100;i++) notifyStatus();   // flash edges, LVP readings
+  sim::setLoad(PIN_RLY_AUX, OPEN);
+  TEST_ASSERT_FALSE(pulseTestAndEngage(R_AUX));
+  UiEvt e;
+  TEST_ASSERT_TRUE(nextFault(e));
+  TEST_ASSERT_EQUAL(FAULT_OPEN, e.code);
+  TEST_ASSERT_EQUAL(R_AUX, e.relay);
+
+  relayOffAll();   // the operator moved on before answering
+  sendProt(PC_FORCE_ON, R_AUX, 0, e.arg);
+  protCmdService();
+  TEST_ASSERT_FALSE(relayState[R_AUX]);
+  sendProt(PC_FORCE_ON, R_AUX, 0, relayEpoch);
+  protCmdService();
+  TEST_ASSERT_TRUE(relayState[R_AUX]);
+}
+
+static void test_ocp_isr_drops_relays(){
+  relayOn(R_MARKER);
+  delay(100);
+  TEST_ASSERT_TRUE(sim::pinOut(PIN_RLY_MARKER));
+  sim::setLoad(PIN_RLY_MARKER, SHORT);   // load fails while engaged
+  uint64_t t0 = sim::nowUs();
+  while (sim::pinOut(PIN_RLY_MARKER) && sim::nowUs() - t0 < 100000) delay(1);
+  TEST_ASSERT_FALSE(sim::pinOut(PIN_RLY_MARKER));
+  // One load conversion (AVG16 x 2 x 1.1 ms) bounds the trip
+  TEST_ASSERT_LESS_THAN(40000u, (uint32_t)(sim::nowUs() - t0));
+  OcpFault f;
+  TEST_ASSERT_EQUAL(1, ocpConsume(&f));
+  TEST_ASSERT_TRUE(f.relayMask & (1u << R_MARKER));
+  TEST_ASSERT_FALSE(relayState[R_MARKER]);
+}
+
+// Re-energized while ALERT is still low from the last trip: no edge comes,
+// so ocpService() trips on the level and tells the UI
+static void test_ocp_level_trips_without_edge(){
+  relayOn(R_MARKER);
+  sim::setLoad(PIN_RLY_MARKER, SHORT);
+  uint64_t t0 = sim::nowUs();
+  while (sim::pinOut(PIN_RLY_MARKER) && sim::nowUs() - t0 < 100000) delay(1);
+  TEST_ASSERT_EQUAL(1, ocpConsume());
+  TEST_ASSERT_EQUAL(LOW, digitalRead(PIN_INA_ALERT));
+  drainUi();
+
+  relayOn(R_MARKER);   // inside the same conversion
+  ocpService();
+  TEST_ASSERT_FALSE(sim::pinOut(PIN_RLY_MARKER));
+  TEST_ASSERT_FALSE(relayState[R_MARKER]);
+  UiEvt e;
+  TEST_ASSERT_TRUE(nextFault(e));
+  TEST_ASSERT_EQUAL(FAULT_OCP, e.code);
+  TEST_ASSERT_TRUE(e.mask & (1u << R_MARKER));
+  sim::setLoad(PIN_RLY_MARKER, LAMP);
+  delay(50);   // ALERT clears on the next conversion
+}
+
+// A new limit from the menu reaches the ALERT register through the sampler
+static void test_ocp_limit_set_by_sampler(){
+  float was = OCP_LIMIT_A;
+  sendProt(PC_SET_OCP, R_NONE, 10.0f);
+  protCmdService();
+  delay(5);
+  TEST_ASSERT_EQUAL((uint16_t)roundf(10.0f * SHUNT_OHMS / 0.0000025f), INA226::rd16(INA_REG_ALERT_LIMIT));
+  sendProt(PC_SET_OCP, R_NONE, was);
+  protCmdService();
+  delay(5);
+  TEST_ASSERT_EQUAL((uint16_t)roundf(was * SHUNT_OHMS / 0.0000025f), INA226::rd16(INA_REG_ALERT_LIMIT));
+}
+
+static void test_lvp_trips_and_releases(){
+  relayOn(R_AUX);
+  sim::setSupply(LV_CUTOFF_V - 0.5f);
+  for (int i=0;i<5 && !lvpActive;i++){ delay(110); lvpService(); }
+  TEST_ASSERT_TRUE(lvpActive);
+  TEST_ASSERT_FALSE(sim::pinOut(PIN_RLY_AUX));
+  TEST_ASSERT_FALSE(pulseTestAndEngage(R_AUX));
+
+  // Inside the hysteresis band: still latched
+  sim::setSupply(LV_CUTOFF_V + LV_RELEASE_HYST_V * 0.5f);
+  for (int i=0;i<5;i++){ delay(110); lvpService(); }
+  TEST_ASSERT_TRUE(lvpActive);
+
+  sim::setSupply(LV_CUTOFF_V + LV_RELEASE_HYST_V + 0.5f);
+  for (int i=0;i<5 && lvpActive;i++){ delay(110); lvpService(); }
+  TEST_ASSERT_FALSE(lvpActive);
+}
+
+// A full frame goes out by DMA: the flusher sleeps through the wire time and
+// a background task on the UI core gets nearly all of it
+static volatile bool     spinOn = false;
+static volatile uint32_t spinUs = 0;
+static void spinTask(void*){
+  while (spinOn){ sim::spend(10); spinUs = spinUs + 10; }
+  vTaskDelete(nullptr);
+}
+
+static void test_fb_flush_leaves_core_free(){
+  tft.fillScreen(ST77XX_BLUE);
+  spinOn = true; spinUs = 0;
+  xTaskCreatePinnedToCore(spinTask, "spin", 2048, nullptr, 0, nullptr, CORE_UI);
+  uint64_t t0 = sim::nowUs();
+  tftPresent(true);
+  uint32_t frameUs = (uint32_t)(sim::nowUs() - t0);
+  spinOn = false;
+  delay(1);
+  TEST_ASSERT_GREATER_OR_EQUAL((uint32_t)TFT_W * TFT_H * 16 / (FB_SPI_HZ / 1000000), frameUs);
+  TEST_ASSERT_GREATER_THAN(frameUs * 3 / 4, spinUs);
+}
+
+static void test_rf_frame_engages_learned_relay(){
+  const uint32_t code = 0xA5C3E1;   // EV1527: 20-bit id + 4 button bits
+  RfFrame f = {code, 24, 1, 350};
+  rfCodes.clear();
+  rfCodes.add(f.code, R_LEFT, f.proto);
+  rfEnabled = true;
+  uint32_t framesBefore = rfFrames;
+
+  sim::rfSendPt2262(PIN_CC1101_GDO0, code, 24, 350, 4, 1000);
+  for (int i=0;i<200 && !relayState[R_LEFT];i++){ rfService(); delay(PROT_PERIOD_MS); }
+  TEST_ASSERT_TRUE(relayState[R_LEFT]);
+  TEST_ASSERT_TRUE(sim::pinOut(PIN_RLY_LEFT));
+
+  // The remaining repeats are the same press, not a second toggle
+  for (int i=0;i<100;i++){ rfService(); delay(PROT_PERIOD_MS); }
+  TEST_ASSERT_TRUE(relayState[R_LEFT]);
+  TEST_ASSERT_GREATER_THAN(framesBefore, rfFrames);
+}
+
+static void test_rf_unknown_code_ignored(){
+  rfCodes.clear();
+  rfCodes.add(0x123456, R_RIGHT, 1);
+  rfEnabled = true;
+  sim::rfSendPt2262(PIN_CC1101_GDO0, 0x654321, 24, 350, 4, 1000);
+  for (int i=0;i<200;i++){ rfService(); delay(PROT_PERIOD_MS); }
+  TEST_ASSERT_FALSE(relayState[R_RIGHT]);
+}
+
+// A fob paired before the decoder is stored as its burst hash: the frame
+// decodes, misses, and the hash of the same burst still finds the relay
+static void test_rf_hash_paired_fob_still_works(){
+  const uint32_t code = 0x3C5A96;
+  RfBurst b; RfFrame f;
+  sim::rfSendPt2262(PIN_CC1101_GDO0, code, 24, 350, 1, 1000);
+  uint32_t hash = 0;
+  for (int i=0;i<100 && !hash;i++){
+    delay(PROT_PERIOD_MS);
+    for (RfEvent ev; (ev = rfCollect(b, f)) != RF_EV_NONE; ) if (ev == RF_EV_BURST && !b.lossy) hash = rfHashBurst(b);
+  }
+  TEST_ASSERT_NOT_EQUAL(0, hash);
+  delay(300);   // past RF_HOLD_MS: the next send is a new press
+
+  rfCodes.clear();
+  rfCodes.add(hash, R_AUX);
+  rfEnabled = true;
+  sim::rfSendPt2262(PIN_CC1101_GDO0, code, 24, 350, 4, 1000);
+  for (int i=0;i<200 && !relayState[R_AUX];i++){ rfService(); delay(PROT_PERIOD_MS); }
+  TEST_ASSERT_TRUE(relayState[R_AUX]);
+  for (int i=0;i<100;i++){ rfService(); delay(PROT_PERIOD_MS); }
+  TEST_ASSERT_TRUE(relayState[R_AUX]);   // repeats are the same press
+}
+
+// Codes of 28+ bits fill the top nibble; the protocol must still separate them
+static void test_rf_code_match_keeps_protocol(){
+  rfCodes.clear();
+  rfCodes.add(0xF0000001, R_LEFT, 1);
+  rfCodes.add(0x12345678, R_AUX);   // burst hash
+  TEST_ASSERT_EQUAL(R_LEFT, rfCodes.match(0xF0000003, 1, 1));
+  TEST_ASSERT_EQUAL(-1, rfCodes.match(0xF0000003, 2, 1));
+  TEST_ASSERT_EQUAL(-1, rfCodes.find(0xF0000001, 2));
+  TEST_ASSERT_EQUAL(R_AUX, rfCodes.match(0x12345678, 0, 1));
+  TEST_ASSERT_EQUAL(-1, rfCodes.match(0x12345679, 0, 1));   // hashes match exactly or not at all
+}
+
+// A code whose home slot in RfCodeTable is h
+static uint32_t rfCodeHomedAt(uint8_t h, uint32_t from){
+  while ((uint8_t)((from * 2654435761u) >> 26) != h) from++;
+  return from;
+}
+
+// Evicting the oldest fob backward-shifts a probe chain that wraps past the
+// last slot; every survivor must still be found
+static void test_rf_code_evict_across_wrap(){
+  uint32_t a = rfCodeHomedAt(63, 1);
+  uint32_t b = rfCodeHomedAt(63, a + 1);
+  uint32_t f = rfCodeHomedAt(1, 1);
+  uint32_t c = rfCodeHomedAt(63, b + 1);
+  uint32_t d = rfCodeHomedAt(0, 1);
+  uint32_t e = rfCodeHomedAt(32, 1);
+  rfCodes.clear();
+  rfCodes.add(a, R_LEFT); rfCodes.add(b, R_LEFT);   // slots 63, 0
+  rfCodes.add(f, R_RIGHT);                          // 1, at home
+  rfCodes.add(c, R_LEFT); rfCodes.add(d, R_LEFT);   // 2, 3
+  rfCodes.add(e, R_LEFT);                           // fifth fob: a goes
+
+  TEST_ASSERT_EQUAL(5, rfCodes.size());
+  TEST_ASSERT_EQUAL(-1, rfCodes.find(a));
+  TEST_ASSERT_EQUAL(R_LEFT, rfCodes.find(b));
+  TEST_ASSERT_EQUAL(R_LEFT, rfCodes.find(c));
+  TEST_ASSERT_EQUAL(R_LEFT, rfCodes.find(d));
+  TEST_ASSERT_EQUAL(R_LEFT, rfCodes.find(e));
+  TEST_ASSERT_EQUAL(R_RIGHT, rfCodes.find(f));
+
+  uint32_t out[RfCodeTable::MAX_PER_RELAY];
+  TEST_ASSERT_EQUAL(4, rfCodes.codesFor(R_LEFT, out));
+  TEST_ASSERT_EQUAL_UINT32(b, out[0]);
+  TEST_ASSERT_EQUAL_UINT32(c, out[1]);
+  TEST_ASSERT_EQUAL_UINT32(d, out[2]);
+  TEST_ASSERT_EQUAL_UINT32(e, out[3]);
+}
+
+// NVS keeps fobs oldest first with their protocols, so after a reboot the
+// next fob still evicts the oldest one
+static void test_rf_codes_reload_keeps_order(){
+  rfCodes.clear();
+  for (uint32_t k=1;k<=5;k++) rfCodes.add(0xF0000000 | k, R_BRAKE, k == 3 ? 0 : 2);
+  uint32_t before[RfCodeTable::MAX_PER_RELAY]; uint8_t protoBefore[RfCodeTable::MAX_PER_RELAY];
+  TEST_ASSERT_EQUAL(4, rfCodes.codesFor(R_BRAKE, before, protoBefore));
+  rfCodesSave(R_BRAKE);
+
+  rfCodesLoad();
+  uint32_t after[RfCodeTable::MAX_PER_RELAY]; uint8_t protoAfter[RfCodeTable::MAX_PER_RELAY];
+  TEST_ASSERT_EQUAL(4, rfCodes.codesFor(R_BRAKE, after, protoAfter));
+  for (int k=0;k<4;k++){
+    TEST_ASSERT_EQUAL_UINT32(before[k], after[k]);
+    TEST_ASSERT_EQUAL_UINT8(protoBefore[k], protoAfter[k]);
+  }
+  TEST_ASSERT_EQUAL(R_BRAKE, rfCodes.find(0xF0000003));      // the hash kept protocol 0
+
+  rfCodes.add(0xF0000006, R_BRAKE, 2);
+  TEST_ASSERT_EQUAL(-1, rfCodes.find(before[0], protoBefore[0]));
+  TEST_ASSERT_EQUAL(R_BRAKE, rfCodes.find(before[1], protoBefore[1]));
+
+  rfCodes.clear();
+  rfCodesSave(R_BRAKE);
+}
+
+static void test_latency_hist_and_worst_stall(){
+  LatencyHist h;
+  for (int i=0;i<98;i++) h.record(15);   // <20 us bucket
+  h.record(3000);
+  h.record(250000);
+  TEST_ASSERT_EQUAL(100, h.count());
+  TEST_ASSERT_EQUAL(20, h.percentileUs(50));
+  TEST_ASSERT_EQUAL(5000, h.percentileUs(99));
+  TEST_ASSERT_EQUAL(250000, h.percentileUs(100));   // capped at the worst sample
+
+  latClear();
+  delay(150);
+  latTime(LP_LVP, lvpService);
+  TEST_ASSERT_EQUAL(1, latHist[LP_LVP].count());
+  TEST_ASSERT_EQUAL(LP_LVP, latWorst.probe);
+  latRecord(LP_RF, 40000);
+  latRecord(LP_UI_LOOP, 900000);                    // loops and modals are not service stalls
+  latRecord(LP_OTA, 5000000);
+  TEST_ASSERT_EQUAL(LP_RF, latWorst.probe);
+  TEST_ASSERT_EQUAL(40000, latWorst.us);
+}
+
+// Quadrature, one transition every 150 us: far faster than any UI pass
+static void spinEncoder(int detents){
+  static const uint8_t CW[4]  = {2, 0, 1, 3};   // (A<<1)|B from rest at 11 (pull-ups)
+  static const uint8_t CCW[4] = {1, 0, 2, 3};
+  for (int d=0; d<abs(detents); d++)
+    for (int q=0;q<4;q++){
+      uint8_t s = detents > 0 ? CW[q] : CCW[q];
+      sim::setPin(PIN_ENC_A, s >> 1);
+      sim::setPin(PIN_ENC_B, s & 1);
+      delayMicroseconds(150);
+    }
+}
+
+static void test_encoder_fast_spin_keeps_every_detent(){
+  sim::setPin(PIN_ENC_A, 1); sim::setPin(PIN_ENC_B, 1);
+  (void)readEncoderStep();
+  spinEncoder(7);
+  spinEncoder(-2);
+  TEST_ASSERT_EQUAL(5, readEncoderStep());
+  TEST_ASSERT_EQUAL(0, readEncoderStep());
+}
+
+static void test_button_bounce_is_one_press(){
+  while (readOkPressed()) {}
+  for (int i=0;i<7;i++){ sim::setPin(PIN_ENC_OK, i & 1); delayMicroseconds(300); }   // ends low = pressed
+  TEST_ASSERT_FALSE(readOkPressed());      // still settling
+  delay(20);
+  TEST_ASSERT_TRUE(okIsDown());
+  TEST_ASSERT_TRUE(readOkPressed());
+  TEST_ASSERT_FALSE(readOkPressed());
+  sim::setPin(PIN_ENC_OK, 1);
+  delay(20);
+  TEST_ASSERT_FALSE(okIsDown());
+  TEST_ASSERT_FALSE(readOkPressed());
+}
+
+// Detent chatter while moving 3 -> 5 (through 4): one clean event, for 5
+static void test_rotary_bounce_is_one_event(){
+  uint8_t p;
+  while (rotEvtQ.pop(p)) {}
+  sim::setPin(PIN_SW_POS3, 0);
+  delay(30);
+  TEST_ASSERT_TRUE(rotEvtQ.pop(p));
+  TEST_ASSERT_EQUAL(3, p);
+
+  for (int i=0;i<5;i++){ sim::setPin(PIN_SW_POS3, i & 1); delayMicroseconds(700); }
+  sim::setPin(PIN_SW_POS4, 0);   // make-before-break: 3 and 4 both grounded
+  delay(3);
+  sim::setPin(PIN_SW_POS3, 1);
+  delay(3);
+  for (int i=0;i<4;i++){ sim::setPin(PIN_SW_POS4, !(i & 1)); delayMicroseconds(500); }
+  sim::setPin(PIN_SW_POS4, 1);
+  for (int i=0;i<5;i++){ sim::setPin(PIN_SW_POS5, i & 1); delayMicroseconds(900); }
+  TEST_ASSERT_FALSE(rotEvtQ.pop(p));   // nothing settles mid-sweep
+  delay(30);
+  TEST_ASSERT_TRUE(rotEvtQ.pop(p));
+  TEST_ASSERT_EQUAL(5, p);
+  TEST_ASSERT_FALSE(rotEvtQ.pop(p));
+
+  sim::setPin(PIN_SW_POS5, 1);   // back off the switch for the other tests
+  delay(30);
+  TEST_ASSERT_FALSE(rotEvtQ.pop(p));
+}
+
+// Alternating LEFT/RIGHT off the timer: edges land on the anchor grid to the
+// microsecond while the calling task is busy elsewhere, and stop cleanly
+static void test_flasher_alternates_on_timer(){
+  FLASH_STYLE = FS_ALTERNATE; FLASH_PERIOD_MS = 800; FLASH_DUTY_PCT = 50;
+  flashStart(R_LEFT);
+  int64_t t0 = flashAnchorUs;
+  TEST_ASSERT_TRUE(flashMode);
+  TEST_ASSERT_TRUE(sim::pinOut(PIN_RLY_LEFT));
+  TEST_ASSERT_FALSE(sim::pinOut(PIN_RLY_RIGHT));
+  delayMicroseconds(500000);
+  TEST_ASSERT_FALSE(sim::pinOut(PIN_RLY_LEFT));
+  TEST_ASSERT_TRUE(sim::pinOut(PIN_RLY_RIGHT));
+  delayMicroseconds(1250000);    // into the third period: LEFT lit at t0 + 1.6 s
+  TEST_ASSERT_TRUE(sim::pinOut(PIN_RLY_LEFT));
+  TEST_ASSERT_EQUAL(1600000, (long)(sim::pinOutChangedUs(PIN_RLY_LEFT) - t0));
+  TEST_ASSERT_EQUAL(1600000, (long)(sim::pinOutChangedUs(PIN_RLY_RIGHT) - t0));
+
+  flashStop();
+  TEST_ASSERT_FALSE(flashMode);
+  delay(1000);
+  TEST_ASSERT_FALSE(sim::pinOut(PIN_RLY_LEFT));
+  TEST_ASSERT_FALSE(sim::pinOut(PIN_RLY_RIGHT));
+  FLASH_STYLE = FS_SINGLE;
+}
+
+// A load that shorts mid-flash must not be re-lit by the next edge
+static void test_flasher_stops_on_ocp(){
+  FLASH_STYLE = FS_HAZARD; FLASH_PERIOD_MS = 400; FLASH_DUTY_PCT = 50;
+  flashStart(R_RIGHT);
+  TEST_ASSERT_TRUE(sim::pinOut(PIN_RLY_LEFT));
+  TEST_ASSERT_TRUE(sim::pinOut(PIN_RLY_RIGHT));
+  sim::setLoad(PIN_RLY_LEFT, SHORT);
+  delay(60);                      // ALERT ISR has dropped both
+  TEST_ASSERT_FALSE(sim::pinOut(PIN_RLY_RIGHT));
+  delay(400);                     // the next edge sees the latch and stops the flasher
+  TEST_ASSERT_FALSE(flashMode);
+  delay(1000);
+  TEST_ASSERT_FALSE(sim::pinOut(PIN_RLY_LEFT));
+  TEST_ASSERT_FALSE(sim::pinOut(PIN_RLY_RIGHT));
+  TEST_ASSERT_EQUAL(1, ocpConsume());
+  FLASH_STYLE = FS_SINGLE;
+}
+
+static const uint8_t LIGHTS = (1u << R_TAIL) | (1u << R_MARKER) | (1u << R_BRAKE);
+
+static void test_engage_set_staggers_light_set(){
+  uint64_t t0 = sim::nowUs();
+  TEST_ASSERT_EQUAL(LIGHTS, engageSet(LIGHTS));
+  uint32_t coldUs = (uint32_t)(sim::nowUs() - t0);
+  TEST_ASSERT_TRUE(sim::pinOut(PIN_RLY_TAIL) && sim::pinOut(PIN_RLY_MARKER) && sim::pinOut(PIN_RLY_BRAKE));
+  TEST_ASSERT_EQUAL(0, ocpConsume());
+  for (uint8_t k=0;k<engageN;k++) TEST_ASSERT_EQUAL(EG_OK, engageSteps[k].status);
+
+  // Second time round every channel is cached: closes on current headroom alone
+  relayOffAll();
+  delay(50);
+  t0 = sim::nowUs();
+  TEST_ASSERT_EQUAL(LIGHTS, engageSet(LIGHTS));
+  uint32_t warmUs = (uint32_t)(sim::nowUs() - t0);
+  TEST_ASSERT_EQUAL(0, ocpConsume());
+  TEST_ASSERT_LESS_THAN(coldUs, warmUs);
+  TEST_ASSERT_TRUE(engageSteps[0].cached);
+}
+
+static void test_engage_set_reports_open_channel(){
+  sim::setLoad(PIN_RLY_MARKER, OPEN);
+  uint8_t on = engageSet(LIGHTS);
+  TEST_ASSERT_EQUAL((1u << R_TAIL) | (1u << R_BRAKE), on);
+  TEST_ASSERT_FALSE(sim::pinOut(PIN_RLY_MARKER));
+  UiEvt e;
+  TEST_ASSERT_TRUE(nextFault(e));
+  TEST_ASSERT_EQUAL(FAULT_OPEN, e.code);
+  TEST_ASSERT_EQUAL(R_MARKER, e.relay);
+}
+
+// Three 8 A loads against an 18 A settled budget: the third never closes
+static void test_engage_set_stops_at_budget(){
+  const sim::Load BIG = {sim::LOAD_LAMP, 8.0f, 20.0f, 4000};
+  sim::setLoad(PIN_RLY_TAIL, BIG); sim::setLoad(PIN_RLY_MARKER, BIG); sim::setLoad(PIN_RLY_BRAKE, BIG);
+  uint8_t on = engageSet(LIGHTS);
+  uint8_t n = 0;
+  for (int i=0;i<R_COUNT;i++) if (on & (1u << i)) n++;
+  TEST_ASSERT_EQUAL(2, n);
+  TEST_ASSERT_EQUAL(EG_BUDGET, engageSteps[2].status);
+  TEST_ASSERT_EQUAL(0, ocpConsume());
+  UiEvt e;
+  TEST_ASSERT_FALSE(nextFault(e));
+}
+
+// ---- OTA over the sim link, on its own low-priority task like netTask
+static std::string otaImage(size_t n, uint32_t seed){
+  std::string img(n, '\0');
+  for (size_t i=0;i<n;i++){ seed = seed * 1103515245u + 12345u; img[i] = (char)(seed >> 16); }
+  img[0] = (char)0xE9;   // app image magic, checked by Update
+  return img;
+}
+
+static volatile bool otaBusy = false;
+static esp_err_t     otaResult = ESP_FAIL;
+static void otaTestTask(void*){ otaResult = runGithubOta(); otaBusy = false; vTaskDelete(nullptr); }
+static void otaStart(){
+  otaBusy = true;
+  otaCancel = false;
+  xTaskCreatePinnedToCore(otaTestTask, "ota", 8192, nullptr, PRIO_NET, nullptr, CORE_NET);
+}
+
+static void test_ota_streams_while_protection_trips(){
+  std::string img = otaImage(200 * 1024, 7);
+  sim::httpClearRoutes(); sim::otaReset();
+  sim::httpServe(OTA_LATEST_ASSET_URL, img);
+  sim::wifiLink(true, 100000);
+  otaStart();
+  relayOn(R_MARKER);
+  while (otaProg.stage != OTA_DOWNLOAD || otaProg.done < img.size() / 2) delay(10);
+  TEST_ASSERT_TRUE(otaBusy);
+
+  // A short mid-download still trips within a conversion or two
+  sim::setLoad(PIN_RLY_MARKER, SHORT);
+  uint64_t tFault = sim::nowUs();
+  while (sim::pinOut(PIN_RLY_MARKER)) delay(1);
+  TEST_ASSERT_LESS_THAN(2 * INA226::conversionUs() + 1000, (uint32_t)(sim::nowUs() - tFault));
+  TEST_ASSERT_EQUAL(1, ocpConsume());
+
+  while (otaBusy) delay(10);
+  sim::wifiLink(false);
+  TEST_ASSERT_EQUAL(ESP_OK, otaResult);
+  TEST_ASSERT_EQUAL(OTA_DONE, otaProg.stage.load());
+  TEST_ASSERT_TRUE(sim::otaBootSwitched());
+  TEST_ASSERT_TRUE(std::string(sim::otaSlot().begin(), sim::otaSlot().end()) == img);
+}
+
+static void test_ota_cancel_stops_download(){
+  std::string img = otaImage(300 * 1024, 11);
+  sim::httpClearRoutes(); sim::otaReset();
+  sim::httpServe(OTA_LATEST_ASSET_URL, img);
+  sim::wifiLink(true, 100000);
+  otaStart();
+  while (otaProg.stage != OTA_DOWNLOAD || otaProg.done < 64 * 1024) delay(10);
+  otaCancel = true;
+  while (otaBusy) delay(10);
+  sim::wifiLink(false);
+  TEST_ASSERT_EQUAL(OTA_ERR_CANCELLED, otaResult);
+  TEST_ASSERT_EQUAL(OTA_FAILED, otaProg.stage.load());
+  TEST_ASSERT_FALSE(sim::otaBootSwitched());
+  TEST_ASSERT_LESS_THAN(img.size() / 2, (uint32_t)sim::httpBodyBytes());
+}
+
+static std::string manifestFor(const char* version, const std::string& img, bool corruptSha = false){
+  Sha256 h; uint8_t d[Sha256::DIGEST]; char hex[2 * Sha256::DIGEST + 1];
+  h.update((const uint8_t*)img.data(), img.size());
+  h.finish(d);
+  if (corruptSha) d[5] ^= 0x40;
+  Sha256::toHex(d, hex);
+  char json[200];
+  snprintf(json, sizeof(json), "{\"version\": \"%s\", \"size\": %u,\n \"sha256\": \"%s\"}", version, (unsigned)img.size(), hex);
+  return json;
+}
+
+static void test_sha256_and_manifest_parse(){
+  Sha256 h; uint8_t d[Sha256::DIGEST]; char hex[2 * Sha256::DIGEST + 1];
+  h.update((const uint8_t*)"ab", 2); h.update((const uint8_t*)"c", 1);
+  h.finish(d); Sha256::toHex(d, hex);
+  TEST_ASSERT_EQUAL_STRING("ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", hex);
+
+  OtaManifest m;
+  std::string j = manifestFor("1.2.3", "xyz");
+  TEST_ASSERT_TRUE(otaManifestParse(j.data(), j.size(), m));
+  TEST_ASSERT_EQUAL_STRING("1.2.3", m.version);
+  TEST_ASSERT_EQUAL(3, m.size);
+  TEST_ASSERT_TRUE(m.hasSha);
+  const char* bad = "{\"version\":\"1.2.3\",\"size\":3,\"sha256\":\"abc\"}";
+  TEST_ASSERT_FALSE(otaManifestParse(bad, strlen(bad), m));
+  const char* noSize = "{\"version\":\"1.2.3\"}";
+  TEST_ASSERT_FALSE(otaManifestParse(noSize, strlen(noSize), m));
+}
+
+// Manifest naming this build: no image bytes move, and the next check is a 304
+static void test_ota_check_skips_current_release(){
+  std::string img = otaImage(100 * 1024, 3);
+  std::string man = manifestFor(FW_VERSION, img);
+  static int manifestGets, notModified, assetGets;
+  manifestGets = notModified = assetGets = 0;
+  sim::httpClearRoutes(); sim::otaReset();
+  sim::httpRoute(OTA_MANIFEST_URL, [man](const sim::HttpRequest& rq){
+    manifestGets++;
+    sim::HttpResponse r;
+    r.headers = {{"ETag", "\"m-1\""}};
+    if (rq.header("if-none-match") == "\"m-1\""){ notModified++; r.status = HTTP_CODE_NOT_MODIFIED; }
+    else r.body = man;
+    return r;
+  });
+  sim::httpRoute(OTA_LATEST_ASSET_URL, [img](const sim::HttpRequest&){ assetGets++; sim::HttpResponse r; r.body = img; return r; });
+  sim::wifiLink(true, 100000);
+  prefs.remove(KEY_OTA_ETAG);
+
+  TEST_ASSERT_EQUAL(OTA_UP_TO_DATE, runGithubOta());
+  TEST_ASSERT_EQUAL(OTA_UP_TO_DATE, runGithubOta());
+  sim::wifiLink(false);
+  TEST_ASSERT_EQUAL(2, manifestGets);
+  TEST_ASSERT_EQUAL(1, notModified);
+  TEST_ASSERT_EQUAL(0, assetGets);
+  TEST_ASSERT_LESS_THAN(256, (uint32_t)sim::httpBodyBytes());
+  TEST_ASSERT_FALSE(sim::otaBootSwitched());
+}
+
+static void test_ota_new_release_checked_against_manifest(){
+  std::string img = otaImage(100 * 1024, 5);
+  sim::httpClearRoutes(); sim::otaReset();
+  sim::httpServe(OTA_MANIFEST_URL, manifestFor("9.9.9", img, true));
+  sim::httpServe(OTA_LATEST_ASSET_URL, img);
+  sim::wifiLink(true, 100000);
+  TEST_ASSERT_EQUAL(ESP_ERR_INVALID_CRC, runGithubOta());
+  TEST_ASSERT_FALSE(sim::otaBootSwitched());
+
+  sim::httpServe(OTA_MANIFEST_URL, manifestFor("9.9.9", img));
+  TEST_ASSERT_EQUAL(ESP_OK, runGithubOta());
+  sim::wifiLink(false);
+  TEST_ASSERT_TRUE(sim::otaBootSwitched());
+}
+
+// Code-like image: words from a small vocabulary with some noise, so it
+// compresses about like a real app image does
+static std::string otaCodeImage(size_t n, uint32_t seed){
+  uint32_t vocab[64];
+  for (auto& w : vocab){ seed = seed * 1103515245u + 12345u; w = seed; }
+  std::string img(n, '\0');
+  for (size_t i=0;i+4<=n;i+=4){
+    seed = seed * 1103515245u + 12345u;
+    uint32_t w = (seed >> 28) < 3 ? seed * 2654435761u : vocab[(seed >> 16) & 63];
+    memcpy(&img[i], &w, 4);
+  }
+  img[0] = (char)0xE9;
+  return img;
+}
+
+static std::string gzipTl(const std::string& raw){
+  z_stream z{};
+  deflateInit2(&z, 9, Z_DEFLATED, -Inflater::WINDOW_BITS, 9, Z_DEFAULT_STRATEGY);
+  std::string body(deflateBound(&z, raw.size()), '\0');
+  z.next_in = (Bytef*)raw.data(); z.avail_in = raw.size();
+  z.next_out = (Bytef*)&body[0]; z.avail_out = body.size();
+  deflate(&z, Z_FINISH);
+  body.resize(z.total_out);
+  deflateEnd(&z);
+  uint32_t n = raw.size(), crc = crc32Update(0, (const uint8_t*)raw.data(), raw.size());
+  const uint8_t hdr[] = {0x1F, 0x8B, 8, 0x04, 0, 0, 0, 0, 2, 0xFF, 9, 0, 'T', 'L', 5, 0,
+                         (uint8_t)n, (uint8_t)(n >> 8), (uint8_t)(n >> 16), (uint8_t)(n >> 24), Inflater::WINDOW_BITS};
+  std::string gz((const char*)hdr, sizeof(hdr));
+  gz += body;
+  for (int i=0;i<4;i++) gz += (char)(crc >> (8 * i));
+  for (int i=0;i<4;i++) gz += (char)(n >> (8 * i));
+  return gz;
+}
+
+static void test_ota_gzip_asset_cuts_transfer(){
+  std::string img = otaCodeImage(256 * 1024, 21), gz = gzipTl(img);
+  sim::httpClearRoutes(); sim::otaReset();
+  sim::httpServe(OTA_MANIFEST_URL, manifestFor("9.9.9", img));
+  sim::httpServe(OTA_LATEST_ASSET_URL, img);
+  sim::wifiLink(true, 100000);
+  uint64_t t0 = sim::nowUs();
+  TEST_ASSERT_EQUAL(ESP_OK, runGithubOta());
+  uint32_t rawUs = (uint32_t)(sim::nowUs() - t0), rawBytes = (uint32_t)sim::httpBodyBytes();
+
+  sim::httpClearRoutes(); sim::otaReset();
+  sim::httpServe(OTA_MANIFEST_URL, manifestFor("9.9.9", img));
+  sim::httpServe(OTA_LATEST_ASSET_URL, img);
+  sim::httpServe(OTA_GZ_ASSET_URL, gz);
+  t0 = sim::nowUs();
+  TEST_ASSERT_EQUAL(ESP_OK, runGithubOta());
+  uint32_t gzUs = (uint32_t)(sim::nowUs() - t0), gzBytes = (uint32_t)sim::httpBodyBytes();
+  TEST_ASSERT_TRUE(sim::otaBootSwitched());
+  TEST_ASSERT_TRUE(std::string(sim::otaSlot().begin(), sim::otaSlot().end()) == img);
+  TEST_ASSERT_LESS_THAN(rawBytes * 3 / 4, gzBytes);
+  TEST_ASSERT_LESS_THAN(rawUs * 3 / 4, gzUs);
+
+  // One flipped bit mid-stream never reaches the boot switch
+  gz[gz.size() / 2] ^= 0x10;
+  sim::httpServe(OTA_GZ_ASSET_URL, gz);
+  sim::otaReset();
+  esp_err_t r = runGithubOta();
+  sim::wifiLink(false);
+  TEST_ASSERT_TRUE(r == ESP_ERR_INVALID_RESPONSE || r == ESP_ERR_INVALID_CRC);
+  TEST_ASSERT_FALSE(sim::otaBootSwitched());
+}
+
+// Patch for the running image: one add up to the insert, the insert, then an
+// add whose diff bytes carry the changed words (tools/ota_delta.py's records)
+static std::string deltaPatch(const std::string& oldImg, const std::string& newImg, size_t at, size_t ins){
+  auto u32 = [](std::string& o, uint32_t v){ for (int i=0;i<4;i++) o += (char)(v >> (8 * i)); };
+  auto sha = [](const std::string& b){
+    Sha256 h; uint8_t d[Sha256::DIGEST];
+    h.update((const uint8_t*)b.data(), b.size()); h.finish(d);
+    return std::string((const char*)d, sizeof(d));
+  };
+  std::string p = "TLD1";
+  u32(p, oldImg.size()); u32(p, newImg.size());
+  p += sha(oldImg) + sha(newImg);
+  u32(p, at); u32(p, ins); u32(p, 0);
+  p += std::string(at, '\0') + newImg.substr(at, ins);
+  size_t rest = newImg.size() - at - ins;
+  u32(p, rest); u32(p, 0); u32(p, 0);
+  for (size_t i=0;i<rest;i++) p += (char)(newImg[at + ins + i] - oldImg[at + i]);
+  return p;
+}
+
+static void test_ota_delta_patches_running_image(){
+  std::string oldImg = otaCodeImage(256 * 1024, 31), newImg = oldImg;
+  newImg.insert(100 * 1024, std::string(64, 'N'));
+  for (size_t i=120 * 1024;i<newImg.size();i+=1500) newImg[i]++;   // moved code: a few words differ
+  std::string gz = gzipTl(newImg), patch = gzipTl(deltaPatch(oldImg, newImg, 100 * 1024, 64));
+  uint8_t d[Sha256::DIGEST]; char hex[2 * Sha256::DIGEST + 1];
+  Sha256 h; h.update((const uint8_t*)oldImg.data(), oldImg.size()); h.finish(d);
+  Sha256::toHex(d, hex); hex[16] = 0;
+  std::string deltaUrl = std::string(OTA_DELTA_URL_PREFIX) + hex + ".gz";
+
+  sim::runningImage(std::vector<uint8_t>(oldImg.begin(), oldImg.end()));
+  sim::httpClearRoutes(); sim::otaReset();
+  sim::httpServe(OTA_MANIFEST_URL, manifestFor("9.9.9", newImg));
+  sim::httpServe(OTA_GZ_ASSET_URL, gz);
+  sim::httpServe(deltaUrl, patch);
+  sim::wifiLink(true, 100000);
+  TEST_ASSERT_EQUAL(ESP_OK, runGithubOta());
+  TEST_ASSERT_EQUAL(OTA_SRC_DELTA, otaProg.source.load());
+  TEST_ASSERT_TRUE(std::string(sim::otaSlot().begin(), sim::otaSlot().end()) == newImg);
+  TEST_ASSERT_LESS_THAN(gz.size() / 10, (uint32_t)sim::httpBodyBytes());
+
+  // A patch against some other image stops at its header; the full image still lands
+  std::string other = otaCodeImage(256 * 1024, 33);
+  sim::httpServe(deltaUrl, gzipTl(deltaPatch(other, newImg, 100 * 1024, 64)));
+  sim::otaReset();
+  TEST_ASSERT_EQUAL(ESP_OK, runGithubOta());
+  TEST_ASSERT_EQUAL(OTA_SRC_GZ, otaProg.source.load());
+  TEST_ASSERT_TRUE(std::string(sim::otaSlot().begin(), sim::otaSlot().end()) == newImg);
+
+  // No patch for this image at all: straight to the full image
+  sim::httpClearRoutes(); sim::otaReset();
+  sim::httpServe(OTA_MANIFEST_URL, manifestFor("9.9.9", newImg));
+  sim::httpServe(OTA_GZ_ASSET_URL, gz);
+  TEST_ASSERT_EQUAL(ESP_OK, runGithubOta());
+  sim::wifiLink(false);
+  TEST_ASSERT_EQUAL(OTA_SRC_GZ, otaProg.source.load());
+  TEST_ASSERT_TRUE(sim::otaBootSwitched());
+  sim::runningImage({});
+}
+
+// Flash erase and program overlap the download: the update takes about as
+// long as the wire does, and the stage stats account for the image
+static void test_ota_pipeline_hides_flash_time(){
+  std::string img = otaImage(256 * 1024, 41);
+  sim::httpClearRoutes(); sim::otaReset();
+  sim::httpServe(OTA_MANIFEST_URL, manifestFor("9.9.9", img));
+  sim::httpServe(OTA_LATEST_ASSET_URL, img);
+  sim::wifiLink(true, 100000);
+  TEST_ASSERT_EQUAL(ESP_OK, runGithubOta());
+  sim::wifiLink(false);
+  TEST_ASSERT_TRUE(std::string(sim::otaSlot().begin(), sim::otaSlot().end()) == img);
+
+  const OtaStats& t = otaStats;
+  uint32_t wireUs = (uint32_t)(img.size() * 1000000ull / 100000);
+  TEST_ASSERT_EQUAL(img.size(), t.netBytes);
+  TEST_ASSERT_EQUAL(img.size(), t.shaBytes);
+  TEST_ASSERT_EQUAL(img.size(), t.programBytes);
+  TEST_ASSERT_GREATER_OR_EQUAL(img.size(), t.eraseBytes);
+  TEST_ASSERT_GREATER_THAN(wireUs / 4, t.eraseUs + t.programUs);
+  TEST_ASSERT_LESS_THAN(wireUs + wireUs / 20, t.totalUs);
+}
+
+int main(int, char**){
+  UNITY_BEGIN();
+  RUN_TEST(test_buzzer_queued_beeps_stay_separate);
+  RUN_TEST(test_pulse_lamp_engages);
+  RUN_TEST(test_pulse_samples_are_distinct_conversions);
+  RUN_TEST(test_pulse_open_faults);
+  RUN_TEST(test_pulse_short_faults);
+  RUN_TEST(test_cached_engage_skips_pulse);
+  RUN_TEST(test_cached_engage_open_beside_lit_channel);
+  RUN_TEST(test_fault_survives_status_churn);
+  RUN_TEST(test_ocp_isr_drops_relays);
+  RUN_TEST(test_ocp_level_trips_without_edge);
+  RUN_TEST(test_ocp_limit_set_by_sampler);
+  RUN_TEST(test_lvp_trips_and_releases);
+  RUN_TEST(test_fb_flush_leaves_core_free);
+  RUN_TEST(test_rf_frame_engages_learned_relay);
+  RUN_TEST(test_rf_unknown_code_ignored);
+  RUN_TEST(test_rf_hash_paired_fob_still_works);
+  RUN_TEST(test_rf_code_match_keeps_protocol);
+  RUN_TEST(test_rf_code_evict_across_wrap);
+  RUN_TEST(test_rf_codes_reload_keeps_order);
+  RUN_TEST(test_latency_hist_and_worst_stall);
+  RUN_TEST(test_encoder_fast_spin_keeps_every_detent);
+  RUN_TEST(test_button_bounce_is_one_press);
+  RUN_TEST(test_rotary_bounce_is_one_event);
+  RUN_TEST(test_flasher_alternates_on_timer);
+  RUN_TEST(test_flasher_stops_on_ocp);
+  RUN_TEST(test_engage_set_staggers_light_set);
+  RUN_TEST(test_engage_set_reports_open_channel);
+  RUN_TEST(test_engage_set_stops_at_budget);
+  RUN_TEST(test_ota_streams_while_protection_trips);
+  RUN_TEST(test_ota_cancel_stops_download);
+  RUN_TEST(test_sha256_and_manifest_parse);
+  RUN_TEST(test_ota_check_skips_current_release);
+  RUN_TEST(test_ota_new_release_checked_against_manifest);
+  RUN_TEST(test_ota_gzip_asset_cuts_transfer);
+  RUN_TEST(test_ota_delta_patches_running_image);
+  RUN_TEST(test_ota_pipeline_hides_flash_time);
+  return UNITY_END();
+}
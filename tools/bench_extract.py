@@ -0,0 +1,27 @@
+#!/usr/bin/env python3
+"""Pull the BENCH_JSON line out of a benchmark log (serial or host) into a file.
+
+    pio test -e esp32s3-bench -v | python tools/bench_extract.py bench-esp32s3.json
+"""
+import json
+import sys
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.exit("usage: bench_extract.py OUT.json < log")
+    found = None
+    for line in sys.stdin:
+        sys.stdout.write(line)
+        i = line.find("BENCH_JSON ")
+        if i >= 0:
+            found = json.loads(line[i + len("BENCH_JSON "):])
+    if found is None:
+        sys.exit("bench_extract: no BENCH_JSON line in the log")
+    with open(sys.argv[1], "w") as f:
+        json.dump(found, f, indent=2)
+        f.write("\n")
+
+
+if __name__ == "__main__":
+    main()
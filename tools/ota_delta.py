@@ -0,0 +1,99 @@
+#!/usr/bin/env python3
+"""Build a delta patch that turns one released image into the next.
+
+    python tools/ota_delta.py OLD/firmware.bin NEW/firmware.bin OUTDIR
+
+Writes OUTDIR/delta-<first 16 hex digits of sha256(OLD)>.gz. The box hashes
+its running image and asks for exactly that name, so a release can carry
+patches from as many earlier releases as are worth keeping; anything
+without one takes the full image.
+
+The format (see src/delta_patch.h) is bsdiff's: approximate matches against
+the old image stored as byte-wise differences, which are mostly zero when
+code only moved, plus verbatim inserts. Unlike bsdiff the records are
+interleaved so the box applies them in one forward pass as they arrive, and
+the whole stream is gzipped with the 4 KB window of tools/ota_pack.py.
+"""
+import hashlib
+import os
+import struct
+import sys
+
+sys.path.insert(0, os.path.dirname(os.path.abspath(__file__)))
+from ota_pack import pack  # noqa: E402
+
+SEED = 8            # exact bytes that start a match
+GIVE_UP = 64        # stop extending after this many bytes without a better score
+
+
+def extend(old, new, o, n, step, limit):
+    """bsdiff's approximate extension: the length maximising 2*matches - length."""
+    s = best = length = 0
+    for k in range(1, limit + 1):
+        if old[o] == new[n]:
+            s += 1
+        o += step
+        n += step
+        if 2 * s - k > best:
+            best, length = 2 * s - k, k
+        elif k - length > GIVE_UP:
+            break
+    return length
+
+
+def segments(old, new):
+    """(newStart, oldStart, length) runs of new that are close to old, in order."""
+    index = {}
+    for j in range(len(old) - SEED + 1):
+        index.setdefault(old[j:j + SEED], j)
+    segs = []
+    i = last_new = last_old = 0
+    while i + SEED <= len(new):
+        key = new[i:i + SEED]
+        j = last_old + (i - last_new)       # same shift as the last match first
+        if old[j:j + SEED] != key:
+            j = index.get(key)
+            if j is None:
+                i += 1
+                continue
+        back = extend(old, new, j - 1, i - 1, -1, min(i - last_new, j))
+        fwd = extend(old, new, j, i, 1, min(len(new) - i, len(old) - j))
+        segs.append((i - back, j - back, back + fwd))
+        last_new, last_old = i + fwd, j + fwd
+        i = last_new
+    return segs
+
+
+def delta(old, new):
+    out = bytearray(b"TLD1")
+    out += struct.pack("<II", len(old), len(new))
+    out += hashlib.sha256(old).digest() + hashlib.sha256(new).digest()
+    segs = [(0, 0, 0)] + segments(old, new)
+    for k, (ns, os_, length) in enumerate(segs):
+        nxt_new, nxt_old = segs[k + 1][:2] if k + 1 < len(segs) else (len(new), os_ + length)
+        extra = new[ns + length:nxt_new]
+        out += struct.pack("<IIi", length, len(extra), nxt_old - (os_ + length))
+        out += bytes((new[ns + q] - old[os_ + q]) & 0xFF for q in range(length))
+        out += extra
+    return bytes(out)
+
+
+def main():
+    if len(sys.argv) != 4:
+        sys.exit("usage: ota_delta.py OLD.bin NEW.bin OUTDIR")
+    with open(sys.argv[1], "rb") as f:
+        old = f.read()
+    with open(sys.argv[2], "rb") as f:
+        new = f.read()
+    for name, img in ((sys.argv[1], old), (sys.argv[2], new)):
+        if not img or img[0] != 0xE9:
+            sys.exit("ota_delta: %s is not an ESP32 app image" % name)
+    gz = pack(delta(old, new))
+    path = os.path.join(sys.argv[3], "delta-%s.gz" % hashlib.sha256(old).hexdigest()[:16])
+    with open(path, "wb") as f:
+        f.write(gz)
+    print("%s: %d -> %d bytes (%.1f%% of the new image)" % (path, len(new), len(gz), 100.0 * len(gz) / len(new)))
+
+
+if __name__ == "__main__":
+    main()
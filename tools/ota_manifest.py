@@ -0,0 +1,29 @@
+#!/usr/bin/env python3
+"""Write the release manifest the firmware checks before downloading an image.
+
+    python tools/ota_manifest.py .pio/build/esp32s3-devkitc1-n16/firmware.bin 1.4.0 > firmware.json
+
+Publish firmware.json next to firmware.bin in the release. "version" must
+match the FW_VERSION the image was built with; a box already running that
+version stops after this one small GET.
+"""
+import hashlib
+import json
+import os
+import sys
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit("usage: ota_manifest.py FIRMWARE.bin VERSION > firmware.json")
+    path, version = sys.argv[1], sys.argv[2]
+    with open(path, "rb") as f:
+        data = f.read()
+    if not data or data[0] != 0xE9:
+        sys.exit("ota_manifest: %s is not an ESP32 app image" % path)
+    json.dump({"version": version, "size": len(data), "sha256": hashlib.sha256(data).hexdigest()}, sys.stdout)
+    sys.stdout.write("\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,43 @@
+#!/usr/bin/env python3
+"""Compress a firmware image into the gzip asset the OTA path streams.
+
+    python tools/ota_pack.py .pio/build/esp32s3-devkitc1-n16/firmware.bin firmware.bin.gz
+
+The DEFLATE window is capped at 4 KB (Inflater::WINDOW_BITS in
+src/inflate.h) so the box inflates with one 4 KB ring and never buffers the
+image. A "TL" extra subfield carries the raw size and window bits so the OTA
+slot can be opened before the first byte inflates. The output is still a
+plain gzip file: `gunzip -t` checks it. Publish it next to firmware.bin; the
+manifest's size and sha256 stay those of the raw image.
+"""
+import struct
+import sys
+import zlib
+
+WINDOW_BITS = 12
+
+
+def pack(raw):
+    c = zlib.compressobj(9, zlib.DEFLATED, -WINDOW_BITS, 9)
+    body = c.compress(raw) + c.flush()
+    extra = b"TL" + struct.pack("<HIB", 5, len(raw), WINDOW_BITS)
+    header = b"\x1f\x8b\x08\x04" + struct.pack("<I", 0) + b"\x02\xff" + struct.pack("<H", len(extra)) + extra
+    trailer = struct.pack("<II", zlib.crc32(raw) & 0xFFFFFFFF, len(raw) & 0xFFFFFFFF)
+    return header + body + trailer
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit("usage: ota_pack.py FIRMWARE.bin OUT.gz")
+    with open(sys.argv[1], "rb") as f:
+        raw = f.read()
+    if not raw or raw[0] != 0xE9:
+        sys.exit("ota_pack: %s is not an ESP32 app image" % sys.argv[1])
+    gz = pack(raw)
+    with open(sys.argv[2], "wb") as f:
+        f.write(gz)
+    print("%s: %d -> %d bytes (%.1f%%)" % (sys.argv[2], len(raw), len(gz), 100.0 * len(gz) / len(raw)))
+
+
+if __name__ == "__main__":
+    main()